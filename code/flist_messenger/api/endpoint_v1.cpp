@@ -51,9 +51,9 @@ void Endpoint_v1::TicketRequest::onRequestFinished()
 	std::string response ( respbytes.begin(), respbytes.end() );
 
 	JSONNode respnode = libJSON::parse ( response );
-	JSONNode errnode = respnode.at ( "error" );
-	if (errnode.as_string() != "") {
-		emit failed(QString("server_failure"), QString(errnode.as_string().c_str()));
+	const JSONNode *errnode = respnode.try_at ( "error" );
+	if (errnode && errnode->as_string() != "") {
+		emit failed(QString("server_failure"), QString(errnode->as_string().c_str()));
 		return;
 	}
 
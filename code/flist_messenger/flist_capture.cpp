@@ -0,0 +1,125 @@
+#include "flist_capture.h"
+
+#include <QMutexLocker>
+#include <QList>
+
+namespace {
+	/**
+	The login ticket in an IDN frame is as good as the account's password, and captures are meant to be
+	handed to whoever is looking into a problem, so it is replaced before the frame is recorded.
+	 */
+	QByteArray redactTicket(const QByteArray &frame)
+	{
+		if(!frame.startsWith("IDN ")) {
+			return frame;
+		}
+		int start = frame.indexOf("\"ticket\"");
+		if(start < 0) {
+			return frame;
+		}
+		int colon = frame.indexOf(':', start + 8);
+		start = (colon < 0) ? -1 : frame.indexOf('"', colon);
+		if(start < 0) {
+			return frame;
+		}
+		start++;
+		int end = start;
+		while(end < frame.size() && frame.at(end) != '"') {
+			end += (frame.at(end) == '\\') ? 2 : 1;
+		}
+		QByteArray redacted = frame;
+		redacted.replace(start, qMin(end, frame.size()) - start, "REDACTED");
+		return redacted;
+	}
+}
+
+FCapture::FCapture() :
+	mutex(),
+	file(),
+	clock()
+{
+}
+
+FCapture::~FCapture()
+{
+	file.close();
+}
+
+bool FCapture::open(const QString &filename)
+{
+	QMutexLocker locker(&mutex);
+	file.setFileName(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	clock.start();
+	return true;
+}
+
+void FCapture::close()
+{
+	QMutexLocker locker(&mutex);
+	file.close();
+}
+
+void FCapture::record(char direction, const QString &sessionid, const QByteArray &frame)
+{
+	QMutexLocker locker(&mutex);
+	if(!file.isOpen()) {
+		return;
+	}
+	const QByteArray recorded = (direction == Outbound) ? redactTicket(frame) : frame;
+	QByteArray header = QByteArray::number(clock.elapsed());
+	header += ' ';
+	header += direction;
+	header += ' ';
+	header += QByteArray::number(recorded.size());
+	header += ' ';
+	header += sessionid.toUtf8();
+	header += '\n';
+	file.write(header);
+	file.write(recorded);
+	file.write("\n", 1);
+}
+
+bool FCaptureReader::open(const QString &filename)
+{
+	file.setFileName(filename);
+	if(!file.open(QIODevice::ReadOnly)) {
+		error = file.errorString();
+		return false;
+	}
+	return true;
+}
+
+/**
+Read the next frame. Returns false at the end of the file, or if the file is malformed, in which case
+errorString() says why.
+ */
+bool FCaptureReader::next(FCaptureRecord &record)
+{
+	if(file.atEnd()) {
+		return false;
+	}
+	QByteArray header = file.readLine();
+	if(header.endsWith('\n')) {
+		header.chop(1);
+	}
+	QList<QByteArray> fields = header.split(' ');
+	bool timeok = false, lengthok = false;
+	if(fields.count() >= 3) {
+		record.time = fields[0].toLongLong(&timeok);
+		record.direction = fields[1].isEmpty() ? 0 : fields[1].at(0);
+		int length = fields[2].toInt(&lengthok);
+		if(timeok && lengthok && length >= 0) {
+			//The session id may contain spaces, so it's everything after the third field.
+			record.sessionid = QString::fromUtf8(header.mid(fields[0].size() + fields[1].size() + fields[2].size() + 3));
+			record.frame = file.read(length);
+			if(record.frame.size() == length && file.read(1) == "\n") {
+				return true;
+			}
+		}
+	}
+	error = QString("Malformed capture record at byte %1.").arg(file.pos());
+	return false;
+}
@@ -0,0 +1,65 @@
+#ifndef FLIST_CAPTURE_H
+#define FLIST_CAPTURE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/**
+One frame from a capture file.
+ */
+class FCaptureRecord
+{
+public:
+	FCaptureRecord() : time(0), direction(0), sessionid(), frame() {}
+
+	qint64 time; //< Milliseconds since the capture started.
+	char direction; //< FCapture::Inbound or FCapture::Outbound.
+	QString sessionid;
+	QByteArray frame; //< The raw frame as UTF-8, command included.
+};
+
+/**
+Records the raw frames of every session to a file, so that they can be fed back in with -replay.
+
+Each frame is a header line "<milliseconds> <direction> <length> <session id>" followed by the frame
+itself and a newline. The length is in bytes, so frames may contain anything. Frames are recorded from
+both the GUI thread and the session worker threads. The ticket in an outbound IDN is never recorded.
+ */
+class FCapture
+{
+public:
+	static const char Inbound = '<';
+	static const char Outbound = '>';
+
+	FCapture();
+	~FCapture();
+
+	bool open(const QString &filename);
+	void close();
+	void record(char direction, const QString &sessionid, const QByteArray &frame);
+
+private:
+	QMutex mutex;
+	QFile file;
+	QElapsedTimer clock;
+};
+
+/**
+Reads back a file written by FCapture.
+ */
+class FCaptureReader
+{
+public:
+	bool open(const QString &filename);
+	bool next(FCaptureRecord &record);
+	QString errorString() {return error;}
+
+private:
+	QFile file;
+	QString error;
+};
+
+#endif // FLIST_CAPTURE_H
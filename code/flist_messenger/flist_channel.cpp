@@ -20,27 +20,36 @@ FChannel::FChannel(QObject *parent, FSession *session, QString name, QString tit
 	}
 }
 
+bool FChannel::isCharacterPresent(QString charactername) {
+	return characterlist.contains(session->getNames().find(charactername));
+}
+bool FChannel::isCharacterOperator(QString charactername) {
+	return operatorlist.contains(session->getNames().find(charactername));
+}
+
 void FChannel::addCharacter(QString charactername, bool notify) {
-	QString lowername = charactername.toLower();
-	if(!characterlist.contains(lowername) || characterlist.value(lowername).isEmpty()) {
-		characterlist[lowername] = charactername;
-	}
+	characterlist.insert(session->getNames().intern(charactername));
 	session->account->ui->addChannelCharacter(session, name, charactername, notify);
 }
+void FChannel::addCharacters(QStringList characternames) {
+	FNameTable &names = session->getNames();
+	characterlist.reserve(characterlist.size() + characternames.count());
+	foreach(const QString &charactername, characternames) {
+		characterlist.insert(names.intern(charactername));
+	}
+	session->account->ui->addChannelCharacters(session, name, characternames);
+}
 void FChannel::removeCharacter(QString charactername) {
-	characterlist.remove(charactername.toLower());
+	characterlist.remove(session->getNames().find(charactername));
 	session->account->ui->removeChannelCharacter(session, name, charactername);
 } 
 
 void FChannel::addOperator(QString charactername) {
-	QString lowername = charactername.toLower();
-	if(!operatorlist.contains(lowername) || operatorlist.value(lowername).isEmpty()) {
-		operatorlist[lowername] = charactername;
-	}
+	operatorlist.insert(session->getNames().intern(charactername));
 	session->account->ui->setChannelOperator(session, name, charactername, true);	
 }
 void FChannel::removeOperator(QString charactername) {
-	operatorlist.remove(charactername.toLower());
+	operatorlist.remove(session->getNames().find(charactername));
 	session->account->ui->setChannelOperator(session, name, charactername, false);	
 }
 
@@ -4,8 +4,10 @@
 #include <QObject>
 #include <QString>
 #include <QList>
-#include <QMap>
+#include <QSet>
+#include <QStringList>
 #include "flist_enums.h"
+#include "flist_names.h"
 
 class FSession;
 
@@ -24,12 +26,17 @@ public:
 public:
 	explicit FChannel(QObject *parent, FSession *session, QString name, QString title);
 
-	bool isCharacterPresent(QString charactername) {return characterlist.contains(charactername.toLower());}
-	bool isCharacterOperator(QString charactername) {return operatorlist.contains(charactername.toLower());}
+	bool isCharacterPresent(FCharacterId id) {return characterlist.contains(id);}
+	bool isCharacterPresent(QString charactername);
+	bool isCharacterOperator(FCharacterId id) {return operatorlist.contains(id);}
+	bool isCharacterOperator(QString charactername);
+	/** Add the ID of every character in the channel or operating it to 'ids'. */
+	void collectIds(QSet<FCharacterId> &ids) const {ids.unite(characterlist); ids.unite(operatorlist);}
 	//todo: Figure out a better function name than 'isJoined'.
 	bool isJoined() {return joined;}
 
 	void addCharacter(QString charactername, bool notify);
+	void addCharacters(QStringList characternames);
 	void removeCharacter(QString charactername);
 
 	void addOperator(QString charactername);
@@ -55,8 +62,8 @@ public:
 	QString title; //<Title for this room.
 	QString description; //<Long description for the channel/room.
 private:
-	QMap<QString, QString> characterlist; //<List of all characters within a channel.
-	QMap<QString, QString> operatorlist; //<List of all channel operators.
+	QSet<FCharacterId> characterlist; //<List of all characters within a channel, by their ID in the session's name table.
+	QSet<FCharacterId> operatorlist; //<List of all channel operators, by ID.
 public:
 	bool joined; //<Indicates if this session is currently joined with this channel.
 	ChannelMode mode; //<The mode of the channel.
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <QDir>
 #include <QStringList>
+#include <QSet>
 #include <QSettings>
 #include <QDateTime>
 #include <QApplication>
@@ -96,6 +97,7 @@ FChannelPanel::FChannelPanel (iUserInterface *ui, QString sessionid, QString pan
         typing = TYPING_STATUS_CLEAR;
         typingSelf = TYPING_STATUS_CLEAR;
         input = "";
+        chanowner = 0;
 	loadSettings();
 }
 
@@ -148,6 +150,31 @@ void FChannelPanel::addChar ( FCharacter* character, bool sort_list )
         }
 }
 
+/**
+Add many characters at once without sorting. Duplicates are checked against a set, rather than by
+scanning the list once per character.
+ */
+void FChannelPanel::addChars ( QList<FCharacter*> characters )
+{
+	QSet<FCharacter*> present ( chanChars.begin(), chanChars.end() );
+	chanChars.reserve ( chanChars.count() + characters.count() );
+	foreach ( FCharacter* character, characters )
+	{
+		if ( character == 0 )
+		{
+			FLOG(Ui, Warning, "[BUG] Received null pointer character.");
+			continue;
+		}
+		if ( present.contains ( character ) )
+		{
+			FLOG(Protocol, Warning, "[SERVER BUG] Server gave us a person joining a channel who was already in the channel. " + character->name());
+			continue;
+		}
+		present.insert ( character );
+		chanChars.append ( character );
+	}
+}
+
 void FChannelPanel::remChar ( FCharacter* character )
 {
         if ( chanChars.count ( character ) != 0 )
@@ -204,7 +231,7 @@ bool FChannelPanel::isOp ( FCharacter* character )
                 return false;
         }
 
-	return chanOps.contains(character->name().toLower());
+	return chanOps.contains(character->id());
 }
 
 bool FChannelPanel::isOwner ( FCharacter* character )
@@ -215,7 +242,7 @@ bool FChannelPanel::isOwner ( FCharacter* character )
                 return false;
         }
 
-	return character->name().toLower() == chanowner.toLower();
+	return chanowner != 0 && character->id() == chanowner;
 }
 
 void FChannelPanel::setType ( FChannel::ChannelType type )
@@ -230,24 +257,24 @@ void FChannelPanel::setType ( FChannel::ChannelType type )
         }
 }
 
-void FChannelPanel::setOps ( QStringList& oplist )
+void FChannelPanel::setOps ( const QList<FCharacterId>& oplist )
 {
         chanOps.clear();
 
-	chanowner = (oplist.length() > 0) ? oplist[0] : "";
+	chanowner = (oplist.length() > 0) ? oplist[0] : 0;
 
         for ( int i = 0;i < oplist.length();++i )
         {
-		chanOps[oplist[i].toLower()] = oplist[i];
+		chanOps.insert(oplist[i]);
         }
 }
-void FChannelPanel::addOp(QString &charactername)
+void FChannelPanel::addOp(FCharacterId id)
 {
-	chanOps[charactername.toLower()] = charactername;
+	chanOps.insert(id);
 }
-void FChannelPanel::removeOp(QString &charactername)
+void FChannelPanel::removeOp(FCharacterId id)
 {
-	chanOps.remove(charactername.toLower());
+	chanOps.remove(id);
 }
 
 void FChannelPanel::addLine(QString chanLine, bool log)
@@ -26,6 +26,7 @@
 #include <QList>
 #include <QVector>
 #include <QVectorIterator>
+#include <QSet>
 #include "flist_character.h"
 #include "flist_parser.h"
 #include "../libjson/libJSON.h"
@@ -64,15 +65,16 @@ public:
 	void setTitle ( QString& title );
 	QString& title(){return chanTitle;}
 	void updateButtonColor();
-	void setOps ( QStringList& oplist );
-	void addOp(QString &charactername);
-	void removeOp(QString &charactername);
-	QMap<QString,QString> opList(){return chanOps;}
+	void setOps ( const QList<FCharacterId>& oplist );
+	void addOp(FCharacterId id);
+	void removeOp(FCharacterId id);
+	QSet<FCharacterId> opList(){return chanOps;}
 	void setTyping ( TypingStatus status );
 	TypingStatus getTyping(){return typing;}
 	void setTypingSelf ( TypingStatus status ){typingSelf = status;}
 	TypingStatus getTypingSelf(){return typingSelf;}
 	void addChar ( FCharacter* character, bool sort_list = true );
+	void addChars ( QList<FCharacter*> characters );
 	void remChar ( FCharacter* character );
 	bool hasCharacter(FCharacter* character) {return chanChars.contains(character);}
 	QList<FCharacter*> charList(){return chanChars;}
@@ -119,8 +121,8 @@ private:
 	QString					chanTitle;
 	QString					chanDesc;
 	QList<FCharacter*>  	chanChars;
-	QMap<QString,QString>      	chanOps;
-	QString chanowner;
+	QSet<FCharacterId>      	chanOps;			// By ID in the session's name table.
+	FCharacterId chanowner;
 	FChannel::ChannelType         	chanType;
 	QVector<QString>    	chanLines;
 	quint64					chanLastActivity;
@@ -109,6 +109,7 @@ void FCharacter::initClass()
 
 FCharacter::FCharacter()
 {
+	charId = 0;
 	updateActivityTimer();
 	chatOp = false;
 	charStatus = FCharacter::STATUS_ONLINE;
@@ -116,8 +117,9 @@ FCharacter::FCharacter()
 	isFriend = false;
 }
 
-FCharacter::FCharacter ( QString& name, bool friended )
+FCharacter::FCharacter ( FCharacterId id, const QString& name, bool friended )
 {
+	charId = id;
 	charName = name;
 	updateActivityTimer();
 	chatOp = false;
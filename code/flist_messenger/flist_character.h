@@ -27,6 +27,8 @@
 #include <QIcon>
 #include <time.h>
 
+#include "flist_names.h"
+
 class FCharacter
 {
 
@@ -60,7 +62,7 @@ public:
 	static QString		genderStrings[GENDER_MAX];
 	static QColor		genderColors[GENDER_MAX];
 	FCharacter();
-	FCharacter ( QString& name, bool friended );
+	FCharacter ( FCharacterId id, const QString& name, bool friended );
 	~FCharacter() {}
 
 	void setName ( QString& name );
@@ -68,11 +70,15 @@ public:
 	{
 		return charName;
 	}
+	FCharacterId id()
+	{
+		return charId;
+	}
 
 	void setStatus ( QString& status );
 	characterStatus status()
 	{
-		return charStatus;
+		return ( characterStatus ) charStatus;
 	}
 
 	QString& statusString();
@@ -86,7 +92,7 @@ public:
 	void setGender ( QString& gender );
 	characterGender gender()
 	{
-		return charGender;
+		return ( characterGender ) charGender;
 	}
 
 	QString& genderString();
@@ -113,33 +119,19 @@ public:
 
 	QString getUrl() {return "https://www.f-list.net/c/" + charName + "/";} //todo: HTTP request character encoding. //todo: Get server address from FServer?
 
-	void clearCustomKinkData() {customkinkdatakeys.clear(); customkinkdata.clear();}
-	void addCustomKinkData(QString key, QString value) {customkinkdatakeys.removeAll(key); customkinkdatakeys.append(key); customkinkdata[key] = value;}
-	QStringList &getCustomKinkDataKeys() {return customkinkdatakeys;}
-	QHash<QString, QString> &getCustomKinkData() {return customkinkdata;}
-
-	void clearProfileData() {profiledatakeys.clear(); profiledata.clear();}
-	void addProfileData(QString key, QString value) {profiledatakeys.removeAll(key); profiledatakeys.append(key); profiledata[key] = value;}
-	QStringList &getProfileDataKeys() {return profiledatakeys;}
-	QHash<QString, QString> &getProfileData() {return profiledata;}
-	
-
 	static void initClass();
 
 private:
+	// Only presence data is kept here, packed so that an FRoster block holds two characters per cache line. Profile
+	// and custom kink data is in FCharacterProfile, which is only created for characters whose profile is requested.
 	QString				charName;
 	QString				statusMessage;
-	characterStatus		charStatus;
-	characterGender		charGender;
+	FCharacterId		charId;				// 0 for an empty roster slot.
 	quint32				lastActivity;
+	quint8				charStatus;			// A characterStatus.
+	quint8				charGender;			// A characterGender.
 	bool				chatOp;
 	bool				isFriend;
-
-	//todo: The following data should really go in 'FCharacterProfile', but placed here to expediate the transfer of flist_messenger::processCommand()'s functionality into 'FSession'. 'FCharacterProfile' is expected to use the JSON HTTP API to retrieve data and will be less session dependant.
-	QStringList customkinkdatakeys; //<Custom kink keys in the order they were reported by the server
-	QHash<QString, QString> customkinkdata; //Custom kink data.
-	QStringList profiledatakeys; //<Profile keys in the order they were reported by the server
-	QHash<QString, QString> profiledata; //Profile data.
 };
 
 #endif //flist_character_H
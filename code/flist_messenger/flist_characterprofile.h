@@ -2,17 +2,40 @@
 #define FCHARACTERPROFILE_H
 
 #include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
 
+/**
+Profile and custom kink data for a character, as sent by the server in PRD and KID. It is kept apart from FCharacter,
+in FRoster's profile table, because only a handful of the characters online ever have their profile opened.
+ */
 class FCharacterProfile : public QObject
 {
 Q_OBJECT
 public:
     explicit FCharacterProfile(QObject *parent = 0);
 
+    void clearCustomKinkData() {customkinkdatakeys.clear(); customkinkdata.clear();}
+    void addCustomKinkData(QString key, QString value) {customkinkdatakeys.removeAll(key); customkinkdatakeys.append(key); customkinkdata[key] = value;}
+    QStringList &getCustomKinkDataKeys() {return customkinkdatakeys;}
+    QHash<QString, QString> &getCustomKinkData() {return customkinkdata;}
+
+    void clearProfileData() {profiledatakeys.clear(); profiledata.clear();}
+    void addProfileData(QString key, QString value) {profiledatakeys.removeAll(key); profiledatakeys.append(key); profiledata[key] = value;}
+    QStringList &getProfileDataKeys() {return profiledatakeys;}
+    QHash<QString, QString> &getProfileData() {return profiledata;}
+
 signals:
 
 public slots:
 
+private:
+    //todo: 'FCharacterProfile' is expected to use the JSON HTTP API to retrieve data and will be less session dependant.
+    QStringList customkinkdatakeys; //<Custom kink keys in the order they were reported by the server
+    QHash<QString, QString> customkinkdata; //Custom kink data.
+    QStringList profiledatakeys; //<Profile keys in the order they were reported by the server
+    QHash<QString, QString> profiledata; //Profile data.
 };
 
 #endif // FCHARACTERPROFILE_H
@@ -0,0 +1,393 @@
+#include "flist_commands.h"
+
+#include <cstring>
+
+#include "../libjson/libJSON.h"
+
+namespace {
+	QString toQString(const json_string &string) {
+		return QString::fromUtf8(string.data(), (int)string.size());
+	}
+
+	qint64 toInteger(const json_char *value, size_t length) {
+		json_int_t result;
+		return libJSON::parse_int(value, length, result) ? result : 0;
+	}
+
+	//Counts are sent as numbers, but one sent as a string is read the same way.
+	qint64 toInteger(const JSONNode &node) {
+		if(node.type() == JSON_NUMBER) {
+			return node.as_int();
+		}
+		const json_string &text = node.as_string();
+		return toInteger(text.data(), text.size());
+	}
+
+	void decodeString(const JSONNode &node, QString &value) {
+		value = toQString(node.as_string());
+	}
+
+	void decodeInteger(const JSONNode &node, qint64 &value) {
+		value = toInteger(node);
+	}
+
+	void decodeStringList(const JSONNode &node, QStringList &value) {
+		json_index_t size = node.size();
+		value.reserve(size);
+		for(json_index_t i = 0; i < size; i++) {
+			value.append(toQString(node.at(i).as_string()));
+		}
+	}
+
+	void decodeIdentity(const JSONNode &node, QString &value) {
+		const JSONNode *identity = node.try_at("identity");
+		if(!identity) {
+			throw std::out_of_range("Missing identity.");
+		}
+		value = toQString(identity->as_string());
+	}
+
+	void decodeIdentityList(const JSONNode &node, QStringList &value) {
+		json_index_t size = node.size();
+		value.reserve(size);
+		for(json_index_t i = 0; i < size; i++) {
+			QString identity;
+			decodeIdentity(node.at(i), identity);
+			value.append(identity);
+		}
+	}
+
+	void decodeCharacterList(const JSONNode &node, QList<FCommandCharacter> &value) {
+		json_index_t size = node.size();
+		value.reserve(size);
+		for(json_index_t i = 0; i < size; i++) {
+			const JSONNode &entry = node.at(i);
+			if(entry.size() < 4) {
+				throw std::out_of_range("Character list entry is too short.");
+			}
+			FCommandCharacter character;
+			character.name = toQString(entry.at(0).as_string());
+			character.gender = toQString(entry.at(1).as_string());
+			character.status = toQString(entry.at(2).as_string());
+			character.statusmessage = toQString(entry.at(3).as_string());
+			value.append(character);
+		}
+	}
+
+	void decodeChannelList(const JSONNode &node, QList<FCommandChannel> &value) {
+		json_index_t size = node.size();
+		value.reserve(size);
+		for(json_index_t i = 0; i < size; i++) {
+			const JSONNode &entry = node.at(i);
+			const JSONNode *name = entry.try_at("name");
+			const JSONNode *characters = entry.try_at("characters");
+			if(!name || !characters) {
+				throw std::out_of_range("Channel list entry is missing a field.");
+			}
+			const JSONNode *title = entry.try_at("title");
+			FCommandChannel channel;
+			channel.name = toQString(name->as_string());
+			if(title) {
+				channel.title = toQString(title->as_string());
+			}
+			channel.characters = (int)toInteger(*characters);
+			value.append(channel);
+		}
+	}
+
+	template<typename T> inline void decodeField(void (*decoder)(const JSONNode &, T &), const JSONNode &node, T &field) {
+		decoder(node, field);
+	}
+	template<typename T> inline void decodeField(void (*decoder)(const JSONNode &, T &), const JSONNode &node, FOptional<T> &field) {
+		decoder(node, field.value);
+		field.present = true;
+	}
+
+	enum class StreamKind {String, Integer, StringList, Identity, IdentityList, CharacterList, ChannelList};
+
+	/**
+	A field of a command being decoded by CommandStream. 'target' points at the member, or at the value
+	of an FOptional, and has the type that goes with 'kind'. A null key ends the list.
+	 */
+	class StreamField
+	{
+	public:
+		const char *key;
+		StreamKind kind;
+		void *target;
+		bool *found;
+	};
+
+	template<typename T> inline void *streamTarget(T &field) {
+		return &field;
+	}
+	template<typename T> inline void *streamTarget(FOptional<T> &field) {
+		return &field.value;
+	}
+	template<typename T> inline void markPresent(T &, bool) {
+	}
+	template<typename T> inline void markPresent(FOptional<T> &field, bool found) {
+		field.present = found;
+	}
+
+	/**
+	Decodes the fields of a command as the SAX parser goes past them, to the same result as the node
+	decoders above. Values that don't belong to a field are skipped without being converted.
+	 */
+	class CommandStream : public JSONSaxHandler
+	{
+	public:
+		explicit CommandStream(StreamField *fields) :
+			fields(fields),
+			current(0),
+			depth(0),
+			subkey(),
+			index(0),
+			identityseen(false),
+			nameseen(false),
+			titleseen(false),
+			charactersseen(false),
+			character(),
+			channel()
+		{}
+
+		virtual bool start_node() {
+			depth++;
+			subkey.clear();
+			if(current) {
+				if((current->kind == StreamKind::Identity && depth == 2) || (current->kind == StreamKind::IdentityList && depth == 3)) {
+					identityseen = false;
+				} else if(current->kind == StreamKind::ChannelList && depth == 3) {
+					channel = FCommandChannel();
+					nameseen = titleseen = charactersseen = false;
+				}
+			}
+			return true;
+		}
+		virtual bool end_node() {
+			if(current) {
+				if((current->kind == StreamKind::Identity && depth == 2) || (current->kind == StreamKind::IdentityList && depth == 3)) {
+					if(!identityseen) {
+						throw std::out_of_range("Missing identity.");
+					}
+				} else if(current->kind == StreamKind::ChannelList && depth == 3) {
+					if(!nameseen || !charactersseen) {
+						throw std::out_of_range("Channel list entry is missing a field.");
+					}
+					static_cast<QList<FCommandChannel> *>(current->target)->append(channel);
+				}
+			}
+			endContainer();
+			return true;
+		}
+		virtual bool start_array() {
+			depth++;
+			if(current && current->kind == StreamKind::CharacterList && depth == 3) {
+				character = FCommandCharacter();
+				index = 0;
+			}
+			return true;
+		}
+		virtual bool end_array() {
+			if(current && current->kind == StreamKind::CharacterList && depth == 3) {
+				if(index < 4) {
+					throw std::out_of_range("Character list entry is too short.");
+				}
+				static_cast<QList<FCommandCharacter> *>(current->target)->append(character);
+			}
+			endContainer();
+			return true;
+		}
+		virtual bool key(const json_char *name, size_t length) {
+			if(depth != 1) {
+				subkey.assign(name, length);
+				return true;
+			}
+			for(current = fields; current->key; current++) {
+				if(!*current->found && strlen(current->key) == length && memcmp(current->key, name, length) == 0) {
+					*current->found = true;
+					return true;
+				}
+			}
+			current = 0;
+			return true;
+		}
+		virtual bool string(const json_char *value, size_t length) {
+			scalar(value, length);
+			return true;
+		}
+		virtual bool number(const json_char *value, size_t length) {
+			scalar(value, length);
+			return true;
+		}
+		virtual bool boolean(bool value) {
+			scalar(value ? "true" : "false", value ? 4 : 5);
+			return true;
+		}
+		virtual bool null() {
+			scalar("", 0);
+			return true;
+		}
+
+	private:
+		void endContainer() {
+			depth--;
+			if(depth == 1) {
+				current = 0;
+			}
+		}
+
+		void scalar(const json_char *value, size_t length) {
+			if(!current) {
+				return;
+			}
+			switch(current->kind) {
+			case StreamKind::String:
+				if(depth == 1) {
+					*static_cast<QString *>(current->target) = QString::fromUtf8(value, (int)length);
+				}
+				break;
+			case StreamKind::Integer:
+				if(depth == 1) {
+					*static_cast<qint64 *>(current->target) = toInteger(value, length);
+				}
+				break;
+			case StreamKind::StringList:
+				if(depth == 2) {
+					static_cast<QStringList *>(current->target)->append(QString::fromUtf8(value, (int)length));
+				}
+				break;
+			case StreamKind::Identity:
+				if(depth == 1) {
+					throw std::out_of_range("Missing identity.");
+				}
+				if(depth == 2 && !identityseen && subkey == "identity") {
+					*static_cast<QString *>(current->target) = QString::fromUtf8(value, (int)length);
+					identityseen = true;
+				}
+				break;
+			case StreamKind::IdentityList:
+				if(depth == 2) {
+					throw std::out_of_range("Missing identity.");
+				}
+				if(depth == 3 && !identityseen && subkey == "identity") {
+					static_cast<QStringList *>(current->target)->append(QString::fromUtf8(value, (int)length));
+					identityseen = true;
+				}
+				break;
+			case StreamKind::CharacterList:
+				if(depth == 2) {
+					throw std::out_of_range("Character list entry is too short.");
+				}
+				if(depth == 3) {
+					QString *members[] = {&character.name, &character.gender, &character.status, &character.statusmessage};
+					if(index < 4) {
+						*members[index] = QString::fromUtf8(value, (int)length);
+					}
+					index++;
+				}
+				break;
+			case StreamKind::ChannelList:
+				if(depth == 3) {
+					if(!nameseen && subkey == "name") {
+						channel.name = QString::fromUtf8(value, (int)length);
+						nameseen = true;
+					} else if(!titleseen && subkey == "title") {
+						channel.title = QString::fromUtf8(value, (int)length);
+						titleseen = true;
+					} else if(!charactersseen && subkey == "characters") {
+						channel.characters = (int)toInteger(value, length);
+						charactersseen = true;
+					}
+				}
+				break;
+			}
+			if(depth == 1) {
+				current = 0;
+			}
+		}
+
+		StreamField *fields;
+		StreamField *current; //< The field whose value is being read, null while skipping.
+		int depth; //< How many nodes and arrays are open, the command itself being the first.
+		json_string subkey; //< The last key seen inside the current field.
+		int index; //< Position in the current LIS entry.
+		bool identityseen;
+		bool nameseen;
+		bool titleseen;
+		bool charactersseen;
+		FCommandCharacter character; //< The LIS entry being read.
+		FCommandChannel channel; //< The CHA or ORS entry being read.
+	};
+}
+
+#define COMMANDDEF_FOUNDFLAG(Y,kind,member,jsonkey,presence) \
+	bool member##found = false;
+
+#define COMMANDDEF_DECODEFIELD(Y,kind,member,jsonkey,presence) \
+	if(!member##found && childname == jsonkey) {               \
+	    decodeField(decode##kind, child, member);              \
+	    member##found = true;                                  \
+	    continue;                                              \
+	}
+
+#define COMMANDDEF_CHECK_Required(member, jsonkey)  \
+	if(!member##found) {                            \
+	    throw std::out_of_range("Missing " jsonkey); \
+	}
+#define COMMANDDEF_CHECK_Optional(member, jsonkey) \
+	(void)member##found;
+#define COMMANDDEF_CHECKFIELD(Y,kind,member,jsonkey,presence) \
+	COMMANDDEF_CHECK_##presence(member, jsonkey)
+
+// Each decoder walks the children of the command once, matching every child
+// against the fields that haven't been seen yet. Unknown keys are skipped.
+#define COMMANDDEF_MAKE(what)                                         \
+	FCmd##what::FCmd##what(const JSONNode &nodes)                     \
+	{                                                                 \
+	    COMMANDDEF_##what(COMMANDDEF_FOUNDFLAG,what)                  \
+	    json_index_t size = nodes.type() == JSON_NODE ? nodes.size() : 0; \
+	    for(json_index_t i = 0; i < size; i++) {                      \
+	        const JSONNode &child = nodes.at(i);                      \
+	        json_string childname = child.name();                     \
+	        (void)child;                                              \
+	        COMMANDDEF_##what(COMMANDDEF_DECODEFIELD,what)            \
+	    }                                                             \
+	    COMMANDDEF_##what(COMMANDDEF_CHECKFIELD,what)                 \
+	}
+
+#include "flist_commands.def"
+
+#define COMMANDDEF_STREAMFIELD(Y,kind,member,jsonkey,presence) \
+	{jsonkey, StreamKind::kind, streamTarget(member), &member##found},
+
+#define COMMANDDEF_MARKPRESENT(Y,kind,member,jsonkey,presence) \
+	markPresent(member, member##found);
+
+// The same decoders again, fed by the SAX parser instead of walking nodes.
+#define COMMANDDEF_MAKE(what)                                          \
+	FCmd##what::FCmd##what(const char *json, size_t length)            \
+	{                                                                  \
+	    COMMANDDEF_##what(COMMANDDEF_FOUNDFLAG,what)                   \
+	    StreamField fields[] = {                                       \
+	        COMMANDDEF_##what(COMMANDDEF_STREAMFIELD,what)             \
+	        {0, StreamKind::String, 0, 0}                              \
+	    };                                                             \
+	    CommandStream stream(fields);                                  \
+	    libJSON::parse_sax(json, length, stream);                      \
+	    COMMANDDEF_##what(COMMANDDEF_MARKPRESENT,what)                 \
+	    COMMANDDEF_##what(COMMANDDEF_CHECKFIELD,what)                  \
+	}
+
+#include "flist_commands.def"
+
+#define COMMANDDEF_DECODESTREAMED(what)                          \
+	if(memcmp(command, #what, 3) == 0) {                         \
+	    return std::make_shared<FCmd##what>(json, length);       \
+	}
+
+std::shared_ptr<void> decodeStreamedCommand(const char *command, const char *json, size_t length)
+{
+	COMMANDDEF_STREAMED(COMMANDDEF_DECODESTREAMED)
+	return std::shared_ptr<void>();
+}
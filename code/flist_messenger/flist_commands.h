@@ -0,0 +1,90 @@
+#ifndef FLIST_COMMANDS_H
+#define FLIST_COMMANDS_H
+
+#include <stdexcept>
+#include <memory>
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+class JSONNode;
+
+/**
+A field that the server may leave out. 'present' is false if it did.
+ */
+template<typename T> class FOptional
+{
+public:
+	FOptional() : value(), present(false) {}
+
+	//For fields that are only optional for some variants of a command. Throws like a missing required field would.
+	const T &required() const {
+		if(!present) {
+			throw std::out_of_range("Optional command field is required here.");
+		}
+		return value;
+	}
+
+	T value;
+	bool present;
+};
+
+/**
+One entry of a LIS block: ["Character Name", gender, status, "Status Message"]
+ */
+class FCommandCharacter
+{
+public:
+	QString name;
+	QString gender;
+	QString status;
+	QString statusmessage;
+};
+
+/**
+One entry of a CHA or ORS list: {"name": "Channel Name", "title": "Channel Title", "characters": count}
+ */
+class FCommandChannel
+{
+public:
+	FCommandChannel() : name(), title(), characters(0) {}
+
+	QString name;
+	QString title; //< Only sent in ORS.
+	int characters;
+};
+
+#define COMMANDDEF_TYPE_String QString
+#define COMMANDDEF_TYPE_Integer qint64
+#define COMMANDDEF_TYPE_StringList QStringList
+#define COMMANDDEF_TYPE_Identity QString
+#define COMMANDDEF_TYPE_IdentityList QStringList
+#define COMMANDDEF_TYPE_CharacterList QList<FCommandCharacter>
+#define COMMANDDEF_TYPE_ChannelList QList<FCommandChannel>
+#define COMMANDDEF_TYPE_Required(kind) COMMANDDEF_TYPE_##kind
+#define COMMANDDEF_TYPE_Optional(kind) FOptional<COMMANDDEF_TYPE_##kind >
+
+#define COMMANDDEF_MEMBER(Y,kind,member,jsonkey,presence) \
+	COMMANDDEF_TYPE_##presence(kind) member;
+
+// Declares FCmdXXX for every command in flist_commands.def. The constructors
+// are the decoders, from parsed nodes or straight from the JSON text, and are
+// implemented in flist_commands.cpp.
+#define COMMANDDEF_MAKE(what)                                  \
+	class FCmd##what {                                         \
+	public:                                                    \
+	    explicit FCmd##what(const JSONNode &nodes);            \
+	    FCmd##what(const char *json, size_t length);           \
+	    COMMANDDEF_##what(COMMANDDEF_MEMBER,what)              \
+	};
+
+#include "flist_commands.def"
+
+/**
+If the command is one of COMMANDDEF_STREAMED, decode its JSON into a new FCmdXXX. Returns null for
+every other command, which should be parsed into nodes instead. Throws like the constructors do.
+ */
+std::shared_ptr<void> decodeStreamedCommand(const char *command, const char *json, size_t length);
+
+#endif // FLIST_COMMANDS_H
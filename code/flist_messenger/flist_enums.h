@@ -15,6 +15,18 @@ enum TypingStatus {
 template<typename T> QString enumToKey(T p);
 template<typename T> T keyToEnum(QString s, T defval = (T)0);
 
+// keyToEnum for text typed by the user, so "warning" finds LogLevel::Warning.
+// Gives T::Max if nothing matches.
+template<typename T> T keyToEnumNoCase(const QString &s)
+{
+	for (int i = 0; i < (int)T::Max; i++) {
+		if (enumToKey((T)i).compare(s, Qt::CaseInsensitive) == 0) {
+			return (T)i;
+		}
+	}
+	return T::Max;
+}
+
 #define ENUMDEF_ENUMMEMBER(y,x) x,
 #define ENUMDEF_MAKE(what)                       \
 	enum class what : int {                      \
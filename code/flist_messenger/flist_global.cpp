@@ -3,10 +3,10 @@
 #include <QDesktopWidget>
 #include <QSettings>
 #include <QByteArray>
-#include <iostream>
 #include "flist_parser.h"
 #include "api/endpoint_v1.h"
 #include "flist_settings.h"
+#include "flist_capture.h"
 
 QNetworkAccessManager *networkaccessmanager = 0;
 BBCodeParser *bbcodeparser = 0;
@@ -14,21 +14,11 @@ QString settingsfile;
 QString logpath;
 FSettings *settings = 0;
 FHttpApi::Endpoint *fapi = 0;
-
-void debugMessage(QString str) {
-	std::cout << str.toUtf8().data() << std::endl;
-}
-
-void debugMessage(std::string str) {
-	std::cout << str << std::endl;
-}
-
-void debugMessage(const char *str) {
-	std::cout << str << std::endl;
-}
+FCapture *capture = 0;
 
 void globalInit()
 {
+	FLog::startWriter();
 	//todo: parse command line for options
 	//todo: make settingsfile configurable
 	settingsfile = qApp->applicationDirPath() + "/settings.ini";
@@ -45,7 +35,11 @@ void globalInit()
 
 void globalQuit()
 {
-
+	//Session workers may still be running, so the capture is closed but not deleted.
+	if(capture) {
+		capture->close();
+	}
+	FLog::stopWriter();
 }
 
 
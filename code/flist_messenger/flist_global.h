@@ -3,18 +3,20 @@
 
 #include <QNetworkAccessManager>
 #include "flist_api.h"
+#include "flist_log.h"
 
 class BBCodeParser; 
 class FSettings;
+class FCapture;
 
 extern QNetworkAccessManager *networkaccessmanager;
 extern BBCodeParser *bbcodeparser;
 extern FHttpApi::Endpoint *fapi;
 extern FSettings *settings;
+extern FCapture *capture; //< Records session traffic when started with -capture, otherwise null.
 
-void debugMessage(QString str);
-void debugMessage(std::string str);
-void debugMessage(const char *str);
+// General purpose debug output. Like FLOG, the message isn't built if the General category is quieter than Debug.
+#define debugMessage(message) FLOG(General, Debug, message)
 void globalInit();
 void globalQuit();
 bool is_broken_escaped_apos(std::string const &data, std::string::size_type n);
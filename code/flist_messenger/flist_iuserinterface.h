@@ -1,6 +1,8 @@
 #ifndef FLIST_IUSERINTERFACE_H
 #define FLIST_IUSERINTERFACE_H
 
+#include <QStringList>
+
 #include "flist_enums.h"
 
 class FSession;
@@ -19,6 +21,7 @@ public:
 	virtual void addChannel(FSession *session, QString name, QString title) = 0;
 	virtual void removeChannel(FSession *session, QString name) = 0;
 	virtual void addChannelCharacter(FSession *session, QString channelname, QString charactername, bool notify) = 0;
+	virtual void addChannelCharacters(FSession *session, QString channelname, QStringList characternames) = 0; //< Quietly add a whole member list, as sent in ICH.
 	virtual void removeChannelCharacter(FSession *session, QString channelname, QString charactername) = 0;
 	virtual void setChannelOperator(FSession *session, QString channelname, QString charactername, bool opstatus) = 0;
 	virtual void joinChannel(FSession *session, QString channelname) = 0;
@@ -26,8 +29,10 @@ public:
 	virtual void setChannelDescription(FSession *session, QString channelname, QString description) = 0;
 	virtual void setChannelMode(FSession *session, QString channelname, ChannelMode mode) = 0;
 	virtual void notifyChannelReady(FSession *session, QString channelname) = 0;
+	virtual bool isChannelVisible(FSession *session, QString channelname) = 0; //< True if the channel's panel is the one on screen.
 
 	virtual void notifyCharacterOnline(FSession *session, QString charactername, bool online) = 0;
+	virtual void notifyCharactersOnline(FSession *session, QStringList characternames, bool online) = 0; //< Same as notifyCharacterOnline() for a whole LIS block.
 	virtual void notifyCharacterStatusUpdate(FSession *session, QString charactername) = 0;
 	virtual void setCharacterTypingStatus(FSession *session, QString charactername, TypingStatus typingstatus) = 0;
 	virtual void notifyCharacterCustomKinkDataUpdated(FSession *session, QString charactername) = 0;
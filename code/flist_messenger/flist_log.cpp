@@ -0,0 +1,150 @@
+#include "flist_log.h"
+
+#include <cstdio>
+
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QByteArray>
+
+namespace {
+	/**
+	Writes log lines to stdout from its own thread. Lines are appended to a buffer under a lock,
+	and the thread writes out and flushes whatever has built up each time it wakes.
+	 */
+	class FLogWriter : public QThread
+	{
+	public:
+		FLogWriter() : QThread(), pending(), stopping(false) {}
+
+		void append(const QByteArray &line) {
+			QMutexLocker locker(&mutex);
+			bool wake = pending.isEmpty();
+			pending.append(line);
+			if(wake) {
+				wakeup.wakeOne();
+			}
+		}
+		void stop() {
+			QMutexLocker locker(&mutex);
+			stopping = true;
+			wakeup.wakeOne();
+		}
+
+	protected:
+		void run() {
+			QByteArray buffer;
+			forever {
+				{
+					QMutexLocker locker(&mutex);
+					while(pending.isEmpty() && !stopping) {
+						wakeup.wait(&mutex);
+					}
+					if(pending.isEmpty()) {
+						return;
+					}
+					buffer.swap(pending);
+				}
+				fwrite(buffer.constData(), 1, buffer.size(), stdout);
+				fflush(stdout);
+				buffer.clear();
+			}
+		}
+
+	private:
+		QMutex mutex;
+		QWaitCondition wakeup;
+		QByteArray pending; //< Lines waiting to be written.
+		bool stopping;
+	};
+
+	FLogWriter *writer = 0;
+	QMutex writermutex; //< Guards 'writer' itself while it's started or stopped.
+
+	QByteArray formatLine(LogCategory category, LogLevel level, const QByteArray &message) {
+		QByteArray line;
+		line.reserve(message.size() + 24);
+		line += '[';
+		line += enumToKey(category).toLatin1();
+		if(level != LogLevel::Debug) {
+			line += ' ';
+			line += enumToKey(level).toLatin1();
+		}
+		line += "] ";
+		line += message;
+		line += '\n';
+		return line;
+	}
+
+	void writeLine(const QByteArray &line) {
+		QMutexLocker locker(&writermutex);
+		if(writer) {
+			writer->append(line);
+		} else {
+			//Before startup and after shutdown there's no writer, so just write it out directly.
+			fwrite(line.constData(), 1, line.size(), stdout);
+			fflush(stdout);
+		}
+	}
+}
+
+//Every category starts out at Debug. Trace is only for when you're chasing something.
+#define LOG_DEFAULTTHRESHOLD(Y,X) {(int)LogLevel::Debug},
+std::atomic<int> FLog::thresholds[(int)LogCategory::Max] = {
+	ENUMDEF_LogCategory(LOG_DEFAULTTHRESHOLD,)
+};
+
+void FLog::setLevel(LogCategory category, LogLevel level)
+{
+	thresholds[(int)category].store((int)level);
+}
+
+LogLevel FLog::getLevel(LogCategory category)
+{
+	return (LogLevel)thresholds[(int)category].load();
+}
+
+void FLog::write(LogCategory category, LogLevel level, const QString &message)
+{
+	writeLine(formatLine(category, level, message.toUtf8()));
+}
+
+void FLog::write(LogCategory category, LogLevel level, const std::string &message)
+{
+	writeLine(formatLine(category, level, QByteArray(message.data(), (int)message.size())));
+}
+
+void FLog::write(LogCategory category, LogLevel level, const char *message)
+{
+	writeLine(formatLine(category, level, QByteArray(message)));
+}
+
+void FLog::startWriter()
+{
+	QMutexLocker locker(&writermutex);
+	if(writer) {
+		return;
+	}
+	writer = new FLogWriter();
+	writer->start(QThread::LowPriority);
+}
+
+/**
+Write out everything still queued and stop the writer thread. Later messages are written directly.
+ */
+void FLog::stopWriter()
+{
+	FLogWriter *oldwriter;
+	{
+		QMutexLocker locker(&writermutex);
+		oldwriter = writer;
+		writer = 0;
+	}
+	if(!oldwriter) {
+		return;
+	}
+	oldwriter->stop();
+	oldwriter->wait();
+	delete oldwriter;
+}
@@ -0,0 +1,50 @@
+#ifndef FLIST_LOG_H
+#define FLIST_LOG_H
+
+#include <atomic>
+#include <string>
+
+#include <QString>
+
+#include "flist_enums.h"
+
+// The most verbose level that is compiled in at all. Anything more verbose is
+// removed by the compiler along with the code that builds its message.
+#ifndef FLIST_LOG_MAXLEVEL
+#ifdef QT_NO_DEBUG
+#define FLIST_LOG_MAXLEVEL Debug
+#else
+#define FLIST_LOG_MAXLEVEL Trace
+#endif
+#endif
+
+namespace FLog {
+	extern std::atomic<int> thresholds[(int)LogCategory::Max]; //< Most verbose level enabled for each category.
+
+	inline bool isEnabled(LogCategory category, LogLevel level) {
+		return (int)level <= thresholds[(int)category].load(std::memory_order_relaxed);
+	}
+	void setLevel(LogCategory category, LogLevel level);
+	LogLevel getLevel(LogCategory category);
+
+	void write(LogCategory category, LogLevel level, const QString &message);
+	void write(LogCategory category, LogLevel level, const std::string &message);
+	void write(LogCategory category, LogLevel level, const char *message);
+
+	void startWriter();
+	void stopWriter();
+}
+
+/**
+Log a message, e.g. FLOG(Network, Trace, QString("Recv size %0").arg(size)). The message
+expression is only evaluated if the category is enabled at that level.
+ */
+#define FLOG(category, level, message)                                              \
+	do {                                                                            \
+	    if((int)LogLevel::level <= (int)LogLevel::FLIST_LOG_MAXLEVEL &&             \
+	       FLog::isEnabled(LogCategory::category, LogLevel::level)) {               \
+	        FLog::write(LogCategory::category, LogLevel::level, (message));         \
+	    }                                                                           \
+	} while(0)
+
+#endif // FLIST_LOG_H
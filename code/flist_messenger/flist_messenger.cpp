@@ -22,6 +22,7 @@
 #include "flist_messenger.h"
 #include "flist_global.h"
 
+#include <algorithm>
 #include <iostream>
 #include <QString>
 #include <QSplitter>
@@ -64,6 +65,7 @@
 #include "flist_channelpanel.h"
 #include "flist_channeltab.h"
 #include "flist_logtextbrowser.h"
+#include "flist_metrics.h"
 
 #include "ui/characterinfodialog.h"
 #include "ui/channellistdialog.h"
@@ -80,6 +82,19 @@ void flist_messenger::init()
 	settingsPath = QApplication::applicationDirPath() + QSL("/settings.ini");
 }
 
+/**
+Append a '/stats' report for every session to the given file, every 'interval' seconds.
+ */
+bool flist_messenger::startMetricsDump(QString filename, int interval)
+{
+	FMetricsDumper *dumper = new FMetricsDumper(server, this);
+	if(!dumper->open(filename, interval)) {
+		delete dumper;
+		return false;
+	}
+	return true;
+}
+
 flist_messenger::flist_messenger(bool d)
 {
 	server = new FServer(this);
@@ -220,6 +235,7 @@ void flist_messenger::startConnect(QString charName)
 	connect(session, &FSession::socketErrorSignal, this, &flist_messenger::socketError);
 	
 	connect(session, &FSession::notifyCharacterOnline, this, &flist_messenger::notifyCharacterOnline);
+	connect(session, &FSession::notifyCharactersOnline, this, &flist_messenger::notifyCharactersOnline);
 	connect(session, &FSession::notifyCharacterStatusUpdate, this, &flist_messenger::notifyCharacterStatusUpdate);
 	connect(session, &FSession::notifyIgnoreAdd, this, &flist_messenger::notifyIgnoreRemove);
 	connect(session, &FSession::notifyIgnoreRemove, this, &flist_messenger::notifyIgnoreRemove);
@@ -457,14 +473,14 @@ void flist_messenger::handleReportFinished()
 		lreply->deleteLater();
 		std::string response ( respbytes.begin(), respbytes.end() );
 		JSONNode respnode = libJSON::parse ( response );
-		JSONNode childnode = respnode.at ( "error" );
-		if (childnode.as_string() != "" ) {
-			std::string message = "Error from server: " + childnode.as_string();
+		const JSONNode *errnode = respnode.try_at ( "error" );
+		if (errnode && errnode->as_string() != "" ) {
+			std::string message = "Error from server: " + errnode->as_string();
 			QMessageBox::critical ( this, QSL("Error"), message.c_str() );
 			return;
 		}
 		else {
-			childnode = respnode.at ( "log_id" );
+			JSONNode childnode = respnode.at ( "log_id" );
 			std::string logid = childnode.as_string();
 			QString problem = re_teProblem->toPlainText().toHtmlEscaped();
 			QString who = re_leWho->text().toHtmlEscaped();
@@ -493,9 +509,9 @@ void flist_messenger::reportTicketFinished()
 	lreply->deleteLater();
 	std::string response(respbytes.begin(), respbytes.end());
 	JSONNode respnode = libJSON::parse ( response );
-	JSONNode childnode = respnode.at ( "error" );
-	if (childnode.as_string() != "") {
-		std::string message = "Error from server: " + childnode.as_string();
+	const JSONNode *errnode = respnode.try_at ( "error" );
+	if (errnode && errnode->as_string() != "") {
+		std::string message = "Error from server: " + errnode->as_string();
 		QMessageBox::critical ( this, QSL("Error"), message.c_str() );
 		return;
 	}
@@ -562,6 +578,7 @@ void flist_messenger::closeChannelPanel(QString panelname)
 	}
 	else {
 		channelpanel->emptyCharList();
+		channelpanel->setOps(QList<FCharacterId>());
 	}
 	channelpanel->setActive(false);
 	channelpanel->pushButton->setVisible(false);
@@ -1160,7 +1177,7 @@ void flist_messenger::characterInfoDialogRequested()
 	session->requestProfileKinks(ch->name());
 
 	if (!ci_dialog) { ci_dialog = new FCharacterInfoDialog(this); }
-	ci_dialog->setDisplayedCharacter(ch);
+	ci_dialog->setDisplayedCharacter(ch, session->getCharacterProfile(ch->id()));
 	ci_dialog->show();
 }
 void flist_messenger::reportDialogRequested()
@@ -1259,7 +1276,7 @@ void flist_messenger::socketError ( QAbstractSocket::SocketError socketError )
 {
 	(void) socketError;
 	FSession *session = account->getSession(charName); //todo: fix this
-	QString sockErrorStr = session->socket->errorString();
+	QString sockErrorStr = session->getSocketErrorString();
 	if (currentPanel )
 	{
 		QString errorstring = QSL("<b>Socket Error: </b>") + sockErrorStr;
@@ -1716,7 +1733,7 @@ void flist_messenger::parseInput()
 		else if (slashcommand == QSL("/debugrecv")) {
 			//Artificially receive a packet from the server. The packet is not validated.
 			if (session) {
-				session->wsRecv(ownText.mid(11).toStdString());
+				session->wsRecv(ownText.mid(11).toUtf8());
 				success = true;
 			}
 			else {
@@ -2044,6 +2061,25 @@ void flist_messenger::parseInput()
 			success = true;
 		}
 		
+		else if (slashcommand == QSL("/stats")) {
+			//Show where the time handling each server command goes, slowest first. '/stats reset' starts over.
+			if (!session) {
+				messageSystem(session, QSL("Can't do '/stats', as there is no session associated with this console."), MessageType::Feedback);
+			}
+			else if (parts.count() > 1 && parts[1].toLower() == QSL("reset")) {
+				session->resetCommandStats();
+				messageSystem(session, QSL("Statistics have been reset."), MessageType::Feedback);
+			}
+			else {
+				QString output = QSL("<b>Statistics:</b>");
+				foreach(const QString &line, metricsReport(session)) {
+					output += QSL("<br />") + line.toHtmlEscaped();
+				}
+				messageSystem(session, output, MessageType::Feedback);
+			}
+			success = true;
+		}
+
 		else if (debugging && slashcommand == QSL("/channeltojson")) {
 			QString output = QSL("[noparse]%0[/noparse]");
 			JSONNode* node = currentPanel->toJSON();
@@ -2052,6 +2088,57 @@ void flist_messenger::parseInput()
 			success = true;
 		}
 		
+		else if (debugging && slashcommand == QSL("/commandstats")) {
+			//Show how much of each server command has been received, busiest first. '/commandstats reset' clears the counters.
+			if (!session) {
+				messageSystem(session, QSL("Can't do '/commandstats', as there is no session associated with this console."), MessageType::Feedback);
+			}
+			else if (parts.count() > 1 && parts[1].toLower() == QSL("reset")) {
+				session->resetCommandStats();
+				messageSystem(session, QSL("Command statistics have been reset."), MessageType::Feedback);
+			}
+			else {
+				const QHash<quint32, FCommandStats> &stats = session->getCommandStats();
+				QList<quint32> codes = stats.keys();
+				std::sort(codes.begin(), codes.end(), [&stats](quint32 a, quint32 b) {return stats[a].bytes > stats[b].bytes;});
+				QString output = QSL("<b>Command statistics:</b>");
+				foreach(quint32 code, codes) {
+					const FCommandStats &s = stats[code];
+					output += QSL("<br />%0: %1 frames, %2 bytes, %3 parse failures, %4 deferred")
+						.arg(FSession::unpackCommand(code).toHtmlEscaped())
+						.arg(s.frames)
+						.arg(s.bytes)
+						.arg(s.parsefailures)
+						.arg(s.deferred);
+				}
+				messageSystem(session, output, MessageType::Feedback);
+			}
+			success = true;
+		}
+
+		else if (debugging && slashcommand == QSL("/loglevel")) {
+			//'/loglevel' shows the level of each log category, '/loglevel <category> <level>' changes one.
+			if (parts.count() > 2) {
+				LogCategory category = keyToEnumNoCase<LogCategory>(parts[1]);
+				LogLevel level = keyToEnumNoCase<LogLevel>(parts[2]);
+				if (category == LogCategory::Max || level == LogLevel::Max) {
+					messageSystem(session, QSL("Unknown log category or level."), MessageType::Feedback);
+				}
+				else {
+					FLog::setLevel(category, level);
+					messageSystem(session, QSL("Log level for %0 is now %1.").arg(enumToKey(category)).arg(enumToKey(level)), MessageType::Feedback);
+				}
+			}
+			else {
+				QString output = QSL("<b>Log levels:</b>");
+				for (int i = 0; i < (int)LogCategory::Max; i++) {
+					output += QSL("<br />%0: %1").arg(enumToKey((LogCategory)i)).arg(enumToKey(FLog::getLevel((LogCategory)i)));
+				}
+				messageSystem(session, output, MessageType::Feedback);
+			}
+			success = true;
+		}
+
 		else if (debugging && slashcommand == QSL("/refreshqss")) {
 			QFile stylefile(QSL("default.qss"));
 			stylefile.open(QFile::ReadOnly);
@@ -2251,6 +2338,41 @@ void flist_messenger::addChannelCharacter(FSession *session, QString channelname
 	}
 }
 
+bool flist_messenger::isChannelVisible(FSession *session, QString channelname)
+{
+	return currentPanel && currentPanel == channelList.value(PANELNAME(channelname, session->getSessionID()));
+}
+
+/**
+Add a channel's initial member list in one go. Unlike addChannelCharacter() this doesn't announce anyone
+or refresh the user list, that is left to notifyChannelReady().
+ */
+void flist_messenger::addChannelCharacters(FSession *session, QString channelname, QStringList characternames)
+{
+	QString panelname = PANELNAME(channelname, session->getSessionID());
+	FChannelPanel *channelpanel = channelList.value(panelname);
+	if (!channelpanel) {
+		printDebugInfo("[BUG]: Told about characters joining a channel, but the panel for the channel doesn't exist. " + channelname.toStdString());
+		return;
+	}
+	QList<FCharacter*> characters;
+	characters.reserve(characternames.count());
+	bool self = false;
+	foreach (const QString &charactername, characternames) {
+		FCharacter *character = session->getCharacter(charactername);
+		if (!character) {
+			printDebugInfo("[SERVER BUG]: Server told us about a character joining a channel, but we don't know about them yet. " + charactername.toStdString());
+			continue;
+		}
+		characters.append(character);
+		self = self || charactername == session->character;
+	}
+	channelpanel->addChars(characters);
+	if (self) {
+		switchTab(panelname);
+	}
+}
+
 void flist_messenger::removeChannelCharacter(FSession *session, QString channelname, QString charactername)
 {
 	FChannelPanel* channelpanel;
@@ -2278,10 +2400,10 @@ void flist_messenger::setChannelOperator(FSession *session, QString channelname,
 	FChannelPanel *channelpanel = channelList.value(panelname);
 	if (channelpanel) {
 		if (opstatus) {
-			channelpanel->addOp(charactername);
+			channelpanel->addOp(session->getNames().intern(charactername));
 		}
 		else {
-			channelpanel->removeOp(charactername);
+			channelpanel->removeOp(session->getNames().find(charactername));
 		}
 		if (currentPanel == channelpanel) {
 			refreshUserlist();
@@ -2373,6 +2495,27 @@ void flist_messenger::notifyCharacterOnline(FSession *session, QString character
 	}
 }
 
+void flist_messenger::notifyCharactersOnline(FSession *session, QStringList characternames, bool online)
+{
+	//Only friends and characters with an open PM panel are announced, so check those cheaply before doing any formatting.
+	QString panelprefix = QSL("PM|||%0|||").arg(session->getSessionID());
+	QString state = online ? QSL("online") : QSL("offline");
+	MessageType messagetype = online ? MessageType::Online : MessageType::Offline;
+	QList<QString> channels;
+	foreach (const QString &charactername, characternames) {
+		QList<QString> characters;
+		bool system = session->isCharacterFriend(charactername);
+		if (channelList.contains(panelprefix + charactername)) {
+			characters.append(charactername);
+			system = true;
+		}
+		if (system) {
+			QString msg = QSL("<b>%0</b> is now %1.").arg(charactername, state);
+			messageMany(session, channels, characters, system, msg, messagetype);
+		}
+	}
+}
+
 void flist_messenger::notifyCharacterStatusUpdate(FSession *session, QString charactername)
 {
 	QString panelname = QSL("PM|||%0|||%1").arg(session->getSessionID(), charactername);
@@ -2422,7 +2565,7 @@ void flist_messenger::notifyCharacterCustomKinkDataUpdated(FSession *session, QS
 		debugMessage(QSL("Received custom kink data for the character '%1' but the character is not known.").arg(charactername));
 		return;
 	}
-	ci_dialog->updateKinks(character);
+	ci_dialog->updateKinks(session->getCharacterProfile(character->id()));
 }
 void flist_messenger::notifyCharacterProfileDataUpdated(FSession *session, QString charactername)
 {
@@ -2436,7 +2579,7 @@ void flist_messenger::notifyCharacterProfileDataUpdated(FSession *session, QStri
 		return;
 	}
 
-	ci_dialog->updateProfile(character);
+	ci_dialog->updateProfile(session->getCharacterProfile(character->id()));
 }
 
 void flist_messenger::notifyIgnoreAdd(FSession *s, QString character)
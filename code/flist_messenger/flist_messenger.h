@@ -88,6 +88,8 @@ public:
 	flist_messenger(bool d);
 	~flist_messenger();
 
+	bool startMetricsDump(QString filename, int interval);
+
 	virtual FSession *getSession(QString sessionid);
 
 	virtual void setChatOperator(FSession *session, QString characteroperator, bool opstatus);
@@ -98,6 +100,8 @@ public:
 	virtual void addChannel(FSession *session, QString name, QString title);
 	virtual void removeChannel(FSession *session, QString name);
 	virtual void addChannelCharacter(FSession *session, QString channelname, QString charactername, bool notify);
+	virtual void addChannelCharacters(FSession *session, QString channelname, QStringList characternames);
+	virtual bool isChannelVisible(FSession *session, QString channelname);
 	virtual void removeChannelCharacter(FSession *session, QString channelname, QString charactername);
 	virtual void setChannelOperator(FSession *session, QString channelname, QString charactername, bool opstatus);
 	virtual void joinChannel(FSession *session, QString channelname);
@@ -108,6 +112,7 @@ public:
 
 public slots:
 	virtual void notifyCharacterOnline(FSession *session, QString charactername, bool online);
+	virtual void notifyCharactersOnline(FSession *session, QStringList characternames, bool online);
 	virtual void notifyCharacterStatusUpdate(FSession *session, QString charactername);
 	
 	void notifyIgnoreAdd(FSession *s, QString character);
@@ -37,6 +37,7 @@ HEADERS += \
            flist_messenger.h \
            flist_parser.h \
            flist_session.h \
+           flist_sessionworker.h \
            flist_sound.h \
            ../libjson/libJSON.h \
            ../libjson/Source/JSONDefs.h \
@@ -45,9 +46,13 @@ HEADERS += \
            ../libjson/Source/internalJSONNode.h \
            ../libjson/Source/JSONDebug.h \
            ../libjson/Source/JSONChildren.h \
+           ../libjson/Source/JSONName.h \
            ../libjson/Source/JSONMemory.h \
            ../libjson/Source/JSON_Base64.h \
            ../libjson/Source/JSONWorker.h \
+           ../libjson/Source/JSONSax.h \
+           ../libjson/Source/JSONScan.h \
+           ../libjson/Source/JSONStreamWriter.h \
            ../libjson/Source/NumberToString.h \
     flist_server.h \
     flist_characterprofile.h \
@@ -56,6 +61,13 @@ HEADERS += \
     flist_channel.h \
     flist_channelsummary.h \
     flist_enums.h \
+    flist_commands.h \
+    flist_log.h \
+    flist_capture.h \
+    flist_replay.h \
+    flist_metrics.h \
+    flist_names.h \
+    flist_roster.h \
     flist_message.h \
     flist_logtextbrowser.h \
     flist_settings.h \
@@ -77,7 +89,8 @@ HEADERS += \
     ui/addremovelistview.h \
     notifylist.h \
     ui/stringcharacterlistmodel.h \
-    flist_enums.def
+    flist_enums.def \
+    flist_commands.def
 SOURCES += \
            flist_account.cpp \
            flist_avatar.cpp \
@@ -87,6 +100,7 @@ SOURCES += \
            flist_messenger.cpp \
            flist_parser.cpp \
            flist_session.cpp \
+           flist_sessionworker.cpp \
            flist_sound.cpp \
            main.cpp \
            ../libjson/Source/JSONNode.cpp \
@@ -96,6 +110,9 @@ SOURCES += \
            ../libjson/Source/JSONMemory.cpp \
            ../libjson/Source/JSON_Base64.cpp \
            ../libjson/Source/JSONWorker.cpp \
+           ../libjson/Source/JSONSax.cpp \
+           ../libjson/Source/JSONScan.cpp \
+           ../libjson/Source/JSONStreamWriter.cpp \
            ../libjson/Source/JSONWriter.cpp \
     flist_characterprofile.cpp \
     flist_server.cpp \
@@ -110,6 +127,13 @@ SOURCES += \
 	api/apihelpers.cpp \
     flist_settings.cpp \
     flist_enums.cpp \
+    flist_commands.cpp \
+    flist_log.cpp \
+    flist_capture.cpp \
+    flist_replay.cpp \
+    flist_metrics.cpp \
+    flist_names.cpp \
+    flist_roster.cpp \
     flist_attentionsettingswidget.cpp \
     ui/helpdialog.cpp \
     ui/characterinfodialog.cpp \
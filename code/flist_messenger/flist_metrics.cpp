@@ -0,0 +1,338 @@
+#include "flist_metrics.h"
+
+#include <algorithm>
+
+#include <QtAlgorithms>
+#include <QDateTime>
+#include <QHash>
+
+#include "flist_server.h"
+#include "flist_account.h"
+#include "flist_session.h"
+#include "flist_message.h"
+
+FHistogram::FHistogram() :
+	count(0),
+	total(0),
+	max(0)
+{
+	std::fill(buckets, buckets + bucketcount, 0);
+}
+
+void FHistogram::add(quint64 value)
+{
+	int bucket = value ? 64 - qCountLeadingZeroBits(value) : 0;
+	buckets[qMin(bucket, bucketcount - 1)]++;
+	count++;
+	total += value;
+	if(value > max) {
+		max = value;
+	}
+}
+
+/**
+Estimate the value that the given percentage of values are at or below. This is the top of the bucket
+the percentile falls in, so it overestimates by up to a factor of two, but never by more than the
+largest value added.
+ */
+quint64 FHistogram::percentile(int percent) const
+{
+	if(!count) {
+		return 0;
+	}
+	quint64 rank = (count * percent + 99) / 100;
+	quint64 seen = 0;
+	for(int bucket = 0; bucket < bucketcount; bucket++) {
+		seen += buckets[bucket];
+		if(seen >= rank && seen > 0) {
+			quint64 top = bucket ? (Q_UINT64_C(1) << bucket) - 1 : 0;
+			return bucket == bucketcount - 1 ? max : qMin(top, max);
+		}
+	}
+	return max;
+}
+
+QString formatNanoseconds(quint64 nanoseconds)
+{
+	if(nanoseconds < 1000) {
+		return QString("%1 ns").arg(nanoseconds);
+	} else if(nanoseconds < 1000000) {
+		return QString("%1 us").arg(nanoseconds / 1000.0, 0, 'f', 1);
+	}
+	return QString("%1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 1);
+}
+
+namespace {
+	QString describeTimes(const FHistogram &histogram)
+	{
+		return QString("%1/%2/%3").arg(formatNanoseconds(histogram.percentile(50))).arg(formatNanoseconds(histogram.percentile(99))).arg(formatNanoseconds(histogram.max));
+	}
+
+	QString describeCounts(const FHistogram &histogram)
+	{
+		return QString("%1/%2/%3").arg(histogram.percentile(50)).arg(histogram.percentile(99)).arg(histogram.max);
+	}
+}
+
+/**
+Describe a session's traffic, one line for the batches from the worker, one for the characters online,
+and then one line per command, the command that has taken longest to handle first. Distributions are
+given as p50/p99/max.
+ */
+QStringList metricsReport(FSession *session)
+{
+	QStringList report;
+	const FHistogram &batchsizes = session->getBatchSizes();
+	const FHistogram &deferreddepths = session->getDeferredDepths();
+	report << QString("Batches: %1, frames per batch %2, batches waiting %3, deferred frames %4, high priority wait %5 (p50/p99/max)")
+		.arg(batchsizes.count)
+		.arg(describeCounts(batchsizes))
+		.arg(describeCounts(session->getBatchBacklog()))
+		.arg(describeCounts(deferreddepths))
+		.arg(describeTimes(session->getPriorityLatencies()));
+	const FRoster &roster = session->getRoster();
+	int statuses[FCharacter::STATUS_MAX];
+	roster.countStatuses(statuses);
+	QStringList statuscounts;
+	for(int i = 0; i < FCharacter::STATUS_MAX; i++) {
+		statuscounts << QString("%1 %2").arg(statuses[i]).arg(FCharacter::statusStrings[i]);
+	}
+	report << QString("Roster: %1 online (%2), %3 names, %4 profiles, %5 KiB of slots")
+		.arg(roster.count())
+		.arg(statuscounts.join(", "))
+		.arg(session->getNames().count())
+		.arg(roster.profileCount())
+		.arg(roster.memoryUsed() / 1024);
+	const QHash<quint32, FCommandStats> &stats = session->getCommandStats();
+	QList<quint32> codes = stats.keys();
+	std::sort(codes.begin(), codes.end(), [&stats](quint32 a, quint32 b) {
+		return stats[a].handlertime.total + stats[a].uitime.total > stats[b].handlertime.total + stats[b].uitime.total;
+	});
+	foreach(quint32 code, codes) {
+		const FCommandStats &s = stats[code];
+		report << QString("%1: %2 frames, %3 bytes, %4 parse failures, %5 deferred. Size %6 B, parse %7, handler %8, UI %9 (p50/p99/max)")
+			.arg(FSession::unpackCommand(code))
+			.arg(s.frames)
+			.arg(s.bytes)
+			.arg(s.parsefailures)
+			.arg(s.deferred)
+			.arg(describeCounts(s.sizes))
+			.arg(describeTimes(s.parsetime))
+			.arg(describeTimes(s.handlertime))
+			.arg(describeTimes(s.uitime));
+	}
+	return report;
+}
+
+void FTimedUserInterface::setChatOperator(FSession *session, QString characteroperator, bool opstatus)
+{
+	FTimedScope timed(total);
+	target->setChatOperator(session, characteroperator, opstatus);
+}
+
+void FTimedUserInterface::openCharacterProfile(FSession *session, QString charactername)
+{
+	FTimedScope timed(total);
+	target->openCharacterProfile(session, charactername);
+}
+
+void FTimedUserInterface::addCharacterChat(FSession *session, QString charactername)
+{
+	FTimedScope timed(total);
+	target->addCharacterChat(session, charactername);
+}
+
+void FTimedUserInterface::addChannel(FSession *session, QString name, QString title)
+{
+	FTimedScope timed(total);
+	target->addChannel(session, name, title);
+}
+
+void FTimedUserInterface::removeChannel(FSession *session, QString name)
+{
+	FTimedScope timed(total);
+	target->removeChannel(session, name);
+}
+
+void FTimedUserInterface::addChannelCharacter(FSession *session, QString channelname, QString charactername, bool notify)
+{
+	FTimedScope timed(total);
+	target->addChannelCharacter(session, channelname, charactername, notify);
+}
+
+void FTimedUserInterface::addChannelCharacters(FSession *session, QString channelname, QStringList characternames)
+{
+	FTimedScope timed(total);
+	target->addChannelCharacters(session, channelname, characternames);
+}
+
+void FTimedUserInterface::removeChannelCharacter(FSession *session, QString channelname, QString charactername)
+{
+	FTimedScope timed(total);
+	target->removeChannelCharacter(session, channelname, charactername);
+}
+
+void FTimedUserInterface::setChannelOperator(FSession *session, QString channelname, QString charactername, bool opstatus)
+{
+	FTimedScope timed(total);
+	target->setChannelOperator(session, channelname, charactername, opstatus);
+}
+
+void FTimedUserInterface::joinChannel(FSession *session, QString channelname)
+{
+	FTimedScope timed(total);
+	target->joinChannel(session, channelname);
+}
+
+void FTimedUserInterface::leaveChannel(FSession *session, QString channelname)
+{
+	FTimedScope timed(total);
+	target->leaveChannel(session, channelname);
+}
+
+void FTimedUserInterface::setChannelDescription(FSession *session, QString channelname, QString description)
+{
+	FTimedScope timed(total);
+	target->setChannelDescription(session, channelname, description);
+}
+
+void FTimedUserInterface::setChannelMode(FSession *session, QString channelname, ChannelMode mode)
+{
+	FTimedScope timed(total);
+	target->setChannelMode(session, channelname, mode);
+}
+
+void FTimedUserInterface::notifyChannelReady(FSession *session, QString channelname)
+{
+	FTimedScope timed(total);
+	target->notifyChannelReady(session, channelname);
+}
+
+bool FTimedUserInterface::isChannelVisible(FSession *session, QString channelname)
+{
+	FTimedScope timed(total);
+	return target->isChannelVisible(session, channelname);
+}
+
+void FTimedUserInterface::notifyCharacterOnline(FSession *session, QString charactername, bool online)
+{
+	FTimedScope timed(total);
+	target->notifyCharacterOnline(session, charactername, online);
+}
+
+void FTimedUserInterface::notifyCharactersOnline(FSession *session, QStringList characternames, bool online)
+{
+	FTimedScope timed(total);
+	target->notifyCharactersOnline(session, characternames, online);
+}
+
+void FTimedUserInterface::notifyCharacterStatusUpdate(FSession *session, QString charactername)
+{
+	FTimedScope timed(total);
+	target->notifyCharacterStatusUpdate(session, charactername);
+}
+
+void FTimedUserInterface::setCharacterTypingStatus(FSession *session, QString charactername, TypingStatus typingstatus)
+{
+	FTimedScope timed(total);
+	target->setCharacterTypingStatus(session, charactername, typingstatus);
+}
+
+void FTimedUserInterface::notifyCharacterCustomKinkDataUpdated(FSession *session, QString charactername)
+{
+	FTimedScope timed(total);
+	target->notifyCharacterCustomKinkDataUpdated(session, charactername);
+}
+
+void FTimedUserInterface::notifyCharacterProfileDataUpdated(FSession *session, QString charactername)
+{
+	FTimedScope timed(total);
+	target->notifyCharacterProfileDataUpdated(session, charactername);
+}
+
+void FTimedUserInterface::messageMessage(FMessage message)
+{
+	FTimedScope timed(total);
+	target->messageMessage(message);
+}
+
+void FTimedUserInterface::messageMany(FSession *session, QList<QString> &channels, QList<QString> &characters, bool system, QString message, MessageType messagetype)
+{
+	FTimedScope timed(total);
+	target->messageMany(session, channels, characters, system, message, messagetype);
+}
+
+void FTimedUserInterface::messageAll(FSession *session, QString message, MessageType messagetype)
+{
+	FTimedScope timed(total);
+	target->messageAll(session, message, messagetype);
+}
+
+void FTimedUserInterface::messageChannel(FSession *session, QString channelname, QString message, MessageType messagetype, bool console, bool notify)
+{
+	FTimedScope timed(total);
+	target->messageChannel(session, channelname, message, messagetype, console, notify);
+}
+
+void FTimedUserInterface::messageCharacter(FSession *session, QString charactername, QString message, MessageType messagetype)
+{
+	FTimedScope timed(total);
+	target->messageCharacter(session, charactername, message, messagetype);
+}
+
+void FTimedUserInterface::messageSystem(FSession *session, QString message, MessageType messagetype)
+{
+	FTimedScope timed(total);
+	target->messageSystem(session, message, messagetype);
+}
+
+void FTimedUserInterface::updateKnownChannelList(FSession *session)
+{
+	FTimedScope timed(total);
+	target->updateKnownChannelList(session);
+}
+
+void FTimedUserInterface::updateKnownOpenRoomList(FSession *session)
+{
+	FTimedScope timed(total);
+	target->updateKnownOpenRoomList(session);
+}
+
+FMetricsDumper::FMetricsDumper(FServer *server, QObject *parent) :
+	QObject(parent),
+	server(server),
+	file(),
+	timer()
+{
+	connect(&timer, &QTimer::timeout, this, &FMetricsDumper::dump);
+}
+
+/**
+Start appending a report to the file every 'interval' seconds.
+ */
+bool FMetricsDumper::open(const QString &filename, int interval)
+{
+	file.setFileName(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+		return false;
+	}
+	timer.start(qMax(1, interval) * 1000);
+	return true;
+}
+
+void FMetricsDumper::dump()
+{
+	QByteArray output;
+	QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+	foreach(FAccount *account, server->accounts) {
+		foreach(FSession *session, account->charactersessions) {
+			output += QString("[%1] %2\n").arg(now).arg(session->getSessionID()).toUtf8();
+			foreach(const QString &line, metricsReport(session)) {
+				output += line.toUtf8();
+				output += '\n';
+			}
+		}
+	}
+	file.write(output);
+	file.flush();
+}
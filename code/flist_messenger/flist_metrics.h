@@ -0,0 +1,123 @@
+#ifndef FLIST_METRICS_H
+#define FLIST_METRICS_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "flist_iuserinterface.h"
+
+class FServer;
+class FSession;
+
+/**
+A histogram with power of two buckets. Bucket 0 counts zeros and bucket n counts values from 2^(n-1)
+up to 2^n - 1, so percentiles are only good to within a factor of two, but adding a value is cheap and
+the histogram has a fixed size however spread out the values are.
+ */
+class FHistogram
+{
+public:
+	static const int bucketcount = 40; //< Enough for about nine minutes in nanoseconds, anything larger goes in the last bucket.
+
+	FHistogram();
+
+	void add(quint64 value);
+	quint64 percentile(int percent) const;
+	quint64 mean() const {return count ? total / count : 0;}
+
+	quint64 buckets[bucketcount];
+	quint64 count; //< Number of values added.
+	quint64 total; //< Sum of the values added.
+	quint64 max; //< Largest value added.
+};
+
+/**
+Adds the time until the end of the enclosing scope to a running total in nanoseconds.
+ */
+class FTimedScope
+{
+public:
+	explicit FTimedScope(qint64 &total) : total(total), timer() {timer.start();}
+	~FTimedScope() {total += timer.nsecsElapsed();}
+
+private:
+	qint64 &total;
+	QElapsedTimer timer;
+};
+
+/**
+Passes every call on to another user interface, adding the time each takes to a running total in
+nanoseconds. The clock only starts once the call's arguments have been worked out, so building the
+message text is not counted as time in the interface. FSession::ui() returns one of these.
+ */
+class FTimedUserInterface : public iUserInterface
+{
+public:
+	FTimedUserInterface(iUserInterface *&target, qint64 &total) : target(target), total(total) {}
+
+	virtual FSession *getSession(QString sessionid) {return target->getSession(sessionid);}
+
+	virtual void setChatOperator(FSession *session, QString characteroperator, bool opstatus);
+	virtual void openCharacterProfile(FSession *session, QString charactername);
+	virtual void addCharacterChat(FSession *session, QString charactername);
+	virtual void addChannel(FSession *session, QString name, QString title);
+	virtual void removeChannel(FSession *session, QString name);
+	virtual void addChannelCharacter(FSession *session, QString channelname, QString charactername, bool notify);
+	virtual void addChannelCharacters(FSession *session, QString channelname, QStringList characternames);
+	virtual void removeChannelCharacter(FSession *session, QString channelname, QString charactername);
+	virtual void setChannelOperator(FSession *session, QString channelname, QString charactername, bool opstatus);
+	virtual void joinChannel(FSession *session, QString channelname);
+	virtual void leaveChannel(FSession *session, QString channelname);
+	virtual void setChannelDescription(FSession *session, QString channelname, QString description);
+	virtual void setChannelMode(FSession *session, QString channelname, ChannelMode mode);
+	virtual void notifyChannelReady(FSession *session, QString channelname);
+	virtual bool isChannelVisible(FSession *session, QString channelname);
+	virtual void notifyCharacterOnline(FSession *session, QString charactername, bool online);
+	virtual void notifyCharactersOnline(FSession *session, QStringList characternames, bool online);
+	virtual void notifyCharacterStatusUpdate(FSession *session, QString charactername);
+	virtual void setCharacterTypingStatus(FSession *session, QString charactername, TypingStatus typingstatus);
+	virtual void notifyCharacterCustomKinkDataUpdated(FSession *session, QString charactername);
+	virtual void notifyCharacterProfileDataUpdated(FSession *session, QString charactername);
+	virtual void messageMessage(FMessage message);
+	virtual void messageMany(FSession *session, QList<QString> &channels, QList<QString> &characters, bool system, QString message, MessageType messagetype);
+	virtual void messageAll(FSession *session, QString message, MessageType messagetype);
+	virtual void messageChannel(FSession *session, QString channelname, QString message, MessageType messagetype, bool console, bool notify);
+	virtual void messageCharacter(FSession *session, QString charactername, QString message, MessageType messagetype);
+	virtual void messageSystem(FSession *session, QString message, MessageType messagetype);
+	virtual void updateKnownChannelList(FSession *session);
+	virtual void updateKnownOpenRoomList(FSession *session);
+
+private:
+	iUserInterface *&target; //< The interface being timed, the account's, which can be set after the session is made.
+	qint64 &total;
+};
+
+/**
+Periodically appends a metrics report for every session on the server to a file, for when '/stats' is
+too late to catch a stall. Started with -stats.
+ */
+class FMetricsDumper : public QObject
+{
+Q_OBJECT
+public:
+	explicit FMetricsDumper(FServer *server, QObject *parent = 0);
+
+	bool open(const QString &filename, int interval);
+
+private slots:
+	void dump();
+
+private:
+	FServer *server;
+	QFile file;
+	QTimer timer;
+};
+
+QString formatNanoseconds(quint64 nanoseconds);
+QStringList metricsReport(FSession *session);
+
+#endif // FLIST_METRICS_H
@@ -0,0 +1,78 @@
+#include "flist_names.h"
+
+FNameTable::FNameTable() :
+	names(),
+	keys(),
+	ids(),
+	freeids()
+{
+	names.append(QString());
+	keys.append(QString());
+}
+
+/**
+The ID for this name, giving it a new one if it hasn't been seen before in any case.
+ */
+FCharacterId FNameTable::intern(const QString &name)
+{
+	if(name.isEmpty()) {
+		return 0;
+	}
+	FCharacterId id = ids.value(name, 0);
+	if(id) {
+		return id;
+	}
+	QString key = name.toLower();
+	id = ids.value(key, 0);
+	if(!id) {
+		if(!freeids.isEmpty()) {
+			id = freeids.takeLast();
+			names[id] = name;
+			keys[id] = key;
+		} else {
+			id = (FCharacterId)names.size();
+			names.append(name);
+			keys.append(key);
+		}
+		ids.insert(key, id);
+	}
+	ids.insert(name, id);
+	return id;
+}
+
+/**
+The ID for this name in any case, or 0 if it has never been interned.
+ */
+FCharacterId FNameTable::find(const QString &name) const
+{
+	if(name.isEmpty()) {
+		return 0;
+	}
+	FCharacterId id = ids.value(name, 0);
+	if(id) {
+		return id;
+	}
+	return ids.value(name.toLower(), 0);
+}
+
+/**
+Forget every name whose ID isn't in 'live', so that its ID can be given out again. Anything still holding one of
+those IDs would find it meaning somebody else, so 'live' has to cover every ID that is kept anywhere.
+ */
+void FNameTable::sweep(const QSet<FCharacterId> &live)
+{
+	for(QHash<QString, FCharacterId>::iterator i = ids.begin(); i != ids.end();) {
+		if(live.contains(i.value())) {
+			++i;
+		} else {
+			i = ids.erase(i);
+		}
+	}
+	for(FCharacterId id = 1; id < (FCharacterId)names.size(); id++) {
+		if(!keys.at(id).isEmpty() && !live.contains(id)) {
+			names[id] = QString();
+			keys[id] = QString();
+			freeids.append(id);
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef FLIST_NAMES_H
+#define FLIST_NAMES_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+typedef quint32 FCharacterId; //< A character's index in an FNameTable. 0 is never given out, so it can mean "nobody".
+
+/**
+Gives every character name seen by a session a small integer ID, so that rosters, operator lists, friends and
+ignores can hold IDs and compare them instead of hashing and lowercasing strings on every lookup.
+
+Names are case insensitive, so there is one ID per lowercase key, and name() is the spelling it was first seen with.
+Lookups try the exact spelling first and only lowercase the name when that misses. intern() remembers every spelling
+it is given, so a name is normally lowercased once per session however often it is looked up. An ID stays valid until
+sweep() is told nothing refers to it any more, after which intern() can give it to another name.
+ */
+class FNameTable
+{
+public:
+	FNameTable();
+
+	FCharacterId intern(const QString &name);
+	FCharacterId find(const QString &name) const;
+	void sweep(const QSet<FCharacterId> &live);
+
+	const QString &name(FCharacterId id) const {return names.at(id < (FCharacterId)names.size() ? id : 0);}
+	const QString &key(FCharacterId id) const {return keys.at(id < (FCharacterId)keys.size() ? id : 0);}
+	int count() const {return names.size() - 1 - freeids.size();}
+
+private:
+	QVector<QString> names; //< Spelling each ID was first seen with, indexed by ID. Slot 0 is the empty name.
+	QVector<QString> keys; //< Lowercase key for each ID, indexed by ID.
+	QHash<QString, FCharacterId> ids; //< Every key and spelling seen so far, to its ID.
+	QVector<FCharacterId> freeids; //< IDs given back by sweep(), for intern() to use before making new ones.
+};
+
+#endif // FLIST_NAMES_H
@@ -0,0 +1,119 @@
+#include "flist_replay.h"
+
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QEvent>
+
+#include "flist_global.h"
+#include "flist_capture.h"
+#include "flist_server.h"
+#include "flist_account.h"
+#include "flist_session.h"
+#include "flist_metrics.h"
+
+FSession *FReplayInterface::getSession(QString sessionid)
+{
+	calls++;
+	return session && session->getSessionID() == sessionid ? session : 0;
+}
+
+/**
+Feed the server frames from a capture file into a session, with no network and no GUI, then print
+how long it took. Only the first session in the capture is replayed. Frames with the same timestamp
+are handed over as one batch, as the session worker would have. Unless 'realtime' is set, the frames
+are replayed as fast as possible.
+
+If 'latencylimit' is set, the replay fails when the 99th percentile of how long high priority frames
+waited to be handled goes over that many milliseconds. That is the check that private messages and
+errors still get through promptly while a capture of a flood is replayed.
+ */
+int runReplay(QString filename, bool realtime, int latencylimit)
+{
+	QTextStream out(stdout);
+	FCaptureReader reader;
+	if(!reader.open(filename)) {
+		out << "Could not open the capture '" << filename << "': " << reader.errorString() << "\n";
+		return 1;
+	}
+	//There's no connection to send replies on, so don't complain about every one of them.
+	FLog::setLevel(LogCategory::Session, LogLevel::Error);
+
+	FServer server;
+	FAccount *account = server.addAccount();
+	FReplayInterface ui;
+	account->ui = &ui;
+
+	quint64 frames = 0, bytes = 0, skipped = 0;
+	//Both in nanoseconds.
+	qint64 decodetime = 0, dispatchtime = 0;
+	QElapsedTimer clock;
+	clock.start();
+	FCaptureRecord record;
+	bool more = reader.next(record);
+	while(more) {
+		if(record.direction != FCapture::Inbound) {
+			skipped++;
+			more = reader.next(record);
+			continue;
+		}
+		if(!ui.session) {
+			ui.session = account->addSession(record.sessionid);
+		}
+		qint64 batchtime = record.time;
+		if(realtime) {
+			qint64 wait = batchtime - clock.elapsed();
+			if(wait > 0) {
+				QThread::msleep(wait);
+			}
+		}
+		QElapsedTimer steptimer;
+		steptimer.start();
+		FSessionFrameBatch batch(new QList<FSessionFrame>());
+		do {
+			if(record.direction == FCapture::Inbound && record.sessionid == ui.session->getSessionID()) {
+				batch->append(FSessionFrame::decode(record.frame));
+				frames++;
+				bytes += record.frame.size();
+			} else {
+				skipped++;
+			}
+			more = reader.next(record);
+		} while(more && record.time == batchtime && batch->count() < FSessionWorker::maxbatchsize);
+		decodetime += steptimer.nsecsElapsed();
+		steptimer.restart();
+		ui.session->processFrames(batch);
+		//Give deferred frames the one turn of the event loop they would have had before the next batch.
+		QCoreApplication::sendPostedEvents(ui.session, QEvent::MetaCall);
+		dispatchtime += steptimer.nsecsElapsed();
+	}
+	if(ui.session) {
+		QElapsedTimer steptimer;
+		steptimer.start();
+		while(ui.session->getDeferredFrameCount() > 0) {
+			QCoreApplication::sendPostedEvents(ui.session, QEvent::MetaCall);
+		}
+		dispatchtime += steptimer.nsecsElapsed();
+	}
+	qint64 elapsed = clock.elapsed();
+	if(!reader.errorString().isEmpty()) {
+		out << reader.errorString() << "\n";
+		return 1;
+	}
+
+	out << "Replayed " << frames << " frames (" << bytes << " bytes) in " << elapsed << " ms.\n";
+	out << "Decoding: " << decodetime / 1000000 << " ms, dispatch: " << dispatchtime / 1000000 << " ms.\n";
+	out << "Interface calls: " << ui.calls << ", messages: " << ui.messages << ", frames skipped: " << skipped << "\n";
+	if(ui.session) {
+		foreach(const QString &line, metricsReport(ui.session)) {
+			out << line << "\n";
+		}
+		quint64 latency = ui.session->getPriorityLatencies().percentile(99);
+		if(latencylimit > 0 && latency > (quint64)latencylimit * 1000000) {
+			out << "High priority frames waited " << formatNanoseconds(latency) << " (p99), over the limit of " << latencylimit << " ms.\n";
+			return 2;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef FLIST_REPLAY_H
+#define FLIST_REPLAY_H
+
+#include "flist_iuserinterface.h"
+#include "flist_message.h"
+
+/**
+A user interface that does nothing but count how often it is called. Used to replay captures without a GUI.
+ */
+class FReplayInterface : public iUserInterface
+{
+public:
+	FReplayInterface() : session(0), calls(0), messages(0) {}
+
+	virtual FSession *getSession(QString sessionid);
+
+	virtual void setChatOperator(FSession *, QString, bool) {calls++;}
+
+	virtual void openCharacterProfile(FSession *, QString) {calls++;}
+	virtual void addCharacterChat(FSession *, QString) {calls++;}
+
+	virtual void addChannel(FSession *, QString, QString) {calls++;}
+	virtual void removeChannel(FSession *, QString) {calls++;}
+	virtual void addChannelCharacter(FSession *, QString, QString, bool) {calls++;}
+	virtual void addChannelCharacters(FSession *, QString, QStringList) {calls++;}
+	virtual void removeChannelCharacter(FSession *, QString, QString) {calls++;}
+	virtual void setChannelOperator(FSession *, QString, QString, bool) {calls++;}
+	virtual void joinChannel(FSession *, QString) {calls++;}
+	virtual void leaveChannel(FSession *, QString) {calls++;}
+	virtual void setChannelDescription(FSession *, QString, QString) {calls++;}
+	virtual void setChannelMode(FSession *, QString, ChannelMode) {calls++;}
+	virtual void notifyChannelReady(FSession *, QString) {calls++;}
+	virtual bool isChannelVisible(FSession *, QString) {calls++; return false;}
+
+	virtual void notifyCharacterOnline(FSession *, QString, bool) {calls++;}
+	virtual void notifyCharactersOnline(FSession *, QStringList, bool) {calls++;}
+	virtual void notifyCharacterStatusUpdate(FSession *, QString) {calls++;}
+	virtual void setCharacterTypingStatus(FSession *, QString, TypingStatus) {calls++;}
+	virtual void notifyCharacterCustomKinkDataUpdated(FSession *, QString) {calls++;}
+	virtual void notifyCharacterProfileDataUpdated(FSession *, QString) {calls++;}
+
+	virtual void messageMessage(FMessage) {calls++; messages++;}
+	virtual void messageMany(FSession *, QList<QString> &, QList<QString> &, bool, QString, MessageType) {calls++; messages++;}
+	virtual void messageAll(FSession *, QString, MessageType) {calls++; messages++;}
+	virtual void messageChannel(FSession *, QString, QString, MessageType, bool, bool) {calls++; messages++;}
+	virtual void messageCharacter(FSession *, QString, QString, MessageType) {calls++; messages++;}
+	virtual void messageSystem(FSession *, QString, MessageType) {calls++; messages++;}
+
+	virtual void updateKnownChannelList(FSession *) {calls++;}
+	virtual void updateKnownOpenRoomList(FSession *) {calls++;}
+
+	FSession *session; //< The session being replayed into.
+	quint64 calls; //< Total calls made to the interface.
+	quint64 messages; //< How many of those calls were messages.
+};
+
+int runReplay(QString filename, bool realtime, int latencylimit);
+
+#endif // FLIST_REPLAY_H
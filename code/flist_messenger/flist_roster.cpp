@@ -0,0 +1,136 @@
+#include "flist_roster.h"
+#include "flist_characterprofile.h"
+
+FRoster::FRoster() :
+	blocks(),
+	idslots(),
+	freeslots(),
+	usedslots(0),
+	profiles()
+{
+}
+
+FRoster::~FRoster()
+{
+	clear();
+	foreach(FCharacter *block, blocks) {
+		delete[] block;
+	}
+}
+
+/**
+Put a character in a slot, reusing the last one given back if there is one, and allocating a new block if every
+slot is in use. A character that is already online is left as they are.
+ */
+FCharacter *FRoster::add(FCharacterId id, const QString &name, bool friended)
+{
+	if(FCharacter *character = get(id)) {
+		return character;
+	}
+	int slot;
+	if(!freeslots.isEmpty()) {
+		slot = freeslots.takeLast();
+	} else {
+		slot = usedslots++;
+		if((slot >> blockbits) >= blocks.size()) {
+			blocks.append(new FCharacter[blocksize]);
+		}
+	}
+	if(id >= (FCharacterId)idslots.size()) {
+		idslots.resize(id + 1);
+	}
+	idslots[id] = slot + 1;
+	FCharacter *character = at(slot);
+	*character = FCharacter(id, name, friended);
+	return character;
+}
+
+/**
+Empty a character's slot and give it back, and throw away their profile data if they had any.
+ */
+void FRoster::remove(FCharacterId id)
+{
+	FCharacter *character = get(id);
+	if(!character) {
+		return;
+	}
+	int slot = idslots.at(id) - 1;
+	*character = FCharacter();
+	idslots[id] = 0;
+	if(slot == usedslots - 1) {
+		usedslots--;
+	} else {
+		freeslots.append(slot);
+	}
+	delete profiles.take(id);
+}
+
+/**
+Take everyone offline. The blocks are kept for the next time they come online.
+ */
+void FRoster::clear()
+{
+	for(int slot = 0; slot < usedslots; slot++) {
+		FCharacter *character = at(slot);
+		if(character->id()) {
+			*character = FCharacter();
+		}
+	}
+	idslots.clear();
+	freeslots.clear();
+	usedslots = 0;
+	qDeleteAll(profiles);
+	profiles.clear();
+}
+
+/**
+Add the ID of everyone online to 'ids'.
+ */
+void FRoster::collectIds(QSet<FCharacterId> &ids) const
+{
+	for(int slot = 0; slot < usedslots; slot++) {
+		FCharacter *character = at(slot);
+		if(character->id()) {
+			ids.insert(character->id());
+		}
+	}
+}
+
+/**
+Count how many characters online have each status, in one pass over the slots in use.
+ */
+void FRoster::countStatuses(int counts[FCharacter::STATUS_MAX]) const
+{
+	for(int i = 0; i < FCharacter::STATUS_MAX; i++) {
+		counts[i] = 0;
+	}
+	for(int slot = 0; slot < usedslots; slot++) {
+		FCharacter *character = at(slot);
+		if(character->id()) {
+			counts[character->status()]++;
+		}
+	}
+}
+
+/**
+The profile and kink data for a character, created empty the first time it is asked for.
+ */
+FCharacterProfile *FRoster::profile(FCharacterId id)
+{
+	FCharacterProfile *&profile = profiles[id];
+	if(!profile) {
+		profile = new FCharacterProfile();
+	}
+	return profile;
+}
+
+/**
+Bytes taken up by the slots and the tables that find them. Strings they refer to are not counted.
+ */
+qint64 FRoster::memoryUsed() const
+{
+	qint64 bytes = (qint64)blocks.capacity() * sizeof(FCharacter *);
+	bytes += (qint64)blocks.size() * blocksize * sizeof(FCharacter);
+	bytes += (qint64)(idslots.capacity() + freeslots.capacity()) * sizeof(int);
+	return bytes;
+}
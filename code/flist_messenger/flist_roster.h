@@ -0,0 +1,61 @@
+#ifndef FLIST_ROSTER_H
+#define FLIST_ROSTER_H
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+#include "flist_character.h"
+#include "flist_names.h"
+
+class FCharacterProfile;
+
+/**
+Every character that is online in a session. Characters are kept in slots, blocksize slots to a block, and idslots
+gives the slot for each FCharacterId, so finding one is three array lookups. A character going offline gives their
+slot back for the next one to come online, so however their IDs are spread out, the slots in use stay packed at the
+front and a scan of everyone online only walks the slots that have been used. Blocks never move once allocated, so
+an FCharacter pointer stays valid for as long as its character is online. After that the slot may go to someone else.
+
+Only presence data is kept in the slots. Profile and custom kink data is only wanted for the few characters whose
+profile has been opened, so that goes in a separate table and is only created by profile().
+ */
+class FRoster
+{
+public:
+	static const int blockbits = 10;
+	static const int blocksize = 1 << blockbits;
+
+	FRoster();
+	~FRoster();
+
+	FCharacter *add(FCharacterId id, const QString &name, bool friended);
+	FCharacter *get(FCharacterId id) const {
+		int slot = id < (FCharacterId)idslots.size() ? idslots.at(id) : 0;
+		return slot ? at(slot - 1) : 0;
+	}
+	void remove(FCharacterId id);
+	void clear();
+	int count() const {return usedslots - freeslots.size();}
+	void collectIds(QSet<FCharacterId> &ids) const;
+	void countStatuses(int counts[FCharacter::STATUS_MAX]) const;
+
+	FCharacterProfile *profile(FCharacterId id);
+	FCharacterProfile *findProfile(FCharacterId id) const {return profiles.value(id, 0);}
+	int profileCount() const {return profiles.size();}
+	qint64 memoryUsed() const;
+
+private:
+	FRoster(const FRoster &);
+	FRoster &operator=(const FRoster &);
+
+	FCharacter *at(int slot) const {return &blocks.at(slot >> blockbits)[slot & (blocksize - 1)];}
+
+	QVector<FCharacter *> blocks; //< Arrays of blocksize slots, allocated in order as they're needed. An empty slot has an ID of 0.
+	QVector<int> idslots; //< One more than the slot each ID is in, indexed by ID, or 0 for a character who isn't online.
+	QVector<int> freeslots; //< Empty slots below usedslots, filled before any new ones are used.
+	int usedslots; //< Number of slots that have been handed out since the roster was last cleared. All the ones above are empty.
+	QHash<FCharacterId, FCharacterProfile *> profiles; //< Profile and kink data, for characters that have had it requested.
+};
+
+#endif // FLIST_ROSTER_H
@@ -3,10 +3,11 @@
 #include "flist_global.h"
 #include "flist_account.h"
 #include "flist_character.h"
+#include "flist_settings.h"
 
 FServer::FServer(QObject *parent) :
 	QObject(parent),
-    chatserver_url(FLIST_CHAT_SERVER),
+    chatserver_url(settings->getChatServer()),
 	accounts()
 {
 }
@@ -1,5 +1,7 @@
 
 #include <QTime>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QtWebSockets/QWebSocket>
 
 #include "flist_session.h"
@@ -7,62 +9,91 @@
 #include "flist_global.h"
 #include "flist_server.h"
 #include "flist_character.h"
+#include "flist_characterprofile.h"
 #include "flist_iuserinterface.h"
 #include "flist_channel.h"
 #include "flist_parser.h"
 #include "flist_message.h"
+#include "flist_capture.h"
 
 
 #include "../libjson/libJSON.h"
 
+namespace {
+	//Fields for beginCommand(). QStrings are written straight from their UTF-16 without a UTF-8 copy.
+	void writeField(JSONStreamWriter &out, const char *name, const QString &value) {
+		out.key(name).string(value.utf16(), (size_t)value.size());
+	}
+
+	void writeField(JSONStreamWriter &out, const char *name, const std::string &value) {
+		out.key(name).string(value);
+	}
+
+	void writeField(JSONStreamWriter &out, const char *name, const char *value) {
+		out.key(name).string(value);
+	}
+
+	//A string field of a frame's JSON, or an empty string if the frame doesn't have one by that name.
+	QString frameString(const FSessionFrame &frame, const json_string &name) {
+		const JSONNode *node = frame.nodes.try_at(name);
+		if(!node || node->type() != JSON_STRING) {
+			return QString();
+		}
+		json_string value = node->as_string();
+		return QString::fromUtf8(value.data(), (int)value.size());
+	}
+}
+
 FSession::FSession(FAccount *account, QString &character, QObject *parent) :
 	QObject(parent),
 	account(account),
 	sessionid(character),
 	character(character),
-    socket(nullptr),
-	characterlist(),
+	workerthread(nullptr),
+	worker(nullptr),
+	socketerrorstring(),
+	names(),
+	namesweepsize(namesweepminimum),
+	roster(),
 	friendslist(),
 	bookmarklist(),
 	operatorlist(),
 	ignorelist(),
+	ignoreids(),
 	channellist(),
 	joinQueue(),
+	sendbuffer(),
+	deferredframes(),
+	deferredqueued(false),
+	batchsizes(),
+	batchbacklog(),
+	deferreddepths(),
+	prioritylatencies(),
+	uitime(0),
+	timedui(account->ui, uitime),
 	autojoinchannels(),
 	servervariables(),
 	knownchannellist(),
 	knownopenroomlist()
 {
+	registerCommands();
 }
 
 FSession::~FSession()
 {
-	if(socket) {
-		socket->abort();
-		socket->deleteLater();
-	}
+	stopWorker();
 }
 
 FCharacter *FSession::addCharacter(QString name)
 {
-	FCharacter *character = getCharacter(name);
+	FCharacterId id = names.intern(name);
+	FCharacter *character = roster.get(id);
 	if(!character) {
-		character = new FCharacter(name, friendslist.contains(name));
-		characterlist[name] = character;
+		character = roster.add(id, name, friendslist.contains(id));
 	}
 	return character;
 }
 
-void FSession::removeCharacter(QString name)
-{
-	//Get and remove the character from the list.
-	FCharacter *character = characterlist.take(name);
-	//Delete if not null.
-	if(character) {
-		delete character;
-	}
-}
-
 /**
 Convert a character's name into a formated hyperlinked HTML text. It will use the correct colors if they're known.
  */
@@ -92,9 +123,9 @@ void FSession::joinChannel(QString name)
 {
 	if(joinQueue.empty())
 	{
-		JSONNode joinnode;
-		joinnode.push_back(JSONNode("channel", name.toStdString()));
-		wsSend("JCH", joinnode);
+		JSONStreamWriter &out = beginCommand("JCH");
+		writeField(out, "channel", name);
+		sendCommand();
 	}
 	joinQueue.enqueue(name);
 }
@@ -105,29 +136,25 @@ void FSession::processJoinQueue()
 	if(!joinQueue.empty())
 	{
 		QString chan = joinQueue.head();
-		JSONNode joinnode;
-		joinnode.push_back(JSONNode("channel", chan.toStdString()));
-		wsSend("JCH", joinnode);
+		JSONStreamWriter &out = beginCommand("JCH");
+		writeField(out, "channel", chan);
+		sendCommand();
 	}
 }
 
 void FSession::createPublicChannel(QString name)
 {
 	// [0:59 AM]>>CRC {"channel":"test"}
-	JSONNode node;
-	JSONNode channode ( "channel", name.toStdString() );
-	node.push_back ( channode );
-	std::string out = "CRC " + node.write();
-	wsSend( out );
+	JSONStreamWriter &out = beginCommand("CRC");
+	writeField(out, "channel", name);
+	sendCommand();
 }
 void FSession::createPrivateChannel(QString name)
 {
 	// [17:24 PM]>>CCR {"channel":"abc"}
-	JSONNode makenode;
-	JSONNode namenode ( "channel", name.toStdString() );
-	makenode.push_back ( namenode );
-	std::string out = "CCR " + makenode.write();
-	wsSend ( out );
+	JSONStreamWriter &out = beginCommand("CCR");
+	writeField(out, "channel", name);
+	sendCommand();
 }
 
 FChannel *FSession::addChannel(QString name, QString title)
@@ -152,49 +179,67 @@ FChannel *FSession::getChannel(QString name)
 }
 
 
-//todo: All the web socket stuff should really go into its own class.
+/**
+Start the worker thread and have it open the connection. The socket lives on the worker thread, frames
+come back to processFrames() already parsed and in batches, and are handled on this thread.
+ */
 void FSession::connectSession()
 {
-	debugMessage("session->connectSession()");
-	if(socket) {
+	FLOG(Session, Debug, "session->connectSession()");
+	if(worker) {
 		return;
 	}
-	
-	socket = new QWebSocket("file:///", QWebSocketProtocol::VersionLatest, this);
-	connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, &FSession::socketError);
-	connect(socket, &QWebSocket::sslErrors, this, &FSession::socketSslError);
-	connect(socket, &QWebSocket::connected, this, &FSession::socketConnected);
-	connect(socket, &QWebSocket::textMessageReceived, this, &FSession::socketReceivedTextMessage);
-	socket->open(QUrl(account->server->chatserver_url));
-	debugMessage("Connecting...");
+
+	qRegisterMetaType<QAbstractSocket::SocketError>();
+	qRegisterMetaType<QList<QSslError> >();
+	qRegisterMetaType<FSessionFrameBatch>();
+
+	workerthread = new QThread(this);
+	worker = new FSessionWorker(sessionid);
+	worker->moveToThread(workerthread);
+	connect(workerthread, &QThread::finished, worker, &QObject::deleteLater);
+	connect(worker, &FSessionWorker::error, this, &FSession::socketError);
+	connect(worker, &FSessionWorker::sslErrors, this, &FSession::socketSslError);
+	connect(worker, &FSessionWorker::connected, this, &FSession::socketConnected);
+	connect(worker, &FSessionWorker::framesReceived, this, &FSession::processFrames);
+	workerthread->start();
+	QMetaObject::invokeMethod(worker, "open", Qt::QueuedConnection, Q_ARG(QUrl, QUrl(account->server->chatserver_url)));
+	FLOG(Session, Info, "Connecting...");
+}
+
+void FSession::stopWorker()
+{
+	if(!worker) {
+		return;
+	}
+	//The worker deletes itself, and with it the socket, when the thread finishes.
+	worker = nullptr;
+	workerthread->quit();
+	workerthread->wait();
+	workerthread->deleteLater();
+	workerthread = nullptr;
+}
+
+void FSession::sendTextMessage(const QString &message)
+{
+	if(!worker) {
+		FLOG(Session, Warning, "Tried to send a message, but the session is not connected.");
+		return;
+	}
+	QMetaObject::invokeMethod(worker, "sendTextMessage", Qt::QueuedConnection, Q_ARG(QString, message));
 }
 
 void FSession::socketConnected()
 {
-	debugMessage("Connected.");
-	
-	JSONNode loginnode;
-	loginnode.push_back(JSONNode("method", "ticket"));
-	loginnode.push_back(JSONNode("ticket", account->ticket.toStdString()));
-	loginnode.push_back(JSONNode("account", account->getUserName().toStdString()));
-	loginnode.push_back(JSONNode("cname", FLIST_CLIENTID));
-	loginnode.push_back(JSONNode("cversion", FLIST_VERSIONNUM));
-	loginnode.push_back(JSONNode("character", character.toStdString()));
-	std::string idenStr = "IDN " + loginnode.write();
-	
-	QString msg = QString::fromStdString(idenStr);
-	
-	socket->sendTextMessage(msg);
+	FLOG(Session, Info, "Connected.");
+	sendIdentity();
 }
 
-void FSession::socketError(QAbstractSocket::SocketError error)
+void FSession::socketError(QAbstractSocket::SocketError error, QString errorstring)
 {
+	socketerrorstring = errorstring;
 	emit socketErrorSignal(error);
-	if(socket) {
-		socket->abort();
-		socket->deleteLater();
-		socket = nullptr;
-	}
+	stopWorker();
 }
 
 void FSession::socketSslError(QList<QSslError> sslerrors)
@@ -211,109 +256,407 @@ void FSession::socketSslError(QList<QSslError> sslerrors)
 	//messageSystem(0, errorstring, MessageType::Error);
 	QString message = QString("SSL Socket Error: %1").arg(errorstring);
 	//todo: This should really display message box.
-	account->ui->messageSystem(this, message, MessageType::Error);
-	debugMessage(message);
+	ui()->messageSystem(this, message, MessageType::Error);
+	FLOG(Network, Error, message);
+}
+
+/**
+Dispatch a batch of frames from the worker. Normally they're dispatched in the order they arrived.
+When the session falls behind, because the batch is large, because it waited more than backloglatency
+for the GUI thread, or because frames are already deferred, low priority frames are queued up and
+dispatched a few milliseconds at a time from the event loop. That way private messages, errors and the
+visible channel don't wait behind a flood in some other channel. How long high priority frames waited
+is kept in prioritylatencies, which '/stats' and '-replay' report.
+
+Only chatter in background channels is ever deferred; joins, leaves and everything else that changes
+the roster or member lists are handled in order and never coalesced, as the UI reads those lists.
+When a character goes offline, leaves or is kicked, the deferred frames in every channel they have
+something waiting in are dispatched first, so none of them refers to someone who has already gone.
+ */
+void FSession::processFrames(FSessionFrameBatch frames)
+{
+	static const json_string characterfield = "character", channelfield = "channel";
+	static const quint32 fln = packCommand("FLN"), lch = packCommand("LCH"), cbu = packCommand("CBU"), cku = packCommand("CKU");
+	if(worker) {
+		batchbacklog.add(worker->batchHandled());
+	}
+	bool backlog = frames->count() >= backlogthreshold || !deferredframes.isEmpty()
+		|| (!frames->isEmpty() && FSessionFrame::clock() - frames->first().received > backloglatency * Q_INT64_C(1000000));
+	for(QList<FSessionFrame>::iterator i = frames->begin(); i != frames->end(); ++i) {
+		quint32 code = packCommand(i->packet.constData(), i->packet.length());
+		QString channelname;
+		FramePriority priority = framePriority(code, *i, channelname);
+		if(backlog && priority == FramePriority::Low) {
+			commandstats[code].deferred++;
+			deferredframes.enqueue(FDeferredFrame(*i, channelname, names.find(frameString(*i, characterfield))));
+			continue;
+		}
+		if(!deferredframes.isEmpty() && i->valid && (code == fln || code == lch || code == cbu || code == cku)) {
+			flushDeferredFrames(frameString(*i, characterfield), frameString(*i, channelfield));
+		}
+		if(priority == FramePriority::High) {
+			prioritylatencies.add(FSessionFrame::clock() - i->received);
+		}
+		dispatchFrame(*i);
+	}
+	batchsizes.add(frames->count());
+	deferreddepths.add(deferredframes.count());
+	if(names.count() >= namesweepsize) {
+		sweepNames();
+	}
+	if(!deferredframes.isEmpty() && !deferredqueued) {
+		deferredqueued = true;
+		QMetaObject::invokeMethod(this, "processDeferredFrames", Qt::QueuedConnection);
+	}
 }
 
-void FSession::socketReceivedTextMessage(const QString &message) {
-	wsRecv(message.toStdString());
+void FSession::processDeferredFrames()
+{
+	deferredqueued = false;
+	QElapsedTimer timer;
+	timer.start();
+	while(!deferredframes.isEmpty() && timer.elapsed() < deferredbudget) {
+		FDeferredFrame deferred = deferredframes.dequeue();
+		dispatchFrame(deferred.frame);
+	}
+	if(!deferredframes.isEmpty()) {
+		deferredqueued = true;
+		QMetaObject::invokeMethod(this, "processDeferredFrames", Qt::QueuedConnection);
+	}
+}
+
+/**
+Give back the IDs of names that nothing refers to any more, so that the name table doesn't grow with every
+character that has ever been seen. A name is kept while its character is online, a friend, an operator,
+ignored, in a channel's lists, or has a deferred frame waiting. Handlers only hold IDs while they run, so
+this is only called between batches. The next sweep is once the table has doubled, so the cost of a sweep
+is spread over the names interned since the last one.
+ */
+void FSession::sweepNames()
+{
+	QSet<FCharacterId> live = friendslist;
+	live.unite(operatorlist);
+	live.unite(ignoreids);
+	roster.collectIds(live);
+	foreach(FChannel *channel, channellist) {
+		channel->collectIds(live);
+	}
+	foreach(const FDeferredFrame &deferred, deferredframes) {
+		live.insert(deferred.character);
+	}
+	live.insert(names.find(character));
+	names.sweep(live);
+	namesweepsize = names.count() * 2;
+	if(namesweepsize < namesweepminimum) {
+		namesweepsize = namesweepminimum;
+	}
+	FLOG(Session, Debug, QString("Swept the name table down to %1 names.").arg(names.count()));
+}
+
+/**
+Dispatch the deferred frames that have to be handled before a character departs. That is everything
+deferred in each channel the character has a frame waiting in, or only in 'channelname' if they are
+leaving just that channel. If it is our own character leaving, everything deferred in the channel goes.
+Whole channels are flushed, in order, so that the messages in a channel are never reordered.
+ */
+void FSession::flushDeferredFrames(const QString &charactername, const QString &channelname)
+{
+	FCharacterId id = names.find(charactername);
+	if(!id) {
+		return;
+	}
+	QSet<QString> channels;
+	if(!channelname.isEmpty() && id == names.find(character)) {
+		channels.insert(channelname);
+	}
+	foreach(const FDeferredFrame &deferred, deferredframes) {
+		if(deferred.character == id && (channelname.isEmpty() || deferred.channel == channelname)) {
+			channels.insert(deferred.channel);
+		}
+	}
+	if(channels.isEmpty()) {
+		return;
+	}
+	QQueue<FDeferredFrame> pending;
+	pending.swap(deferredframes);
+	for(QQueue<FDeferredFrame>::iterator i = pending.begin(); i != pending.end(); ++i) {
+		if(channels.contains(i->channel)) {
+			dispatchFrame(i->frame);
+		} else {
+			deferredframes.enqueue(*i);
+		}
+	}
+}
+
+/**
+Classify a frame for processFrames(). Private messages, errors, staff alerts and the real time bridge are
+high priority, as is chatter in the channel on screen. Chatter in every other channel is low priority.
+The channel a chatter frame is for is left in 'channelname'.
+ */
+FramePriority FSession::framePriority(quint32 code, const FSessionFrame &frame, QString &channelname)
+{
+	static const json_string channelfield = "channel";
+	static const quint32 msg = packCommand("MSG"), lrp = packCommand("LRP"), rll = packCommand("RLL");
+	static const quint32 pri = packCommand("PRI"), err = packCommand("ERR"), sfc = packCommand("SFC"), rtb = packCommand("RTB");
+	if(code == pri || code == err || code == sfc || code == rtb) {
+		return FramePriority::High;
+	}
+	if(!frame.valid || (code != msg && code != lrp && code != rll)) {
+		return FramePriority::Normal;
+	}
+	channelname = frameString(frame, channelfield);
+	if(channelname.isEmpty()) {
+		//A roll in a private conversation.
+		return FramePriority::High;
+	}
+	//Not through ui(), this is scheduling and not time the handlers spend in the interface.
+	return account->ui->isChannelVisible(this, channelname) ? FramePriority::High : FramePriority::Low;
 }
 
 void FSession::wsSend(const char *command)
 {
-	std::string cmd = command;
-	wsSend(cmd);
+	send(command, strlen(command));
 }
 
-void FSession::wsSend(const char *command, JSONNode &nodes)
+void FSession::wsSend(const JSONStreamWriter &out)
 {
-	std::string cmd = command + (" " + nodes.write());
-	wsSend(cmd);
+	send(out.data(), out.length());
 }
 
 void FSession::wsSend(std::string &input)
 {
 	fix_broken_escaped_apos ( input );
-	debugMessage( ">>" + input);
-	socket->sendTextMessage(QString::fromStdString(input));
+	send(input.data(), input.size());
 }
 
-void FSession::wsRecv(std::string packet)
+void FSession::send(const char *data, size_t length)
 {
-	debugMessage(QString("Recv size %0").arg(packet.length()));
-	try {
-		std::string cmd = packet.substr(0, 3);
-		JSONNode nodes;
-		if(packet.length() > 4) {
-			nodes = libJSON::parse(packet.substr(4, packet.length() - 4));
+	FLOG(Network, Trace, ">>" + std::string(data, length));
+	if(capture) {
+		capture->record(FCapture::Outbound, sessionid, QByteArray(data, (int)length));
+	}
+	sendTextMessage(QString::fromUtf8(data, (int)length));
+}
+
+/**
+Start writing a command with a body into the send buffer. Write the fields with the helpers in this
+file, then call sendCommand(). The buffer is shared, so only one command can be written at a time.
+ */
+JSONStreamWriter &FSession::beginCommand(const char *command)
+{
+	sendbuffer.clear();
+	sendbuffer.raw(command, strlen(command)).raw(" ", 1).start_node();
+	return sendbuffer;
+}
+
+void FSession::sendCommand()
+{
+	sendbuffer.end_node();
+	wsSend(sendbuffer);
+}
+
+/**
+Log in with the account's ticket. The IDN goes straight to the socket rather than through wsSend(), so
+the ticket is never logged or captured.
+ */
+void FSession::sendIdentity()
+{
+	JSONStreamWriter &out = beginCommand("IDN");
+	writeIdentity(out);
+	out.end_node();
+	sendTextMessage(QString::fromUtf8(out.data(), (int)out.length()));
+}
+
+/**
+Write the fields of an IDN command, which logs in with the account's ticket.
+ */
+void FSession::writeIdentity(JSONStreamWriter &out)
+{
+	writeField(out, "method", "ticket");
+	writeField(out, "ticket", account->ticket);
+	writeField(out, "account", account->getUserName());
+	writeField(out, "cname", FLIST_CLIENTID);
+	writeField(out, "cversion", FLIST_VERSIONNUM);
+	writeField(out, "character", character);
+}
+
+/**
+Pack a three letter server command into an integer, so that it can be used as a cheap hash key.
+Commands shorter than three letters are padded with zeros.
+ */
+quint32 FSession::packCommand(const char *command, int length)
+{
+	quint32 code = 0;
+	for(int i = 0; i < 3; i++) {
+		code <<= 8;
+		if(i < length && command[i]) {
+			code |= (uchar)command[i];
+		} else {
+			length = i;
 		}
-#define CMD(name) if(cmd == #name) {cmd##name(packet, nodes); return;}
-		CMD(ADL); //List of all chat operators.
-		CMD(AOP); //Add a chat operator.
-		CMD(DOP); //Remove a chat operator.
+	}
+	return code;
+}
 
-		CMD(SFC); //Staff report.
+QString FSession::unpackCommand(quint32 code)
+{
+	QString command;
+	for(int shift = 16; shift >= 0; shift -= 8) {
+		char c = (code >> shift) & 0xff;
+		if(!c) {
+			break;
+		}
+		command += QLatin1Char(c);
+	}
+	return command;
+}
 
-		CMD(CDS); //Channel description.
-		CMD(CIU); //Channel invite.
-		CMD(ICH); //Initial channel data.
-		CMD(JCH); //Join channel.
-		CMD(LCH); //Leave channel.
-		CMD(RMO); //Room mode.
+/**
+Set the handler for the given server command, replacing any previous handler.
+ */
+void FSession::registerCommand(const char *command, CommandHandler handler)
+{
+	commandhandlers[packCommand(command)] = handler;
+}
 
-		CMD(LIS); //List of online characters.
-		CMD(NLN); //Character is now online.
-		CMD(FLN); //Character is now offline.
-		CMD(STA); //Status change.
+void FSession::unregisterCommand(const char *command)
+{
+	commandhandlers.remove(packCommand(command));
+}
 
-		CMD(CBU); //kick and ban character from channel.
-		CMD(CKU); //Kick character from channel.
+void FSession::registerCommands()
+{
+#define CMD(name) registerCommand(#name, [this](const QByteArray &rawpacket, FSessionFrame &frame) { \
+		if(frame.command) {                                                                       \
+			cmd##name(rawpacket, *static_cast<const FCmd##name *>(frame.command.get()));          \
+		} else {                                                                                  \
+			cmd##name(rawpacket, FCmd##name(frame.nodes));                                        \
+		}                                                                                         \
+	})
+	CMD(ADL); //List of all chat operators.
+	CMD(AOP); //Add a chat operator.
+	CMD(DOP); //Remove a chat operator.
+
+	CMD(SFC); //Staff report.
+
+	CMD(CDS); //Channel description.
+	CMD(CIU); //Channel invite.
+	CMD(ICH); //Initial channel data.
+	CMD(JCH); //Join channel.
+	CMD(LCH); //Leave channel.
+	CMD(RMO); //Room mode.
+
+	CMD(LIS); //List of online characters.
+	CMD(NLN); //Character is now online.
+	CMD(FLN); //Character is now offline.
+	CMD(STA); //Status change.
+
+	CMD(CBU); //kick and ban character from channel.
+	CMD(CKU); //Kick character from channel.
 
-		CMD(COL); //Channel operator list.
-		CMD(COA); //Channel operator add.
-		CMD(COR); //Channel operator remove.
+	CMD(COL); //Channel operator list.
+	CMD(COA); //Channel operator add.
+	CMD(COR); //Channel operator remove.
 
-		CMD(BRO); //Broadcast message.
-		CMD(SYS); //System message.
+	CMD(BRO); //Broadcast message.
+	CMD(SYS); //System message.
 
-		CMD(CON); //User count.
-		CMD(HLO); //Server hello.
-		CMD(IDN); //Identity acknowledged.
-		CMD(VAR); //Server variable.
+	CMD(CON); //User count.
+	CMD(HLO); //Server hello.
+	CMD(IDN); //Identity acknowledged.
+	CMD(VAR); //Server variable.
 
-		CMD(FRL); //Friends and bookmarks list.
-		CMD(IGN); //Ignore list update.
+	CMD(FRL); //Friends and bookmarks list.
+	CMD(IGN); //Ignore list update.
 
-		CMD(LRP); //Looking for RP message.
-		CMD(MSG); //Channel message.
-		CMD(PRI); //Private message.
-		CMD(RLL); //Dice roll or bottle spin result.
+	CMD(LRP); //Looking for RP message.
+	CMD(MSG); //Channel message.
+	CMD(PRI); //Private message.
+	CMD(RLL); //Dice roll or bottle spin result.
 
-		CMD(TPN); //Typing status.
+	CMD(TPN); //Typing status.
 
-		CMD(KID); //Custom kink data.
-		CMD(PRD); //Profile data.
+	CMD(KID); //Custom kink data.
+	CMD(PRD); //Profile data.
 
-		CMD(CHA); //Channel list.
-		CMD(ORS); //Open room list.
+	CMD(CHA); //Channel list.
+	CMD(ORS); //Open room list.
 
-		CMD(RTB); //Real time bridge.
+	CMD(RTB); //Real time bridge.
 
-		CMD(ZZZ); //Debug test command.
+	CMD(ZZZ); //Debug test command.
 
-		CMD(ERR); //Error message.
+	CMD(ERR); //Error message.
 
-		CMD(PIN); //Ping.
+	CMD(PIN); //Ping.
+#undef CMD
+}
+
+/**
+Process a single frame from the server, parsing it on the calling thread. The frame is expected to be
+UTF-8 and of the form "CMD {json}". Frames from the socket don't come through here, they are parsed on
+the worker thread and arrive through processFrames().
+ */
+void FSession::wsRecv(const QByteArray &packet)
+{
+	FSessionFrame frame = FSessionFrame::decode(packet);
+	dispatchFrame(frame);
+}
 
-		debugMessage(QString("The command '%1' was received, but is unknown and could not be processed. %2").arg(QString::fromStdString(cmd)).arg(QString::fromStdString(packet)));
+/**
+Hand a parsed frame to the registered handler for its command. The handler works on the frame's own
+JSON, copying the node would make libjson duplicate the whole tree on first access.
+ */
+void FSession::dispatchFrame(FSessionFrame &frame)
+{
+	const QByteArray &packet = frame.packet;
+	FLOG(Network, Trace, QString("Recv size %0").arg(packet.length()));
+	quint32 code = packCommand(packet.constData(), packet.length());
+	FCommandStats &stats = commandstats[code];
+	stats.frames++;
+	stats.bytes += packet.length();
+	stats.sizes.add(packet.length());
+	stats.parsetime.add(frame.parsetime);
+	//Take a copy, the handler is free to (un)register commands while it runs.
+	CommandHandler handler = commandhandlers.value(code);
+	if(!handler) {
+		FLOG(Protocol, Warning, QString("The command '%1' was received, but is unknown and could not be processed. %2").arg(unpackCommand(code)).arg(QString::fromUtf8(packet)));
+		return;
+	}
+	if(!frame.valid) {
+		stats.parsefailures++;
+		FLOG(Protocol, Warning, "Server returned invalid json, or json without a field we expected, in its response: " + QString::fromUtf8(packet));
+		return;
+	}
+	QElapsedTimer timer;
+	timer.start();
+	qint64 uistart = uitime;
+	try {
+		handler(packet, frame);
 	} catch(std::invalid_argument) {
-                debugMessage("Server returned invalid json in its response: " + packet);
-        } catch(std::out_of_range) {
-                debugMessage("Server produced unexpected json without a field we expected: " + packet);
-        }
+		commandstats[code].parsefailures++;
+		FLOG(Protocol, Warning, "Server returned invalid json in its response: " + QString::fromUtf8(packet));
+	} catch(std::out_of_range) {
+		commandstats[code].parsefailures++;
+		FLOG(Protocol, Warning, "Server produced unexpected json without a field we expected: " + QString::fromUtf8(packet));
+	}
+	//Look the stats up again, the handler may have added to commandstats and moved them.
+	qint64 handleruitime = uitime - uistart;
+	FCommandStats &handlerstats = commandstats[code];
+	handlerstats.handlertime.add(qMax(Q_INT64_C(0), timer.nsecsElapsed() - handleruitime));
+	handlerstats.uitime.add(handleruitime);
+}
+
+void FSession::resetCommandStats()
+{
+	commandstats.clear();
+	batchsizes = FHistogram();
+	batchbacklog = FHistogram();
+	deferreddepths = FHistogram();
+	prioritylatencies = FHistogram();
 }
 
-#define COMMAND(name) void FSession::cmd##name(std::string &rawpacket, JSONNode &nodes)
+#define COMMAND(name) void FSession::cmd##name(const QByteArray &rawpacket, const FCmd##name &cmd)
 
 
 //todo: Merge common code in ADL, AOP and DOP into a separate function.
@@ -322,19 +665,15 @@ COMMAND(ADL)
 	(void)rawpacket;
 	//The list of current chat-ops.
 	//ADL {"ops": ["name1", "name2"]}
-	JSONNode childnode = nodes.at("ops");
-	int size = childnode.size();
-
-	for(int i = 0; i < size; ++i) {
-		QString op = childnode[i].as_string().c_str();
-		operatorlist[op.toLower()] = op;
+	foreach(const QString &op, cmd.ops) {
+		FCharacterId id = names.intern(op);
+		operatorlist.insert(id);
 
-		if(isCharacterOnline(op)) {
+		if(FCharacter *character = getCharacter(id)) {
 			// Set flag in character
-			FCharacter* character = characterlist[op];
 			character->setIsChatOp(true);
 		}
-		account->ui->setChatOperator(this, op, true);
+		ui()->setChatOperator(this, op, true);
 	}
 	
 }
@@ -343,15 +682,15 @@ COMMAND(AOP)
 	(void)rawpacket;
 	//Add a character to the list of known chat-operators.
 	//AOP {"character": "Viona"}
-	QString op = nodes.at("character").as_string().c_str();
-	operatorlist[op.toLower()] = op;
+	const QString &op = cmd.character;
+	FCharacterId id = names.intern(op);
+	operatorlist.insert(id);
 	
-	if(isCharacterOnline(op)) {
+	if(FCharacter *character = getCharacter(id)) {
 		// Set flag in character
-		FCharacter *character = characterlist[op];
 		character->setIsChatOp(true);
 	}
-	account->ui->setChatOperator(this, op, true);
+	ui()->setChatOperator(this, op, true);
 }
 
 COMMAND(DOP)
@@ -359,15 +698,15 @@ COMMAND(DOP)
 	(void)rawpacket;
 	//Remove a character from the list of  chat operators.
 	//DOP {"character": "Viona"}
-	QString op = nodes.at("character").as_string().c_str();
-	operatorlist.remove(op.toLower());
+	const QString &op = cmd.character;
+	FCharacterId id = names.find(op);
+	operatorlist.remove(id);
 
-	if(isCharacterOnline(op)) {
+	if(FCharacter *character = getCharacter(id)) {
 		// Set flag in character
-		FCharacter *character = characterlist[op];
 		character->setIsChatOp(false);
 	}
-	account->ui->setChatOperator(this, op, false);
+	ui()->setChatOperator(this, op, false);
 }
 
 COMMAND(SFC)
@@ -377,31 +716,27 @@ COMMAND(SFC)
 	//SFC {"action": "report", "callid": "ID?", "character": "Character Name", "logid": "LogID", "report": "Report Text"}
 	//SFC {"action": "confirm", "moderator": "Character Name", "character": "Character Name"}
 	//The wiki has no documentation on this command.
-	QString action = nodes.at("action").as_string().c_str();
+	const QString &action = cmd.action;
 	if(action == "report") {
-		QString callid = nodes.at("callid").as_string().c_str();
-		QString character = nodes.at("character").as_string().c_str();
-		QString report = nodes.at("report").as_string().c_str();
-		QString logid;
+		QString callid = cmd.callid.required();
+		QString character = cmd.character.required();
+		QString report = cmd.report.required();
 		QString logstring;
-		try {
-			logid = nodes.at("logid").as_string().c_str();
-			logstring = QString("<a href=\"https://www.f-list.net/fchat/getLog.php?log=%1\" ><b>Log~</b></a> | ").arg(logid);
-		} catch(std::out_of_range) {
-			logstring.clear();
+		if(cmd.logid.present) {
+			logstring = QString("<a href=\"https://www.f-list.net/fchat/getLog.php?log=%1\" ><b>Log~</b></a> | ").arg(cmd.logid.value);
 		}
 		QString message = QString("<b>STAFF ALERT!</b> From %1<br />"
 					  "%2<br />"
 					  "%3" 
 					  "<a href=\"#CSA-%4\"><b>Confirm Alert</b></a>").arg(character).arg(report).arg(logstring).arg(callid);
-		account->ui->messageSystem(this, message, MessageType::Report);
+		ui()->messageSystem(this, message, MessageType::Report);
 	} else if(action == "confirm") {
-		QString moderator = nodes.at("moderator").as_string().c_str();
-		QString character = nodes.at("character").as_string().c_str();
+		QString moderator = cmd.moderator.required();
+		QString character = cmd.character.required();
 		QString message = QString("<b>%1</b> is handling <b>%2</b>'s report.").arg(moderator).arg(character);
-		account->ui->messageSystem(this, message, MessageType::Report);
+		ui()->messageSystem(this, message, MessageType::Report);
 	} else {
-		debugMessage(QString("Received a staff report with an action of '%1' but we don't know how to handle it. %2").arg(action).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("Received a staff report with an action of '%1' but we don't know how to handle it. %2").arg(action).arg(QString::fromUtf8(rawpacket)));
 	}
 }
 
@@ -409,15 +744,15 @@ COMMAND(CDS)
 {
 	//Channel description.
 	//CDS {"channel": "Channel Name", "description": "Description Text"}
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString description = nodes.at("description").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &description = cmd.description;
 	FChannel *channel = channellist.value(channelname);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Was give the description for the channel '%1', but the channel '%1' is unknown (or never joined).  %2").arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was give the description for the channel '%1', but the channel '%1' is unknown (or never joined).  %2").arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	channel->setDescription(description);
-	account->ui->setChannelDescription(this, channelname, description);
+	ui()->setChannelDescription(this, channelname, description);
 
 	// Queued joins. See also FSession::joinChannel for the rest of the logic.
 	if(joinQueue.head() == channelname)
@@ -429,18 +764,18 @@ COMMAND(CIU)
 {
 	//Channel invite.
 	//CIU {"sender": "Character Name", "name": "Channel Name", "title": "Channel Title"}
-	QString charactername = nodes.at("sender").as_string().c_str();
-	QString channelname = nodes.at("name").as_string().c_str();
-	QString channeltitle = nodes.at("title").as_string().c_str();
+	const QString &charactername = cmd.sender;
+	const QString &channelname = cmd.name;
+	const QString &channeltitle = cmd.title;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("Received invite to the channel '%1' (title '%2') by '%3' but the character '%3' does not exist. %4")
-			     .arg(channelname).arg(channeltitle).arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("Received invite to the channel '%1' (title '%2') by '%3' but the character '%3' does not exist. %4")
+			     .arg(channelname).arg(channeltitle).arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	//todo: Filter the title for problem BBCode characters.
 	QString message = makeMessage(QString("/me has invited you to [session=%1]%2[/session].*").arg(channeltitle).arg(channelname), charactername, character, 0, "<font color=\"yellow\"><b>Channel invite:</b></font> ", "");
-	account->ui->messageSystem(this, message, MessageType::ChannelInvite);
+	ui()->messageSystem(this, message, MessageType::ChannelInvite);
 }
 COMMAND(ICH)
 {
@@ -451,25 +786,20 @@ COMMAND(ICH)
 	//Where enum is: "ads", "chat", "both"
 	//ICH {"users": [{"identity": "Shadlor"}, {"identity": "Bunnie Patcher"}, {"identity": "DemonNeko"}, {"identity": "Desbreko"}, {"identity": "Robert Bell"}, {"identity": "Jayson"}, {"identity": "Valoriel Talonheart"}, {"identity": "Jordan Costa"}, {"identity": "Skip Weber"}, {"identity": "Niruka"}, {"identity": "Jake Brian Purplecat"}, {"identity": "Hexxy"}], "channel": "Frontpage", "mode": "chat"}
 	FChannel *channel;
-	QString channelname = nodes.at("channel").as_string().c_str();;
+	const QString &channelname = cmd.channel;
 	//debugMessage(QString("ICH: channel: %1").arg(channelname));
-	QString channelmode = nodes.at("mode").as_string().c_str();;
+	const QString &channelmode = cmd.mode;
 	//debugMessage(QString("ICH: mode: %1").arg(channelmode));
-	JSONNode childnode = nodes.at("users");
-	//debugMessage(QString("ICH: users: #%1").arg(childnode.size()));
+	//debugMessage(QString("ICH: users: #%1").arg(cmd.users.size()));
 	QString channeltitle;
-	if(channelname.startsWith("ADH-")) {
-		try {
-			//todo: Wiki says to expect "title" in the ICH command, but none is received
-			channeltitle = nodes.at("title").as_string().c_str();
-		} catch(std::out_of_range) {
-			channeltitle = channelname;
-		}
+	//todo: Wiki says to expect "title" in the ICH command, but none is received
+	if(channelname.startsWith("ADH-") && cmd.title.present) {
+		channeltitle = cmd.title.value;
 	} else {
 		channeltitle = channelname;
 	}
 	channel = addChannel(channelname, channeltitle);
-	account->ui->addChannel(this, channelname, channeltitle);
+	ui()->addChannel(this, channelname, channeltitle);
 	if(channelmode == "both") {
 		channel->mode = ChannelMode::Both;
 	} else if(channelmode == "ads") {
@@ -478,22 +808,22 @@ COMMAND(ICH)
 		channel->mode = ChannelMode::Chat;
 	} else {
 		channel->mode = ChannelMode::Unknown;
-		debugMessage("[SERVER BUG]: Received unknown channel mode '" + channelmode + "' for channel '" + channelname + "'. <<" + QString::fromStdString(rawpacket));
+		FLOG(Protocol, Warning, "[SERVER BUG]: Received unknown channel mode '" + channelmode + "' for channel '" + channelname + "'. <<" + QString::fromUtf8(rawpacket));
 	}
-	account->ui->setChannelMode(this, channelname, channel->mode);
+	ui()->setChannelMode(this, channelname, channel->mode);
 
-	int size = childnode.size();
-	debugMessage("Initial channel data for '" + channelname + "', charcter count: " + QString::number(size));
-	for(int i = 0; i < size; i++) {
-		QString charactername = childnode.at(i).at("identity").as_string().c_str();
+	FLOG(Session, Debug, "Initial channel data for '" + channelname + "', charcter count: " + QString::number(cmd.users.size()));
+	QStringList characternames;
+	characternames.reserve(cmd.users.size());
+	foreach(const QString &charactername, cmd.users) {
 		if(!isCharacterOnline(charactername)) {
-			debugMessage("[SERVER BUG] Server gave us a character in the channel user list that we don't know about yet: " + charactername.toStdString() + ", " + rawpacket);
+			FLOG(Protocol, Warning, "[SERVER BUG] Server gave us a character in the channel user list that we don't know about yet: " + charactername + ", " + QString::fromUtf8(rawpacket));
 			continue;
 		}
-		debugMessage("Add character '" + charactername + "' to channel '" + channelname + "'.");
-		channel->addCharacter(charactername, false);
+		characternames.append(charactername);
 	}
-	account->ui->notifyChannelReady(this, channelname);
+	channel->addCharacters(characternames);
+	ui()->notifyChannelReady(this, channelname);
 }
 COMMAND(JCH)
 {
@@ -501,16 +831,16 @@ COMMAND(JCH)
 	//Join channel notification. Sent when a character joins a channel.
 	//JCH {"character": {"identity": "Character Name"}, "channel": "Channel Name", "title": "Channel Title"}
 	FChannel *channel;
-	QString channelname = nodes.at("channel").as_string().c_str();;
+	const QString &channelname = cmd.channel;
 	QString channeltitle;
-	QString charactername = nodes.at("character").at("identity").as_string().c_str();
+	const QString &charactername = cmd.character;
 	if(channelname.startsWith("ADH-")) {
-		channeltitle = nodes.at("title").as_string().c_str();
+		channeltitle = cmd.title.required();
 	} else {
 		channeltitle = channelname;
 	}
 	channel = addChannel(channelname, channeltitle);
-	account->ui->addChannel(this, channelname, channeltitle);
+	ui()->addChannel(this, channelname, channeltitle);
 	channel->addCharacter(charactername, true);
 	if(charactername == character) {
 		channel->join();
@@ -521,11 +851,11 @@ COMMAND(LCH)
 	//Leave a channel. Sent when a character leaves a channel.
 	//LCH {"channel": "Channel Name", "character", "Character Name"}
 	FChannel *channel;
-	QString channelname = nodes.at("channel").as_string().c_str();;
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &charactername = cmd.character;
 	channel = getChannel(channelname);
 	if(!channel) {
-		debugMessage("[SERVER BUG] Was told about character '" + charactername + "' leaving unknown channel '" + channelname + "'.  " + QString::fromStdString(rawpacket));
+		FLOG(Protocol, Warning, "[SERVER BUG] Was told about character '" + charactername + "' leaving unknown channel '" + channelname + "'.  " + QString::fromUtf8(rawpacket));
 		return;
 	}
 	channel->removeCharacter(charactername);
@@ -541,8 +871,8 @@ COMMAND(RMO)
 	//Room mode.
 	//RMO {"mode": mode_enum, "channel": "Channel Name"}
 	//Where mode_enum
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString channelmode = nodes.at("mode").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &channelmode = cmd.mode;
 	FChannel *channel = channellist[channelname];
 	if(!channel) {
 		//todo: Determine if RMO can be sent even if we're not in the channel in question.
@@ -559,13 +889,13 @@ COMMAND(RMO)
 		channel->mode = ChannelMode::Chat;
 		modedescription = "chat only";
 	} else {
-		debugMessage(QString("[SERVER BUG]: Received channel mode update '%1' for channel '%2'. %3").arg(channelmode).arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG]: Received channel mode update '%1' for channel '%2'. %3").arg(channelmode).arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	QString message = "[session=%1]%2[/session]'s mode has been changed to: %3";
 	message = bbcodeparser->parse(message).arg(channel->getTitle()).arg(channelname).arg(modedescription);
-	account->ui->setChannelMode(this, channelname, channel->mode);
-	account->ui->messageChannel(this, channelname, message, MessageType::ChannelMode, true);
+	ui()->setChannelMode(this, channelname, channel->mode);
+	ui()->messageChannel(this, channelname, message, MessageType::ChannelMode, true);
 }
 
 COMMAND(NLN)
@@ -575,16 +905,17 @@ COMMAND(NLN)
 	//NLN {"identity": "Character Name", "gender": genderenum, "status": statusenum}
 	//Where 'statusenum' is one of: "online"
 	//Where 'genderenum' is one of: "Male", "Female", 
-	QString charactername = nodes.at("identity").as_string().c_str();
-	QString gender = nodes.at("gender").as_string().c_str();
-	QString status = nodes.at("status").as_string().c_str();
+	const QString &charactername = cmd.identity;
 	FCharacter *character = addCharacter(charactername);
-	character->setGender(gender);
-	character->setStatus(status);
-	if(operatorlist.contains(charactername.toLower())) {
+	character->setGender(cmd.gender);
+	character->setStatus(cmd.status);
+	if(operatorlist.contains(character->id())) {
 		character->setIsChatOp(true);
 	}
-	emit notifyCharacterOnline(this, charactername, true);
+	{
+		FTimedScope timed(uitime);
+		emit notifyCharacterOnline(this, charactername, true);
+	}
 }
 COMMAND(LIS)
 {
@@ -592,31 +923,23 @@ COMMAND(LIS)
 	//List of online characters. This can be sent in multiple blocks.
 	//LIS {"characters": [character, character]
 	//Where 'character' is: ["Character Name", genderenum, statusenum, "Status Message"]
-	nodes.preparse();
-	JSONNode childnode = nodes.at("characters");
-	int size = childnode.size();
-	//debugMessage("Character list count: " + QString::number(size));
-	//debugMessage(childnode.write());
-	for(int i = 0; i < size; i++) {
-		JSONNode characternode = childnode.at(i);
-		//debugMessage("char #" + QString::number(i) + " : " + QString::fromStdString(characternode.write()));
-		QString charactername = characternode.at(0).as_string().c_str();
-		//debugMessage("charactername: " + charactername);
-		QString gender = characternode.at(1).as_string().c_str();
-		//debugMessage("gender: " + gender);
-		QString status = characternode.at(2).as_string().c_str();
-		//debugMessage("status: " + status);
-		QString statusmessage = characternode.at(3).as_string().c_str();
-		//debugMessage("statusmessage: " + statusmessage);
+	QStringList characternames;
+	characternames.reserve(cmd.characters.size());
+	//debugMessage("Character list count: " + QString::number(cmd.characters.size()));
+	foreach(const FCommandCharacter &entry, cmd.characters) {
 		FCharacter *character;
-		character = addCharacter(charactername);
-		character->setGender(gender);
-		character->setStatus(status);
-		character->setStatusMsg(statusmessage);
-		if(operatorlist.contains(charactername.toLower())) {
+		character = addCharacter(entry.name);
+		character->setGender(entry.gender);
+		character->setStatus(entry.status);
+		character->setStatusMsg(entry.statusmessage);
+		if(operatorlist.contains(character->id())) {
 			character->setIsChatOp(true);
 		}
-		emit notifyCharacterOnline(this, charactername, true);
+		characternames.append(entry.name);
+	}
+	{
+		FTimedScope timed(uitime);
+		emit notifyCharactersOnline(this, characternames, true);
 	}
 }
 COMMAND(FLN)
@@ -624,75 +947,73 @@ COMMAND(FLN)
 	(void)rawpacket;
 	//Character is now offline.
 	//FLN {"character": "Character Name"}
-	QString charactername = nodes.at("character").as_string().c_str();
-	if(!isCharacterOnline(charactername)) {
-		debugMessage("[SERVER BUG] Received offline message for '" + charactername + "' but they're not listed as being online.");
+	const QString &charactername = cmd.character;
+	FCharacterId id = names.find(charactername);
+	if(!isCharacterOnline(id)) {
+		FLOG(Protocol, Warning, "[SERVER BUG] Received offline message for '" + charactername + "' but they're not listed as being online.");
 		return;
 	}
 	//Iterate over all channels and make the chracacter leave them if they're present.
 	for(QHash<QString, FChannel *>::const_iterator iter = channellist.begin(); iter != channellist.end(); iter++) {
-		if((*iter)->isCharacterPresent(charactername)) {
+		if((*iter)->isCharacterPresent(id)) {
 			(*iter)->removeCharacter(charactername);
 		}
 	}
-	emit notifyCharacterOnline(this, charactername, false);
-	removeCharacter(charactername);
+	{
+		FTimedScope timed(uitime);
+		emit notifyCharacterOnline(this, charactername, false);
+	}
+	removeCharacter(id);
 }
 COMMAND(STA)
 {
 	//Status change.
 	//STA {"character": "Character Name", "status": statusenum, "statusmsg": "Status message"}
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString status = nodes.at("status").as_string().c_str();
-	QString statusmessage;
+	const QString &charactername = cmd.character;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received a status update message from the character '%1', but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a status update message from the character '%1', but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
-	character->setStatus(status);
-	try {
-		statusmessage = nodes.at("statusmsg").as_string().c_str();
-		character->setStatusMsg(statusmessage);
-	} catch (std::out_of_range) {
-		// Crown messages can cause there to be no statusmsg.
-		/*do nothing*/
+	character->setStatus(cmd.status);
+	// Crown messages can cause there to be no statusmsg.
+	if(cmd.statusmsg.present) {
+		character->setStatusMsg(cmd.statusmsg.value);
+	}
+	{
+		FTimedScope timed(uitime);
+		emit notifyCharacterStatusUpdate(this, charactername);
 	}
-	emit notifyCharacterStatusUpdate(this, charactername);
 }
 
-COMMAND(CBUCKU)
+void FSession::cmdCBUCKU(const QByteArray &rawpacket, const QString &channelname, const QString &charactername, const QString &operatorname, bool banned)
 {
 	//CBU and CKU commands commoned up. Except for their messages, their behaviour is identical.
 	FChannel *channel;
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString operatorname = nodes.at("operator").as_string().c_str();
-	bool banned = rawpacket.substr(0, 3) == "CBU";
 	QString kicktype = banned ? "kicked and banned" : "kicked";
 	channel = getChannel(channelname);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but the channel '%2' is unknown (or never joined).  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but the channel '%2' is unknown (or never joined).  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	if(!channel->isJoined()) {
-		debugMessage(QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but this session is no longer joined with channel '%2'.  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but this session is no longer joined with channel '%2'.  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	if(!channel->isCharacterPresent(charactername)) {
-		debugMessage(QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but '%1' is not present in the channel.  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but '%1' is not present in the channel.  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	if(!channel->isCharacterOperator(operatorname) && !isCharacterOperator(operatorname)) {
-		debugMessage(QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but '%3' is not a channel operator or a server operator!  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told about character '%1' being %4 from channel '%2' by '%3', but '%3' is not a channel operator or a server operator!  %5").arg(charactername).arg(channelname).arg(operatorname).arg(kicktype).arg(QString::fromUtf8(rawpacket)));
 	}
 	QString message = QString("<b>%1</b> has %4 <b>%2</b> from %3.").arg(operatorname).arg(charactername).arg(channel->getTitle()).arg(kicktype);
 	if(charactername == character) {
-		account->ui->messageChannel(this, channelname, message, banned ? MessageType::KickBan : MessageType::Kick, true, true);
+		ui()->messageChannel(this, channelname, message, banned ? MessageType::KickBan : MessageType::Kick, true, true);
 		channel->removeCharacter(charactername);
 		channel->leave();
 	} else {
-		account->ui->messageChannel(this, channelname, message, banned ? MessageType::KickBan : MessageType::Kick, channel->isCharacterOperator(character), false);
+		ui()->messageChannel(this, channelname, message, banned ? MessageType::KickBan : MessageType::Kick, channel->isCharacterOperator(character), false);
 		channel->removeCharacter(charactername);
 	}
 }
@@ -700,30 +1021,27 @@ COMMAND(CBU)
 {
 	//Kick and ban character from channel.
 	//CBU {"operator": "Character Name", "channel": "Channel Name", "character": "Character Name"}
-	cmdCBUCKU(rawpacket, nodes);
+	cmdCBUCKU(rawpacket, cmd.channel, cmd.character, cmd.operatorname, true);
 }
 COMMAND(CKU)
 {
 	//Kick character from channel.
 	//CKU {"operator": "Character Name", "channel": "Channel Name", "character": "Character Name"}
-	cmdCBUCKU(rawpacket, nodes);
+	cmdCBUCKU(rawpacket, cmd.channel, cmd.character, cmd.operatorname, false);
 }
 
 COMMAND(COL)
 {
 	//Channel operator list.
 	//COL {"channel":"Channel Name", "oplist":["Character Name"]}
-	QString channelname = nodes.at("channel").as_string().c_str();
+	const QString &channelname = cmd.channel;
 	FChannel *channel = getChannel(channelname);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Was given the channel operator list for the channel '%1', but the channel '%1' is unknown (or never joined).  %2").arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was given the channel operator list for the channel '%1', but the channel '%1' is unknown (or never joined).  %2").arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
-	JSONNode childnode = nodes.at("oplist");
 	//todo: clear the existing operator list first
-	int size = childnode.size();
-	for(int i = 0; i < size; i++) {
-		QString charactername = childnode.at(i).as_string().c_str();
+	foreach(const QString &charactername, cmd.oplist) {
 		channel->addOperator(charactername);
 	}
 }
@@ -731,11 +1049,11 @@ COMMAND(COA)
 {
 	//Channel operator add.
 	//COA {"channel":"Channel Name", "character":"Character Name"}
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &charactername = cmd.character;
 	FChannel *channel = getChannel(channelname);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Was told to add '%2' as a channel operator for channel '%1', but the channel '%1' is unknown (or never joined).  %3").arg(channelname).arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told to add '%2' as a channel operator for channel '%1', but the channel '%1' is unknown (or never joined).  %3").arg(channelname).arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	//todo: Print a BUG message about adding operators twice.
@@ -745,11 +1063,11 @@ COMMAND(COR)
 {
 	//Channel operator remove.
 	//COR {"channel":"Channel Name", "character":"Character Name"}
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &charactername = cmd.character;
 	FChannel *channel = getChannel(channelname);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Was told to remove '%2' from the list of channel operators for channel '%1', but the channel '%1' is unknown (or never joined).  %3").arg(channelname).arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Was told to remove '%2' from the list of channel operators for channel '%1', but the channel '%1' is unknown (or never joined).  %3").arg(channelname).arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	//todo: Print a bug message  if we're removing someone not on the operator list and skip the whole removal process.
@@ -761,16 +1079,14 @@ COMMAND(BRO)
 	(void)rawpacket;
 	//Broadcast message.
 	//BRO {"message": "Message Text"}
-	QString message = nodes.at("message").as_string().c_str();
-	account->ui->messageAll(this, QString("<b>Broadcast message:</b> %1").arg(bbcodeparser->parse(message)), MessageType::System);
+	ui()->messageAll(this, QString("<b>Broadcast message:</b> %1").arg(bbcodeparser->parse(cmd.message)), MessageType::System);
 }
 COMMAND(SYS)
 {
 	(void)rawpacket;
 	//System message
 	//SYS {"message": "Message Text"}
-	QString message = nodes.at("message").as_string().c_str();
-	account->ui->messageSystem(this, QString("<b>System message:</b> %1").arg(message), MessageType::System);
+	ui()->messageSystem(this, QString("<b>System message:</b> %1").arg(cmd.message), MessageType::System);
 }
 
 COMMAND(CON)
@@ -778,17 +1094,15 @@ COMMAND(CON)
 	(void)rawpacket;
 	//User count.
 	//CON {"count": usercount}
-	QString count = nodes.at("count").as_string().c_str();
 	//The message doesn't handle the plural case correctly, but that only happens on the test server.
-	account->ui->messageSystem(this, QString("%1 users are currently connected.").arg(count), MessageType::Login);
+	ui()->messageSystem(this, QString("%1 users are currently connected.").arg(cmd.count), MessageType::Login);
 }
 COMMAND(HLO)
 {
 	(void) rawpacket;
 	//Server hello. Sent during the initial connection traffic after identification.
 	//HLO {"message": "Server Message"}
-	QString message = nodes.at("message").as_string().c_str();
-	account->ui->messageSystem(this, QString("<b>%1</b>").arg(message), MessageType::Login);
+	ui()->messageSystem(this, QString("<b>%1</b>").arg(cmd.message), MessageType::Login);
 	foreach(QString channelname, autojoinchannels) {
 		joinChannel(channelname);
 	}
@@ -797,12 +1111,12 @@ COMMAND(IDN)
 {
 	//Identity acknowledged.
 	//IDN {"character": "Character Name"}
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &charactername = cmd.character;
 
 	QString message = QString("<b>%1</b> connected.").arg(charactername);
-	account->ui->messageSystem(this, message, MessageType::Login);
+	ui()->messageSystem(this, message, MessageType::Login);
 	if(charactername != character) {
-		debugMessage(QString("[SERVER BUG] Received IDN response for '%1', but this session is for '%2'. %3").arg(charactername).arg(character).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received IDN response for '%1', but this session is for '%2'. %3").arg(charactername).arg(character).arg(QString::fromUtf8(rawpacket)));
 	}
 }
 COMMAND(VAR)
@@ -810,10 +1124,10 @@ COMMAND(VAR)
 	(void)rawpacket;
 	//Server variable
 	//VAR {"value":value, "variable":"Variable_Name"}
-	QString value = nodes.at("value").as_string().c_str();
-	QString variable = nodes.at("variable").as_string().c_str();
+	const QString &value = cmd.value;
+	const QString &variable = cmd.variable;
 	servervariables[variable] = value;
-	debugMessage(QString("Server variable: %1 = '%2'").arg(variable).arg(value));
+	FLOG(Protocol, Debug, QString("Server variable: %1 = '%2'").arg(variable).arg(value));
 	//todo: Parse and store variables of interest.
 }
 
@@ -822,14 +1136,8 @@ COMMAND(FRL)
 	(void) rawpacket;
 	//Friends and bookmarks list.
 	//FRL {"characters":["Character Name"]}
-	JSONNode childnode = nodes.at("characters");
-	int size = childnode.size();
-	for(int i = 0; i < size; i++) {
-		QString charactername = childnode.at(i).as_string().c_str();
-		if(!friendslist.contains(charactername)) {
-			friendslist.append(charactername);
-			//debugMessage(QString("Added friend '%1'.").arg(charactername));
-		}
+	foreach(const QString &charactername, cmd.characters) {
+		friendslist.insert(names.intern(charactername));
 	}
 	
 }
@@ -839,36 +1147,49 @@ COMMAND(IGN)
 	//IGN {"action": "init", "characters":, ["Character Name"]}
 	//IGN {"action": "add", "characters":, "Character Name"}
 	//IGN {"action": "delete", "characters":, "Character Name"}
-	QString action = nodes.at("action").as_string().c_str();
+	const QString &action = cmd.action;
 	if(action == "init") {
-		JSONNode childnode = nodes.at("characters");
 		ignorelist.clear();
-		int size = childnode.size();
-		for(int i = 0; i < size; i++) {
-			QString charactername = childnode.at(i).as_string().c_str();
-			if(!ignorelist.contains(charactername, Qt::CaseInsensitive)) {
-				ignorelist.append(charactername.toLower());
+		ignoreids.clear();
+		foreach(const QString &charactername, cmd.characters.required()) {
+			FCharacterId id = names.intern(charactername);
+			if(!ignoreids.contains(id)) {
+				ignoreids.insert(id);
+				ignorelist.append(names.key(id));
 			}
 		}
-		emit notifyIgnoreList(this);
+		{
+			FTimedScope timed(uitime);
+			emit notifyIgnoreList(this);
+		}
 	} else if(action == "add") {
-		QString charactername = nodes.at("character").as_string().c_str();
-		if(ignorelist.contains(charactername, Qt::CaseInsensitive)) {
-			debugMessage(QString("[BUG] Was told to add '%1' to our ignore list, but '%1' is already on our ignore list. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		const QString &charactername = cmd.character.required();
+		FCharacterId id = names.intern(charactername);
+		if(ignoreids.contains(id)) {
+			FLOG(Protocol, Warning, QString("[BUG] Was told to add '%1' to our ignore list, but '%1' is already on our ignore list. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		} else {
-			ignorelist.append(charactername.toLower());
+			ignoreids.insert(id);
+			ignorelist.append(names.key(id));
+		}
+		{
+			FTimedScope timed(uitime);
+			emit notifyIgnoreAdd(this, charactername);
 		}
-		emit notifyIgnoreAdd(this, charactername);
 	} else if(action =="delete") {
-		QString charactername = nodes.at("character").as_string().c_str();
-		if(!ignorelist.contains(charactername, Qt::CaseInsensitive)) {
-			debugMessage(QString("[BUG] Was told to remove '%1' from our ignore list, but '%1' is not on our ignore list. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		const QString &charactername = cmd.character.required();
+		FCharacterId id = names.find(charactername);
+		if(!ignoreids.contains(id)) {
+			FLOG(Protocol, Warning, QString("[BUG] Was told to remove '%1' from our ignore list, but '%1' is not on our ignore list. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		} else {
-			ignorelist.removeAll(charactername.toLower());
+			ignoreids.remove(id);
+			ignorelist.removeAll(names.key(id));
+		}
+		{
+			FTimedScope timed(uitime);
+			emit notifyIgnoreRemove(this, charactername);
 		}
-		emit notifyIgnoreRemove(this, charactername);
 	} else {
-		debugMessage(QString("[SERVER BUG] Received ignore command(IGN) but the action '%1' is unknown. %2").arg(action).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received ignore command(IGN) but the action '%1' is unknown. %2").arg(action).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 }
@@ -877,11 +1198,12 @@ QString FSession::makeMessage(QString message, QString charactername, FCharacter
 {
 	QString characterprefix;
 	QString characterpostfix;
-	if(isCharacterOperator(charactername)) {
+	FCharacterId id = character ? character->id() : names.find(charactername);
+	if(isCharacterOperator(id)) {
 		//todo: choose a different icon
 		characterprefix += "<img src=\":/images/auction-hammer.png\" />";
 	}
-	if(isCharacterOperator(charactername) || (channel && channel->isCharacterOperator(charactername))) {
+	if(isCharacterOperator(id) || (channel && channel->isCharacterOperator(id))) {
 		characterprefix += "<img src=\":/images/auction-hammer.png\" />";
 	}
 	QString messagebody;
@@ -935,78 +1257,78 @@ COMMAND(LRP)
 {
 	//Looking for RP message.
 	//LRP {"channel": "Channel Name", "character": "Character Name", "message": "Message Text"}
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString message = nodes.at("message").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &charactername = cmd.character;
+	const QString &message = cmd.message;
 	FChannel *channel = getChannel(channelname);
 	FCharacter *character = getCharacter(charactername);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Received an RP ad from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received an RP ad from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received an RP ad from '%1' in the channel '%2' but the character '%1' is unknown. %3").arg(charactername).arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received an RP ad from '%1' in the channel '%2' but the character '%1' is unknown. %3").arg(charactername).arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		//todo: Allow it to be displayed anyway?
 		return;
 	}
-	if(isCharacterIgnored(charactername)) {
+	if(isCharacterIgnored(character->id())) {
 		//Ignore message
 		return;
 	}
 	QString messagefinal = makeMessage(message, charactername, character, channel, "<font color=\"green\"><b>Roleplay ad by</b></font> ", "");
 	FMessage fmessage(messagefinal, MessageType::RpAd);
 	fmessage.toChannel(channelname).fromChannel(channelname).fromCharacter(charactername).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 COMMAND(MSG)
 {
 	//Channel message.
 	//MSG {"channel": "Channel Name", "character": "Character Name", "message": "Message Text"}
-	QString channelname = nodes.at("channel").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString message = nodes.at("message").as_string().c_str();
+	const QString &channelname = cmd.channel;
+	const QString &charactername = cmd.character;
+	const QString &message = cmd.message;
 	FChannel *channel = getChannel(channelname);
 	FCharacter *character = getCharacter(charactername);
 	if(!channel) {
-		debugMessage(QString("[SERVER BUG] Received a message from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a message from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received a message from '%1' in the channel '%2' but the character '%1' is unknown. %3").arg(charactername).arg(channelname).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a message from '%1' in the channel '%2' but the character '%1' is unknown. %3").arg(charactername).arg(channelname).arg(QString::fromUtf8(rawpacket)));
 		//todo: Allow it to be displayed anyway?
 		return;
 	}
-	if(isCharacterIgnored(charactername)) {
+	if(isCharacterIgnored(character->id())) {
 		//Ignore message
 		return;
 	}
 	QString messagefinal = makeMessage(message, charactername, character, channel);
 	FMessage fmessage(messagefinal, MessageType::Chat);
 	fmessage.toChannel(channelname).fromChannel(channelname).fromCharacter(charactername).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 COMMAND(PRI)
 {
 	//Private message.
 	//PRI {"character": "Character Name", "message": "Message Text"}
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString message = nodes.at("message").as_string().c_str();
+	const QString &charactername = cmd.character;
+	const QString &message = cmd.message;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received a message from the character '%1', but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a message from the character '%1', but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		//todo: Allow it to be displayed anyway?
 		return;
 	}
-	if(isCharacterIgnored(charactername)) {
+	if(isCharacterIgnored(character->id())) {
 		//Ignore message
 		return;
 	}
 	
 	QString messagefinal = makeMessage(message, charactername, character);
-	account->ui->addCharacterChat(this, charactername);
+	ui()->addCharacterChat(this, charactername);
 	FMessage fmessage(messagefinal, MessageType::Chat);
 	fmessage.toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 COMMAND(RLL)
 {
@@ -1017,17 +1339,13 @@ COMMAND(RLL)
 	//RLL {"type": "dice", "message": "Message Text", "channel": "Channel Name", "character": "Character Name", "results": [number], "endresult": number}
 	//PM roll:
 	//RLL {"type": "dice", "message": "Message Text", "recipient": "Partner Character Name", "character": "Rolling Character Name", "endresult": number, "rolls": ["2d20", "3", "-1d10"], "results": [number, number, number]}
-	QString channelname;
-	try {
-		channelname = nodes.at("channel").as_string().c_str();
-	} catch(std::out_of_range) {
-	}
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &channelname = cmd.channel.value;
+	QString charactername = cmd.character;
 	if(channelname.isEmpty() && charactername == this->character) {
 		//We're the character rolling in a PM, so the "recipient" field contains the character we want.
-		charactername = nodes.at("recipient").as_string().c_str();
+		charactername = cmd.recipient.required();
 	}
-	QString message = nodes.at("message").as_string().c_str();
+	const QString &message = cmd.message;
 	if(isCharacterIgnored(charactername)) {
 		//Ignore message
 		return;
@@ -1036,18 +1354,18 @@ COMMAND(RLL)
 		FChannel *channel = getChannel(channelname);
 		//FCharacter *character = getCharacter(charactername);
 		if(!channel) {
-			debugMessage(QString("[SERVER BUG] Received a dice roll result from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromStdString(rawpacket)));
+			FLOG(Protocol, Warning, QString("[SERVER BUG] Received a dice roll result from the channel '%1' but the channel '%1' is unknown. %2").arg(channelname).arg(QString::fromUtf8(rawpacket)));
 			//todo: Dump the message to console anyway?
 			return;
 		}
 		//todo: Maybe extract character name and make it a link and colored like normal.
-		account->ui->messageChannel(this, channelname, bbcodeparser->parse(message), MessageType::DiceRoll, true);
+		ui()->messageChannel(this, channelname, bbcodeparser->parse(message), MessageType::DiceRoll, true);
 	} else {
-		account->ui->addCharacterChat(this, charactername);
+		ui()->addCharacterChat(this, charactername);
 		QString messagefinal = bbcodeparser->parse(message);
 		FMessage fmessage(messagefinal, MessageType::DiceRoll);
 		fmessage.toCharacter(charactername).fromCharacter(this->character).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 	}
 }
 
@@ -1056,11 +1374,11 @@ COMMAND(TPN)
 	//Typing status.
 	//TPN {"status": typing_enum, "character": "Character Name"}
 	//Where 'typing_enum' is one of: "typing", "paused", "clear"
-	QString charactername = nodes.at("character").as_string().c_str();
-	QString typingstatus = nodes.at("status").as_string().c_str();
+	const QString &charactername = cmd.character;
+	const QString &typingstatus = cmd.status;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received a typing status update for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a typing status update for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
 	TypingStatus status;
@@ -1071,10 +1389,10 @@ COMMAND(TPN)
 	} else if(typingstatus == "clear") {
 		status = TYPING_STATUS_CLEAR;
 	} else {
-		debugMessage(QString("[SERVER BUG] Received a typing status update of '%2' for the character '%1' but the typing status '%2' is unknown. %3").arg(charactername).arg(typingstatus).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received a typing status update of '%2' for the character '%1' but the typing status '%2' is unknown. %3").arg(charactername).arg(typingstatus).arg(QString::fromUtf8(rawpacket)));
 		status = TYPING_STATUS_CLEAR;
 	}
-	account->ui->setCharacterTypingStatus(this, charactername, status);
+	ui()->setCharacterTypingStatus(this, charactername, status);
 
 	
 }
@@ -1087,24 +1405,25 @@ COMMAND(KID)
 	//KID {"type": "end", "character": "Character Name", "message": "End of custom kinks."}
 	//KID {"type": "custom", "character": "Character Name", "key": "Key Text", "value": "Value Text"}
 	//Where "kinkdataenum" is one of: "start", "end", "custom"
-	QString type = nodes.at("type").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &type = cmd.type;
+	const QString &charactername = cmd.character;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received custom kink data for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received custom kink data for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
+	FCharacterProfile *profile = roster.profile(character->id());
 	if(type == "start") {
-		character->clearCustomKinkData();
+		profile->clearCustomKinkData();
 		//account->ui->notifyCharacterCustomKinkDataReset(this, charactername);
 	} else if(type == "end") {
-		account->ui->notifyCharacterCustomKinkDataUpdated(this, charactername);
+		ui()->notifyCharacterCustomKinkDataUpdated(this, charactername);
 	} else if(type == "custom") {
-		QString key = nodes.at("key").as_string().c_str();
-		QString value = nodes.at("value").as_string().c_str();
-		character->addCustomKinkData(key, value);
+		const QString &key = cmd.key.required();
+		const QString &value = cmd.value.required();
+		profile->addCustomKinkData(key, value);
 	} else {
-		debugMessage(QString("[BUG] Received custom kink data for the character '%1' with a type of '%2' but we don't know how to handle '%2'. %3").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[BUG] Received custom kink data for the character '%1' with a type of '%2' but we don't know how to handle '%2'. %3").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 	}
 }
 COMMAND(PRD)
@@ -1116,25 +1435,26 @@ COMMAND(PRD)
 	//PRD {"type": "info", "character": "Character Name", "key": "Key Text", "value": "Value Text"}
 	//PRD {"type": "select", "character": "Character Name", ???}
 	//Where "profiledataenum" is one of: "start", "end", "info", "select"
-	QString type = nodes.at("type").as_string().c_str();
-	QString charactername = nodes.at("character").as_string().c_str();
+	const QString &type = cmd.type;
+	const QString &charactername = cmd.character;
 	FCharacter *character = getCharacter(charactername);
 	if(!character) {
-		debugMessage(QString("[SERVER BUG] Received profile data for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[SERVER BUG] Received profile data for the character '%1' but the character '%1' is unknown. %2").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 		return;
 	}
+	FCharacterProfile *profile = roster.profile(character->id());
 	if(type == "start") {
-		character->clearProfileData();
+		profile->clearProfileData();
 		//account->ui->notifyCharacterProfileDataReset(this, charactername);
 	} else if(type == "end") {
-		account->ui->notifyCharacterProfileDataUpdated(this, charactername);
+		ui()->notifyCharacterProfileDataUpdated(this, charactername);
 	} else if(type == "info") {
-		QString key = nodes.at("key").as_string().c_str();
-		QString value = nodes.at("value").as_string().c_str();
-		character->addProfileData(key, value);
+		const QString &key = cmd.key.required();
+		const QString &value = cmd.value.required();
+		profile->addProfileData(key, value);
 	} else {
 		//todo: "select" is referred to in the wiki but no additional detail is given.
-		debugMessage(QString("[BUG] Received profile data for the character '%1' with a type of '%2' but we don't know how to handle '%2'. %3").arg(charactername).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("[BUG] Received profile data for the character '%1' with a type of '%2' but we don't know how to handle '%2'. %3").arg(charactername).arg(QString::fromUtf8(rawpacket)));
 	}
 	
 }
@@ -1145,17 +1465,11 @@ COMMAND(CHA)
 	//Channel list.
 	//CHA {"channels": [{"name": "Channel Name", "characters": character_count}]}
 	knownchannellist.clear();
-	JSONNode childnode = nodes.at("channels");
-	int size = childnode.size();
-	for(int i = 0; i < size; i++) {
-		JSONNode channelnode = childnode.at(i);
-		QString channelname = channelnode.at("name").as_string().c_str();
-		QString channelcountstring = channelnode.at("characters").as_string().c_str();
-		//todo: Verify the count string can be converted properly.
-		int channelcount = channelcountstring.toInt();
-		knownchannellist.append(FChannelSummary(FChannelSummary::Public, channelname, channelcount));
-	}
-	account->ui->updateKnownChannelList(this);
+	knownchannellist.reserve(cmd.channels.size());
+	foreach(const FCommandChannel &entry, cmd.channels) {
+		knownchannellist.append(FChannelSummary(FChannelSummary::Public, entry.name, entry.characters));
+	}
+	ui()->updateKnownChannelList(this);
 }
 COMMAND(ORS)
 {
@@ -1163,22 +1477,15 @@ COMMAND(ORS)
 	//Open room list.
 	//CHA {"channels": [{"name": "Channel Name", "title": "Channel Title", "characters": character_count}]}
 	knownopenroomlist.clear();
-	JSONNode childnode = nodes.at("channels");
-	int size = childnode.size();
-	for(int i = 0; i < size; i++) {
-		JSONNode channelnode = childnode.at(i);
-		QString channelname = channelnode.at("name").as_string().c_str();
-		QString channeltitle = channelnode.at("title").as_string().c_str();
-		QString channelcountstring = channelnode.at("characters").as_string().c_str();
-		int channelcount = channelcountstring.toInt();
-		knownopenroomlist.append(FChannelSummary(FChannelSummary::Private, channelname, channeltitle, channelcount));
+	knownopenroomlist.reserve(cmd.channels.size());
+	foreach(const FCommandChannel &entry, cmd.channels) {
+		knownopenroomlist.append(FChannelSummary(FChannelSummary::Private, entry.name, entry.title, entry.characters));
 	}
-	account->ui->updateKnownOpenRoomList(this);
+	ui()->updateKnownOpenRoomList(this);
 }
 
 COMMAND(RTB)
 {
-	(void)rawpacket; (void)nodes;
 	//Real time bridge.
 	//RTB {"type":typeenum, ???}
 	//RTB {"type":"note", "sender": "Character Name", "subject": "Subject Text", "id":id}
@@ -1189,11 +1496,11 @@ COMMAND(RTB)
 	//RTB {"type":"friendremove","name":"Character Name"}
 
 	//todo: Determine all the RTB messages.
-	QString type = nodes.at("type").as_string().c_str();
+	const QString &type = cmd.type;
 	if(type == "note") {
-		QString charactername = nodes.at("sender").as_string().c_str();
-		QString subject = nodes.at("subject").as_string().c_str();
-		QString id = nodes.at("id").as_string().c_str();
+		const QString &charactername = cmd.sender.required();
+		const QString &subject = cmd.subject.required();
+		const QString &id = cmd.id.required();
 		
 		QString message = "Note recieved from %1: <a href=\"https://www.f-list.net/view_note.php?note_id=%2\">%3</a>";
 		message = message
@@ -1202,64 +1509,58 @@ COMMAND(RTB)
 			.arg(subject);
 		FMessage fmessage(message, MessageType::Note);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Note);
 	} else if(type == "trackadd") {
-		QString charactername = nodes.at("name").as_string().c_str();
-		if(!friendslist.contains(charactername)) {
-			friendslist.append(charactername);
-			//debugMessage(QString("Added friend '%1'.").arg(charactername));
-		}
+		const QString &charactername = cmd.name.required();
+		friendslist.insert(names.intern(charactername));
 		QString message = "Bookmark update: %1 has been added to your bookmarks."; //todo: escape characters?
 		message = message.arg(getCharacterHtml(charactername));
 		FMessage fmessage(message, MessageType::Bookmark);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Bookmark);
 	} else if(type == "trackrem") {
 		//todo: Update bookmark list? (Removing has the complication in that bookmarks and friends aren't distinguished and multiple instances of friends may exist.)
-		QString charactername = nodes.at("name").as_string().c_str();
+		const QString &charactername = cmd.name.required();
 		QString message = "Bookmark update: %1 has been removed from your bookmarks."; //todo: escape characters?
 		message = message.arg(getCharacterHtml(charactername));
 		FMessage fmessage(message, MessageType::Bookmark);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Bookmark);
 	} else if(type == "friendrequest") {
-		QString charactername = nodes.at("name").as_string().c_str();
+		const QString &charactername = cmd.name.required();
 		QString message = "Friend update: %1 has requested to be friends with one of your characters. Visit <a href=\"%2\">%2</a> to view the request on F-List."; //todo: escape characters?
 		message = message.arg(charactername).arg("https://www.f-list.net/messages.php?show=friends");
 		FMessage fmessage(message, MessageType::Friend);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Friend);
 	} else if(type == "friendadd") {
-		QString charactername = nodes.at("name").as_string().c_str();
-		if(!friendslist.contains(charactername)) {
-			friendslist.append(getCharacterHtml(charactername));
-			//debugMessage(QString("Added friend '%1'.").arg(charactername));
-		}
+		const QString &charactername = cmd.name.required();
+		friendslist.insert(names.intern(charactername));
 		QString message = "Friend update: %1 has become friends with one of your characters."; //todo: escape characters?
 		message = message.arg(getCharacterHtml(charactername));
 		FMessage fmessage(message, MessageType::Friend);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Friend);
 	} else if(type == "friendremove") {
 		//todo: Update bookmark/friend list? (Removing has the complication in that bookmarks and friends aren't distinguished and multiple instances of friends may exist.)
-		QString charactername = nodes.at("name").as_string().c_str();
+		const QString &charactername = cmd.name.required();
 		QString message = "Friend update: %1 was removed as a friend from one of your characters."; //todo: escape characters?
 		message = message.arg(getCharacterHtml(charactername));
 		FMessage fmessage(message, MessageType::Friend);
 		fmessage.toUser().toCharacter(charactername).fromCharacter(charactername).fromSession(sessionid);
-		account->ui->messageMessage(fmessage);
+		ui()->messageMessage(fmessage);
 		//account->ui->messageSystem(this, message, MessageType::Friend);
 	} else {
 		QString message = "Received an unknown/unhandled Real Time Bridge message of type \"%1\". Received packet: %2"; //todo: escape characters?
-		message = message.arg(type).arg(rawpacket.c_str());
-		account->ui->messageSystem(this, message, MessageType::Error);
+		message = message.arg(type).arg(QString::fromUtf8(rawpacket));
+		ui()->messageSystem(this, message, MessageType::Error);
 	}
-	//debugMessage(QString("Real time bridge: %1").arg(QString::fromStdString(rawpacket)));
+	//debugMessage(QString("Real time bridge: %1").arg(QString::fromUtf8(rawpacket)));
 }
 
 COMMAND(ZZZ)
@@ -1268,41 +1569,29 @@ COMMAND(ZZZ)
 	//Debug test command.
 	//ZZZ {"message": "???"}
 	//This command is not documented.
-	QString message = nodes.at("message").as_string().c_str();
-	account->ui->messageSystem(this, QString("<b>Debug Reply:</b> %1").arg(message), MessageType::System);
+	ui()->messageSystem(this, QString("<b>Debug Reply:</b> %1").arg(cmd.message), MessageType::System);
 }
 
 COMMAND(ERR)
 {
 	//Error message.
 	//ERR {"number": error_number, "message": "Error Message"}
-	QString errornumberstring = nodes.at("number").as_string().c_str();
-	QString errormessage = nodes.at("message").as_string().c_str();
+	const QString &errornumberstring = cmd.number;
+	const QString &errormessage = cmd.message;
 	QString message = QString("<b>Error %1: </b> %2").arg(errornumberstring).arg(errormessage);
-	account->ui->messageSystem(this, message, MessageType::Error);
+	ui()->messageSystem(this, message, MessageType::Error);
 	bool ok;
 	int errornumber = errornumberstring.toInt(&ok);
 	if(!ok) {
-		debugMessage(QString("Received an error message but could not convert the error number to an integer. Error number '%1', error message '%2' : %3").arg(errornumberstring).arg(errormessage).arg(QString::fromStdString(rawpacket)));
+		FLOG(Protocol, Warning, QString("Received an error message but could not convert the error number to an integer. Error number '%1', error message '%2' : %3").arg(errornumberstring).arg(errormessage).arg(QString::fromUtf8(rawpacket)));
 			     return;
 	}
 	//Handle special cases.
 	//todo: Parse the error and pass along to the UI for more informative feedback.
 	switch(errornumber) {
 	case 34: //Error 34 is not in the wiki, but the existing code sends out another identification if it is received.
-	{
-		JSONNode loginnode;
-		loginnode.push_back(JSONNode("method", "ticket"));
-		loginnode.push_back(JSONNode("ticket", account->ticket.toStdString()));
-		loginnode.push_back(JSONNode("account", account->getUserName().toStdString()));
-		loginnode.push_back(JSONNode("cname", FLIST_CLIENTID));
-		loginnode.push_back(JSONNode("cversion", FLIST_VERSIONNUM));
-		loginnode.push_back(JSONNode("character", character.toStdString()));
-		std::string idenStr = "IDN " + loginnode.write();
-		//debugMessage("Indentify...");
-		wsSend(idenStr);
+		sendIdentity();
 		break;
-	}
 	case 28: // Already in channel
 	case 26: // No such channel
 	case 44: // Not invited to an invite-only channel
@@ -1317,10 +1606,9 @@ COMMAND(ERR)
 
 COMMAND(PIN)
 {
-	(void)rawpacket; (void)nodes;
+	(void)rawpacket; (void)cmd;
 	//debugMessage("Ping!");
-	std::string cmd = "PIN";
-	wsSend(cmd);
+	wsSend("PIN");
 }
 
 //todo: Lots of duplicated between sendChannelMessage() and sendChannelAdvertisement() that can be refactored into a common function. 
@@ -1329,147 +1617,134 @@ void FSession::sendChannelMessage(QString channelname, QString message)
 	//Confirm channel is known, joined and has the right permissions.
 	FChannel *channel = getChannel(channelname);
 	if(!channel) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but the channel is unknown or has never been joined. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but the channel is unknown or has never been joined. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
 	if(!channel->isJoined()) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but you are not currently in the channel. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but you are not currently in the channel. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
 	if(channel->mode == ChannelMode::Ads) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but the channel only allows advertisements. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but the channel only allows advertisements. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
-	JSONNode nodes;
-	nodes.push_back(JSONNode("channel", channelname.toStdString()));
-	nodes.push_back(JSONNode("message", message.toStdString()));
-	wsSend("MSG", nodes);
+	JSONStreamWriter &out = beginCommand("MSG");
+	writeField(out, "channel", channelname);
+	writeField(out, "message", message);
+	sendCommand();
 	//Send the message to the UI now.
 	QString messagefinal = makeMessage(message.toHtmlEscaped(), character, getCharacter(character), channel);
 	FMessage fmessage(messagefinal, MessageType::Chat);
 	fmessage.toChannel(channelname).fromChannel(channelname).fromCharacter(this->character).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 void FSession::sendChannelAdvertisement(QString channelname, QString message)
 {
 	//Confirm channel is known, joined and has the right permissions.
 	FChannel *channel = getChannel(channelname);
 	if(!channel) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but the channel is unknown or has never been joined. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but the channel is unknown or has never been joined. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
 	if(!channel->isJoined()) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but you are not currently in the channel. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but you are not currently in the channel. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
 	if(channel->mode == ChannelMode::Chat) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but the channel does not allow advertisements. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but the channel does not allow advertisements. Message: %2").arg(channelname).arg(message), MessageType::Feedback);
 		return;
 	}
-	JSONNode nodes;
-	nodes.push_back(JSONNode("channel", channelname.toStdString()));
-	nodes.push_back(JSONNode("message", message.toStdString()));
-	wsSend("LRP", nodes);
+	JSONStreamWriter &out = beginCommand("LRP");
+	writeField(out, "channel", channelname);
+	writeField(out, "message", message);
+	sendCommand();
 	//Send the message to the UI now.
 	QString messagefinal = makeMessage(message.toHtmlEscaped(), character, getCharacter(character), channel, "<font color=\"green\"><b>Roleplay ad by</font> ", "");
 	FMessage fmessage(messagefinal, MessageType::RpAd);
 	fmessage.toChannel(channelname).fromChannel(channelname).fromCharacter(this->character).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 void FSession::sendCharacterMessage(QString charactername, QString message)
 {
 	//Confirm character is known, online and we are not ignoring them.
 	if(!isCharacterOnline(charactername)) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but they are offline or unknown. Message: %2").arg(charactername).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but they are offline or unknown. Message: %2").arg(charactername).arg(message), MessageType::Feedback);
 		return;
 	}
 	if(isCharacterIgnored(charactername)) {
-		account->ui->messageSystem(this, QString("Tried to send a message to '%1' but YOU are ignoring them. Message: %2").arg(charactername).arg(message), MessageType::Feedback);
+		ui()->messageSystem(this, QString("Tried to send a message to '%1' but YOU are ignoring them. Message: %2").arg(charactername).arg(message), MessageType::Feedback);
 		return;
 	}
 	//Make packet and send it.
-	JSONNode nodes;
-	nodes.push_back(JSONNode("recipient", charactername.toStdString()));
-	nodes.push_back(JSONNode("message", message.toStdString()));
-	wsSend("PRI", nodes);
+	JSONStreamWriter &out = beginCommand("PRI");
+	writeField(out, "recipient", charactername);
+	writeField(out, "message", message);
+	sendCommand();
 	//Send the message to the UI now.
 	QString messagefinal = makeMessage(message.toHtmlEscaped(), this->character, getCharacter(this->character));
 	FMessage fmessage(messagefinal, MessageType::Chat);
 	fmessage.toCharacter(charactername).fromCharacter(this->character).fromSession(sessionid);
-	account->ui->messageMessage(fmessage);
+	ui()->messageMessage(fmessage);
 }
 
 void FSession::sendChannelLeave(QString channelname)
 {
-	JSONNode nodes;
-	nodes.push_back(JSONNode("channel", channelname.toStdString()));
-	wsSend("LCH", nodes);
+	JSONStreamWriter &out = beginCommand("LCH");
+	writeField(out, "channel", channelname);
+	sendCommand();
 } 
 
 void FSession::sendConfirmStaffReport(QString callid)
 {
-	JSONNode nodes;
-	nodes.push_back(JSONNode("action", "confirm"));
-	nodes.push_back(JSONNode("moderator", character.toStdString()));
-	nodes.push_back(JSONNode("callid", callid.toStdString()));
-	wsSend("SFC", nodes);
+	JSONStreamWriter &out = beginCommand("SFC");
+	writeField(out, "action", "confirm");
+	writeField(out, "moderator", character);
+	writeField(out, "callid", callid);
+	sendCommand();
 }
 
 void FSession::sendSubmitStaffReport(QString character, std::string logId, QString report) {
-	JSONNode node;
-	JSONNode actionnode("action", "report");
-	JSONNode logidnode("logid", logId);
-	JSONNode charnode("character", character.toStdString());
-	JSONNode reportnode("report", report.toStdString());
-	node.push_back(actionnode);
-	node.push_back(charnode);
-	node.push_back(reportnode);
-	node.push_back(logidnode);
-	wsSend("SFC", node);
+	JSONStreamWriter &out = beginCommand("SFC");
+	writeField(out, "action", "report");
+	writeField(out, "character", character);
+	writeField(out, "report", report);
+	writeField(out, "logid", logId);
+	sendCommand();
 }
 
 void FSession::sendIgnoreAdd(QString character)
 {
 	character = character.toLower();
-	JSONNode ignorenode;
-	JSONNode targetnode ( "character", character.toStdString() );
-	JSONNode actionnode ( "action", "add" );
-	ignorenode.push_back ( targetnode );
-	ignorenode.push_back ( actionnode );
-	wsSend("IGN", ignorenode);
+	JSONStreamWriter &out = beginCommand("IGN");
+	writeField(out, "character", character);
+	writeField(out, "action", "add");
+	sendCommand();
 }
 
 void FSession::sendIgnoreDelete(QString character)
 {
 	character = character.toLower();
-	JSONNode ignorenode;
-	JSONNode targetnode ( "character", character.toStdString() );
-	JSONNode actionnode ( "action", "delete" );
-	ignorenode.push_back ( targetnode );
-	ignorenode.push_back ( actionnode );
-	wsSend("IGN", ignorenode);
+	JSONStreamWriter &out = beginCommand("IGN");
+	writeField(out, "character", character);
+	writeField(out, "action", "delete");
+	sendCommand();
 }
 
 void FSession::sendStatus(QString status, QString statusmsg)
 {
-	JSONNode stanode;
-	JSONNode statusnode ( "status", status.toStdString() );
-	JSONNode stamsgnode ( "statusmsg", statusmsg.toStdString() );
-	stanode.push_back ( statusnode );
-	stanode.push_back ( stamsgnode );
-	wsSend("STA", stanode);
+	JSONStreamWriter &out = beginCommand("STA");
+	writeField(out, "status", status);
+	writeField(out, "statusmsg", statusmsg);
+	sendCommand();
 }
 
 void FSession::sendCharacterTimeout(QString character, int minutes, QString reason)
 {
-	JSONNode node;
-	JSONNode charnode("character", character.toStdString());
-	JSONNode timenode("time", QString::number(minutes).toStdString());
-	JSONNode renode("reason", reason.toStdString());
-	node.push_back ( charnode );
-	node.push_back ( timenode );
-	node.push_back ( renode );
-	wsSend("TMO", node);
+	JSONStreamWriter &out = beginCommand("TMO");
+	writeField(out, "character", character);
+	writeField(out, "time", QString::number(minutes));
+	writeField(out, "reason", reason);
+	sendCommand();
 }
 
 void FSession::sendTypingNotification(QString character, TypingStatus status)
@@ -1482,230 +1757,191 @@ void FSession::sendTypingNotification(QString character, TypingStatus status)
 	case TYPING_STATUS_TYPING: statusText = "typing"; break;
 	}
 
-	JSONNode node;
-	JSONNode statusnode("status", statusText);
-	JSONNode charnode("character", character.toStdString());
-	node.push_back(statusnode);
-	node.push_back(charnode);
-	wsSend("TPN", node);
+	JSONStreamWriter &out = beginCommand("TPN");
+	writeField(out, "status", statusText);
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::sendDebugCommand(QString payload)
 {
-	JSONNode node;
-	JSONNode cmd("command", payload.toStdString());
-	node.push_back(cmd);
-	wsSend("ZZZ", node);
+	JSONStreamWriter &out = beginCommand("ZZZ");
+	writeField(out, "command", payload);
+	sendCommand();
 }
 
 void FSession::kickFromChannel(QString channel, QString character)
 {
-	JSONNode kicknode;
-	JSONNode charnode ( "character", character.toStdString() );
-	JSONNode channode ( "channel", channel.toStdString() );
-	kicknode.push_back ( charnode );
-	kicknode.push_back ( channode );
-	wsSend("CKU", kicknode);
+	JSONStreamWriter &out = beginCommand("CKU");
+	writeField(out, "character", character);
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::kickFromChat(QString character)
 {
-	JSONNode kicknode;
-	JSONNode charnode ( "character", character.toStdString() );
-	kicknode.push_back ( charnode );
-	wsSend("KIK", kicknode);
+	JSONStreamWriter &out = beginCommand("KIK");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::banFromChannel(QString channel, QString character)
 {
-	JSONNode bannode;
-	JSONNode charnode ( "character", character.toStdString() );
-	JSONNode channode ( "channel", channel.toStdString() );
-	bannode.push_back ( charnode );
-	bannode.push_back ( channode );
-	wsSend("CBU", bannode);
+	JSONStreamWriter &out = beginCommand("CBU");
+	writeField(out, "character", character);
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::banFromChat(QString character)
 {
-	JSONNode node;
-	JSONNode charnode ( "character", character.toStdString() );
-	node.push_back ( charnode );
-	wsSend("ACB", node);
+	JSONStreamWriter &out = beginCommand("ACB");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::unbanFromChannel(QString channel, QString character)
 {
-	JSONNode bannode;
-	JSONNode charnode ( "character", character.toStdString() );
-	JSONNode channode ( "channel", channel.toStdString() );
-	bannode.push_back ( charnode );
-	bannode.push_back ( channode );
-	wsSend("CUB", bannode);
+	JSONStreamWriter &out = beginCommand("CUB");
+	writeField(out, "character", character);
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::unbanFromChat(QString character)
 {
-	JSONNode node;
-	JSONNode charnode ( "character", character.toStdString() );
-	node.push_back ( charnode );
-	wsSend("UNB", node);
+	JSONStreamWriter &out = beginCommand("UNB");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::setRoomIsPublic(QString channel, bool isPublic)
 {
-	JSONNode statusnode;
-	JSONNode channelNode("channel", channel.toStdString());
-	JSONNode statNode("status", isPublic ? "public" : "private");
-	statusnode.push_back(channelNode);
-	statusnode.push_back(statNode);
-	wsSend("RST", statusnode);
+	JSONStreamWriter &out = beginCommand("RST");
+	writeField(out, "channel", channel);
+	writeField(out, "status", isPublic ? "public" : "private");
+	sendCommand();
 }
 
 void FSession::inviteToChannel(QString channel, QString character)
 {
-	JSONNode invitenode;
-	JSONNode charnode("character", character.toStdString());
-	JSONNode channode("channel", channel.toStdString());
-	invitenode.push_back(channode);
-	invitenode.push_back(charnode);
-	wsSend("CIU", invitenode);
+	JSONStreamWriter &out = beginCommand("CIU");
+	writeField(out, "channel", channel);
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::giveChanop(QString channel, QString character)
 {
-	JSONNode opnode;
-	JSONNode charnode("character", character.toStdString());
-	JSONNode channode("channel", channel.toStdString());
-	opnode.push_back(charnode);
-	opnode.push_back(channode);
-	wsSend("COA", opnode);
+	JSONStreamWriter &out = beginCommand("COA");
+	writeField(out, "character", character);
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::takeChanop(QString channel, QString character)
 {
-	JSONNode opnode;
-	JSONNode charnode("character", character.toStdString());
-	JSONNode channode("channel", channel.toStdString());
-	opnode.push_back(charnode);
-	opnode.push_back(channode);
-	wsSend("COR", opnode);
+	JSONStreamWriter &out = beginCommand("COR");
+	writeField(out, "character", character);
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::giveGlobalop(QString character)
 {
-	JSONNode opnode;
-	JSONNode charnode("character", character.toStdString());
-	opnode.push_back(charnode);
-	wsSend("AOP", opnode);
+	JSONStreamWriter &out = beginCommand("AOP");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::takeGlobalop(QString character)
 {
-	JSONNode opnode;
-	JSONNode charnode("character", character.toStdString());
-	opnode.push_back(charnode);
-	wsSend("DOP", opnode);
+	JSONStreamWriter &out = beginCommand("DOP");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::giveReward(QString character)
 {
-	JSONNode node;
-	JSONNode charnode("character", character.toStdString());
-	node.push_back(charnode);
-	wsSend("RWD", node);
+	JSONStreamWriter &out = beginCommand("RWD");
+	writeField(out, "character", character);
+	sendCommand();
 }
 
 void FSession::requestChannelBanList(QString channel)
 {
-	JSONNode node;
-	JSONNode channode("channel", channel.toStdString());
-	node.push_back(channode);
-	wsSend("CBL", node);
+	JSONStreamWriter &out = beginCommand("CBL");
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::requestChanopList(QString channel)
 {
-	JSONNode node;
-	JSONNode channode("channel", channel.toStdString());
-	node.push_back(channode);
-	wsSend("COL", node);
+	JSONStreamWriter &out = beginCommand("COL");
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::killChannel(QString channel)
 {
-	JSONNode node;
-	JSONNode channode("channel", channel.toStdString());
-	node.push_back(channode);
-	wsSend("KIC", node);
+	JSONStreamWriter &out = beginCommand("KIC");
+	writeField(out, "channel", channel);
+	sendCommand();
 }
 
 void FSession::broadcastMessage(QString message)
 {
-	JSONNode node;
-	JSONNode msgnode("message", message.toStdString());
-	node.push_back(msgnode);
-	wsSend("BRO", node);
+	JSONStreamWriter &out = beginCommand("BRO");
+	writeField(out, "message", message);
+	sendCommand();
 }
 
 void FSession::setChannelDescription(QString channelname, QString description)
 {
-	JSONNode node;
-	JSONNode channode("channel", channelname.toStdString());
-	JSONNode descnode("description", description.toStdString());
-	node.push_back(channode);
-	node.push_back(descnode);
-	wsSend("CDS", node);
+	JSONStreamWriter &out = beginCommand("CDS");
+	writeField(out, "channel", channelname);
+	writeField(out, "description", description);
+	sendCommand();
 }
 
 void FSession::setChannelMode(QString channel, ChannelMode mode)
 {
-	JSONNode node;
-	JSONNode channode("channel", channel.toStdString());
-	JSONNode modenode("mode", enumToKey(mode).toLower().toStdString());
-	node.push_back(channode);
-	node.push_back(modenode);
-	wsSend("RMO", node);
+	JSONStreamWriter &out = beginCommand("RMO");
+	writeField(out, "channel", channel);
+	writeField(out, "mode", enumToKey(mode).toLower());
+	sendCommand();
 }
 
 void FSession::setChannelOwner(QString channel, QString newOwner)
 {
-	JSONNode node;
-	JSONNode channode("channel", channel.toStdString());
-	JSONNode ownernode("character", newOwner.toStdString());
-	node.push_back(channode);
-	node.push_back(ownernode);
-	wsSend("CSO", node);
+	JSONStreamWriter &out = beginCommand("CSO");
+	writeField(out, "channel", channel);
+	writeField(out, "character", newOwner);
+	sendCommand();
 }
 
 void FSession::spinBottle(QString channel)
 {
-	JSONNode node;
-	JSONNode channode("channel",channel.toStdString());
-	JSONNode dicenode("dice", "bottle");
-	node.push_back(channode);
-	node.push_back(dicenode);
-	wsSend("RLL", node);
+	JSONStreamWriter &out = beginCommand("RLL");
+	writeField(out, "channel", channel);
+	writeField(out, "dice", "bottle");
+	sendCommand();
 }
 
 void FSession::rollDiceChannel(QString channel, QString dice)
 {
-	JSONNode node;
-	JSONNode channode("channel",channel.toStdString());
-	JSONNode dicenode("dice", dice.toStdString());
-	node.push_back(channode);
-	node.push_back(dicenode);
-	wsSend("RLL", node);
+	JSONStreamWriter &out = beginCommand("RLL");
+	writeField(out, "channel", channel);
+	writeField(out, "dice", dice);
+	sendCommand();
 }
 
 void FSession::rollDicePM(QString recipient, QString dice)
 {
-	JSONNode node;
-	JSONNode channode("recipient",recipient.toStdString());
-	JSONNode dicenode("dice", dice.toStdString());
-	node.push_back(channode);
-	node.push_back(dicenode);
-	wsSend("RLL", node);
+	JSONStreamWriter &out = beginCommand("RLL");
+	writeField(out, "recipient", recipient);
+	writeField(out, "dice", dice);
+	sendCommand();
 }
 
 void FSession::requestChannels()
@@ -1716,9 +1952,10 @@ void FSession::requestChannels()
 
 void FSession::requestProfileKinks(QString character)
 {
-	JSONNode node;
-	JSONNode cn("character", character.toStdString());
-	node.push_back(cn);
-	wsSend("PRO", node);
-	wsSend("KIN", node);
+	JSONStreamWriter &out = beginCommand("PRO");
+	writeField(out, "character", character);
+	sendCommand();
+	beginCommand("KIN");
+	writeField(out, "character", character);
+	sendCommand();
 }
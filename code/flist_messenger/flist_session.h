@@ -1,49 +1,130 @@
 #ifndef FLIST_SESSION_H
 #define FLIST_SESSION_H
 
+#include <functional>
+
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QHash>
+#include <QSet>
 #include <QtWebSockets/QWebSocket>
 #include <QQueue>
 
 #include "flist_channelsummary.h"
+#include "flist_commands.h"
 #include "flist_enums.h"
+#include "flist_metrics.h"
+#include "flist_names.h"
+#include "flist_roster.h"
+#include "flist_sessionworker.h"
 #include "notifylist.h"
 
 class FAccount;
 class FChannel;
 class FCharacter;
-class JSONNode;
+class iUserInterface;
+class QThread;
+
+/**
+Traffic counters and latency histograms for a single server command. Times are in nanoseconds. Handler
+time leaves out the time spent in the user interface, which is counted separately.
+ */
+class FCommandStats
+{
+public:
+	FCommandStats() :
+		frames(0),
+		bytes(0),
+		parsefailures(0),
+		deferred(0),
+		sizes(),
+		parsetime(),
+		handlertime(),
+		uitime()
+	{}
+
+	quint64 frames; //< Number of frames received.
+	quint64 bytes; //< Total size of those frames, command included.
+	quint64 parsefailures; //< Frames that had invalid JSON or were missing a field the handler required.
+	quint64 deferred; //< Frames put off until a backlog cleared.
+	FHistogram sizes; //< Frame sizes in bytes.
+	FHistogram parsetime; //< Time to parse the JSON, on the worker thread.
+	FHistogram handlertime; //< Time in the command handler.
+	FHistogram uitime; //< Time in iUserInterface calls and signals made by the handler.
+};
+
+/**
+A low priority frame waiting in FSession's deferred queue, with who and where it is from, so that the queue
+can be searched without going back to the JSON.
+ */
+class FDeferredFrame
+{
+public:
+	FDeferredFrame() : frame(), channel(), character(0) {}
+	FDeferredFrame(const FSessionFrame &frame, const QString &channel, FCharacterId character) : frame(frame), channel(channel), character(character) {}
+
+	FSessionFrame frame;
+	QString channel; //< The channel the frame is for.
+	FCharacterId character; //< The character it is from, 0 if they aren't known.
+};
 
 class FSession : public QObject
 {
 Q_OBJECT
 public:
+	typedef std::function<void(const QByteArray &rawpacket, FSessionFrame &frame)> CommandHandler;
+
+	static const int backlogthreshold = 32; //< A batch this big counts as a backlog, and low priority frames in it are deferred.
+	static const int backloglatency = 50; //< Milliseconds a batch can wait for the GUI thread before it counts as a backlog, however small it is.
+	static const int deferredbudget = 8; //< Milliseconds to spend on deferred frames before letting the event loop run again.
+	static const int namesweepminimum = 4096; //< Names the table can hold before sweepNames() first looks for ones nobody refers to.
+
 	explicit FSession(FAccount *account, QString &character, QObject *parent = 0);
 	~FSession();
 
 	QString getSessionID() {return sessionid;}
 
 	void connectSession();
+	QString getSocketErrorString() {return socketerrorstring;}
 	
 	void wsSend(const char *command);
-	void wsSend(const char *command, JSONNode &nodes);
+	void wsSend(const JSONStreamWriter &out);
 	void wsSend(std::string &data);
-	void wsRecv(std::string packet);
-
-	bool isCharacterOnline(QString name) {return characterlist.contains(name);}
-	bool isCharacterOperator(QString name) {return operatorlist.contains(name);}
-	bool isCharacterIgnored(QString name) {return ignorelist.contains(name.toLower(), Qt::CaseInsensitive);}
-	bool isCharacterFriend(QString name) {return friendslist.contains(name);}
+	void wsRecv(const QByteArray &packet);
+
+	static quint32 packCommand(const char *command, int length = 3);
+	static QString unpackCommand(quint32 code);
+	void registerCommand(const char *command, CommandHandler handler);
+	void unregisterCommand(const char *command);
+	const QHash<quint32, FCommandStats> &getCommandStats() {return commandstats;}
+	const FHistogram &getBatchSizes() {return batchsizes;}
+	const FHistogram &getBatchBacklog() {return batchbacklog;}
+	const FHistogram &getDeferredDepths() {return deferreddepths;}
+	const FHistogram &getPriorityLatencies() {return prioritylatencies;}
+	void resetCommandStats();
+	int getDeferredFrameCount() {return deferredframes.count();}
+
+	FNameTable &getNames() {return names;}
+	const FRoster &getRoster() {return roster;}
+	bool isCharacterOnline(FCharacterId id) {return roster.get(id) != 0;}
+	bool isCharacterOnline(QString name) {return isCharacterOnline(names.find(name));}
+	bool isCharacterOperator(FCharacterId id) {return operatorlist.contains(id);}
+	bool isCharacterOperator(QString name) {return isCharacterOperator(names.find(name));}
+	bool isCharacterIgnored(FCharacterId id) {return ignoreids.contains(id);}
+	bool isCharacterIgnored(QString name) {return isCharacterIgnored(names.find(name));}
+	bool isCharacterFriend(FCharacterId id) {return friendslist.contains(id);}
+	bool isCharacterFriend(QString name) {return isCharacterFriend(names.find(name));}
 	FCharacter *addCharacter(QString name);
-	FCharacter *getCharacter(QString name) {return characterlist.contains(name) ? characterlist[name] : 0;}
-	void removeCharacter(QString name);
-	int getCharacterCount() {return characterlist.count();}
+	FCharacter *getCharacter(FCharacterId id) {return roster.get(id);}
+	FCharacter *getCharacter(QString name) {return getCharacter(names.find(name));}
+	void removeCharacter(FCharacterId id) {roster.remove(id);}
+	int getCharacterCount() {return roster.count();}
+	FCharacterProfile *getCharacterProfile(FCharacterId id) {return roster.findProfile(id);}
 	QString getCharacterUrl(QString name) {return "https://www.f-list.net/c/" + name + "/";} //todo: HTTP request character encoding. //todo: Get server address from FServer?
 	QString getCharacterHtml(QString name);
 
-	QStringList &getFriendsList() {return friendslist;}
+	const QSet<FCharacterId> &getFriendsList() {return friendslist;}
 	NotifyStringList &getIgnoreList() {return ignorelist;}
 
 	void joinChannel(QString name);
@@ -96,6 +177,7 @@ signals:
 	void recvMessage(QString type, QString session, QString chan, QString sender, QString message);
 	
 	void notifyCharacterOnline(FSession *session, QString charactername, bool online);
+	void notifyCharactersOnline(FSession *session, QStringList characternames, bool online);
 	void notifyCharacterStatusUpdate(FSession *session, QString charactername);
 	void notifyIgnoreList(FSession *s);
 	void notifyIgnoreAdd(FSession *s, QString character);
@@ -103,26 +185,47 @@ signals:
 
 public slots:
 	void socketConnected();
-	void socketError(QAbstractSocket::SocketError);
+	void socketError(QAbstractSocket::SocketError error, QString errorstring);
 	void socketSslError(QList<QSslError> sslerrors);
-	void socketReceivedTextMessage(const QString &message);
+	void processFrames(FSessionFrameBatch frames);
+
+private slots:
+	void processDeferredFrames();
 
 public:
 	FAccount *account;
 	QString sessionid;
 	QString character;
 
-	QWebSocket *socket;
+private:
+	QThread *workerthread; //< Thread that the socket lives on and where frames are parsed.
+	FSessionWorker *worker; //< Owns the socket, lives on workerthread.
+	QString socketerrorstring; //< Description of the last socket error.
 
 private:
-	QHash<QString, FCharacter *> characterlist; //< List of all known characters on the server/session.
-	QStringList friendslist; //<List of friends for this session's character.
+	FNameTable names; //< IDs for every character name this session refers to. The lists below all refer to characters by ID.
+	int namesweepsize; //< Number of names at which sweepNames() next runs.
+	FRoster roster; //< All characters online on the server/session.
+	QSet<FCharacterId> friendslist; //<List of friends for this session's character.
 	QStringList bookmarklist; //<List of friends for this session's character.
-	QMap<QString, QString> operatorlist; //<List of all known characters that are chat operators (indexed by lower case).
-	NotifyStringList ignorelist; //<List of all characters that are being ignored.
+	QSet<FCharacterId> operatorlist; //<List of all known characters that are chat operators.
+	NotifyStringList ignorelist; //<List of all characters that are being ignored, in lower case, for the ignore list dialog.
+	QSet<FCharacterId> ignoreids; //<The same characters as ignorelist, for checking messages against.
 	QHash<QString, FChannel *> channellist; //<List of channels that this session has joined (or was previously joined to).
 
 	QQueue<QString> joinQueue;
+	JSONStreamWriter sendbuffer; //<Outgoing commands are written here, and it is reused so that sending doesn't allocate.
+
+	QHash<quint32, CommandHandler> commandhandlers; //<Handlers for server commands, indexed by packCommand().
+	QHash<quint32, FCommandStats> commandstats; //<Traffic counters for every command received, including unknown ones.
+	QQueue<FDeferredFrame> deferredframes; //<Low priority frames waiting for a backlog to clear, oldest first.
+	bool deferredqueued; //<True if processDeferredFrames() is already waiting in the event queue.
+	FHistogram batchsizes; //<Frames in each batch from the worker.
+	FHistogram batchbacklog; //<Batches still waiting to be handled behind each batch from the worker.
+	FHistogram deferreddepths; //<Frames left deferred after each batch.
+	FHistogram prioritylatencies; //<Nanoseconds from reading each high priority frame to handling it.
+	qint64 uitime; //<Running total of nanoseconds spent in the user interface, see ui().
+	FTimedUserInterface timedui; //<The account's user interface, adding to uitime.
 
 public:
 	QStringList autojoinchannels; //<List of channels the client should join upon connecting.
@@ -132,9 +235,23 @@ public:
 	QList<FChannelSummary> knownopenroomlist; //<List of known open rooms, as reported by the server.
 
 private:
+	/** The user interface, timed so that dispatchFrame() can tell how much of a handler's time went on it. */
+	iUserInterface *ui() {return &timedui;}
 	void processJoinQueue();
-
-#define COMMAND(name) void cmd##name(std::string &rawpacket, JSONNode &nodes)
+	void registerCommands();
+	void dispatchFrame(FSessionFrame &frame);
+	FramePriority framePriority(quint32 code, const FSessionFrame &frame, QString &channelname);
+	void flushDeferredFrames(const QString &charactername, const QString &channelname);
+	void sweepNames();
+	void sendTextMessage(const QString &message);
+	void send(const char *data, size_t length);
+	JSONStreamWriter &beginCommand(const char *command);
+	void sendCommand();
+	void sendIdentity();
+	void writeIdentity(JSONStreamWriter &out);
+	void stopWorker();
+
+#define COMMAND(name) void cmd##name(const QByteArray &rawpacket, const FCmd##name &cmd)
 	COMMAND(ADL);
 	COMMAND(AOP);
 	COMMAND(DOP);
@@ -153,7 +270,7 @@ private:
 	COMMAND(FLN);
 	COMMAND(STA);
 
-	COMMAND(CBUCKU);
+	void cmdCBUCKU(const QByteArray &rawpacket, const QString &channelname, const QString &charactername, const QString &operatorname, bool banned);
 	COMMAND(CBU);
 	COMMAND(CKU);
 
@@ -0,0 +1,151 @@
+
+#include <QElapsedTimer>
+
+#include "flist_sessionworker.h"
+#include "flist_global.h"
+#include "flist_capture.h"
+#include "flist_commands.h"
+
+/**
+Split a frame into its command and body, and fully parse the body. The body is parsed in place and
+frozen, so that nothing is left for libjson to lazily decode or index on whichever thread reads it later,
+and copies of it can be read and thrown away on any thread; every handler decodes all of its fields as
+soon as it runs, so none of them gains from leaving it lazy.
+Frames come from the server, which only sends valid JSON, so the literals in them aren't checked.
+Streamed commands are decoded straight from the body instead, without building any nodes.
+
+The nodes are allocated from a libjson arena of their own, which is emptied and recycled for a later
+frame once the last copy of this one has been thrown away.
+ */
+FSessionFrame FSessionFrame::decode(const QByteArray &packet)
+{
+	FSessionFrame frame;
+	frame.packet = packet;
+	frame.received = clock();
+	if(packet.length() > 4) {
+		QElapsedTimer timer;
+		timer.start();
+		try {
+			frame.command = decodeStreamedCommand(packet.constData(), packet.constData() + 4, packet.length() - 4);
+			if(!frame.command) {
+				JSONArena::Scope arena;
+				frame.nodes = libJSON::parse(packet.constData() + 4, packet.length() - 4, JSON_PARSE_TRUSTED);
+				frame.nodes.freeze();
+			}
+		} catch(std::invalid_argument) {
+			frame.valid = false;
+		} catch(std::out_of_range) {
+			//A streamed command that was missing a field it needs.
+			frame.valid = false;
+		}
+		frame.parsetime = timer.nsecsElapsed();
+	}
+	return frame;
+}
+
+/**
+Nanoseconds on a monotonic clock shared by every thread, for measuring how long a frame waits between
+being read and being handled.
+ */
+qint64 FSessionFrame::clock()
+{
+	static QElapsedTimer timer;
+	static bool started = (timer.start(), true);
+	(void)started;
+	return timer.nsecsElapsed();
+}
+
+FSessionWorker::FSessionWorker(QString sessionid, QObject *parent) :
+	QObject(parent),
+	sessionid(sessionid),
+	socket(nullptr),
+	pendingframes(),
+	flushqueued(false),
+	queuedbatches(0)
+{
+}
+
+FSessionWorker::~FSessionWorker()
+{
+	if(socket) {
+		socket->abort();
+	}
+}
+
+void FSessionWorker::open(QUrl url)
+{
+	if(socket) {
+		return;
+	}
+	//Created here rather than in the constructor, so that the socket belongs to the worker thread.
+	socket = new QWebSocket("file:///", QWebSocketProtocol::VersionLatest, this);
+	connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, &FSessionWorker::socketError);
+	connect(socket, &QWebSocket::sslErrors, this, &FSessionWorker::sslErrors);
+	connect(socket, &QWebSocket::connected, this, &FSessionWorker::connected);
+	connect(socket, &QWebSocket::textMessageReceived, this, &FSessionWorker::socketReceivedTextMessage);
+	socket->open(url);
+}
+
+void FSessionWorker::sendTextMessage(QString message)
+{
+	if(!socket) {
+		return;
+	}
+	socket->sendTextMessage(message);
+}
+
+void FSessionWorker::socketError(QAbstractSocket::SocketError error)
+{
+	QString errorstring = socket->errorString();
+	//Anything already received is still delivered ahead of the error.
+	flushFrames();
+	socket->abort();
+	socket->deleteLater();
+	socket = nullptr;
+	emit this->error(error, errorstring);
+}
+
+void FSessionWorker::socketReceivedTextMessage(const QString &message)
+{
+	if(!pendingframes) {
+		pendingframes = FSessionFrameBatch(new QList<FSessionFrame>());
+	}
+	QByteArray packet = message.toUtf8();
+	if(capture) {
+		capture->record(FCapture::Inbound, sessionid, packet);
+	}
+	pendingframes->append(FSessionFrame::decode(packet));
+	if(pendingframes->count() >= maxbatchsize) {
+		flushFrames();
+	} else if(!flushqueued) {
+		//Everything that arrives before the event loop gets back to us goes out in the same batch.
+		flushqueued = true;
+		QMetaObject::invokeMethod(this, "flushFrames", Qt::QueuedConnection);
+	}
+}
+
+void FSessionWorker::flushFrames()
+{
+	flushqueued = false;
+	if(!pendingframes) {
+		return;
+	}
+	FSessionFrameBatch frames;
+	frames.swap(pendingframes);
+	queuedbatches.ref();
+	emit framesReceived(frames);
+}
+
+/**
+Called by the session on the GUI thread as it starts on a batch. Returns how many batches are still
+waiting behind it, which is how far the GUI thread has fallen behind the socket.
+ */
+int FSessionWorker::batchHandled()
+{
+	//A batch from a worker that has since been replaced can still arrive, so never go below zero.
+	int batches;
+	do {
+		batches = queuedbatches.loadAcquire();
+	} while(batches > 0 && !queuedbatches.testAndSetOrdered(batches, batches - 1));
+	return qMax(0, batches - 1);
+}
@@ -0,0 +1,96 @@
+#ifndef FLIST_SESSIONWORKER_H
+#define FLIST_SESSIONWORKER_H
+
+#include <memory>
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QSharedPointer>
+#include <QUrl>
+#include <QMetaType>
+#include <QAtomicInt>
+#include <QtWebSockets/QWebSocket>
+
+#include "../libjson/libJSON.h"
+
+/**
+A single frame from the server, already decoded into JSON, or for the few commands that are streamed,
+straight into their FCmdXXX.
+ */
+class FSessionFrame
+{
+public:
+	FSessionFrame() :
+		packet(),
+		nodes(),
+		command(),
+		valid(true),
+		parsetime(0),
+		received(0)
+	{}
+
+	static FSessionFrame decode(const QByteArray &packet);
+	static qint64 clock();
+
+	QByteArray packet; //< The raw frame as UTF-8, command included.
+	JSONNode nodes; //< The fully parsed body of the frame, empty if the frame had no body or was streamed.
+	std::shared_ptr<void> command; //< The FCmdXXX for a command in COMMANDDEF_STREAMED, otherwise null.
+	bool valid; //< False if the body could not be parsed as JSON.
+	qint64 parsetime; //< Nanoseconds it took to parse the body.
+	qint64 received; //< When the frame was read, by clock().
+};
+
+/**
+A batch of frames, in the order they were received.
+
+The JSON in a batch is frozen, so a frame can be copied and read on any thread, but the batch is still
+passed around as a single shared list to save copying it; once the worker has handed a batch over it never
+touches it again.
+ */
+typedef QSharedPointer<QList<FSessionFrame> > FSessionFrameBatch;
+Q_DECLARE_METATYPE(FSessionFrameBatch)
+
+/**
+Owns the web socket for a session and lives on the session's worker thread. Frames are transcoded and
+parsed here, then passed back to the session in batches.
+
+Only the socket and the parsing are done here. The command handlers still run on the GUI thread, and so
+does everything they do: updating the roster and channel lists and building message HTML. The UI reads
+those lists directly and without locks, so they can only be changed on the GUI thread.
+ */
+class FSessionWorker : public QObject
+{
+Q_OBJECT
+public:
+	explicit FSessionWorker(QString sessionid, QObject *parent = 0);
+	~FSessionWorker();
+
+	static const int maxbatchsize = 256; //< Flush a batch once it gets this big, even if more frames are waiting.
+
+	int batchHandled();
+
+public slots:
+	void open(QUrl url);
+	void sendTextMessage(QString message);
+
+signals:
+	void connected();
+	void error(QAbstractSocket::SocketError error, QString errorstring);
+	void sslErrors(QList<QSslError> sslerrors);
+	void framesReceived(FSessionFrameBatch frames);
+
+private slots:
+	void socketError(QAbstractSocket::SocketError error);
+	void socketReceivedTextMessage(const QString &message);
+	void flushFrames();
+
+private:
+	QString sessionid; //< Only used to label captured frames.
+	QWebSocket *socket;
+	FSessionFrameBatch pendingframes; //< Frames received since the last flush, null if there are none.
+	bool flushqueued; //< True if a call to flushFrames() is already waiting in the event queue.
+	QAtomicInt queuedbatches; //< Batches sent to the session that it hasn't started on yet. Changed from both threads.
+};
+
+#endif // FLIST_SESSIONWORKER_H
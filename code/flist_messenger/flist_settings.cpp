@@ -2,6 +2,8 @@
 
 #include <QSettings>
 
+#include "flist_global.h"
+
 FSettings::FSettings(QString settingsfile, QObject *parent) :
         QObject(parent),
 	settingsfile(settingsfile)
@@ -29,6 +31,8 @@ GETSETANY(QString, String)
 
 //Account
 GETSET(QString, UserAccount, "Global/account", "")
+//Server
+GETSET(QString, ChatServer, "Global/chat_server", FLIST_CHAT_SERVER)
 //Channels
 GETSET(QString, DefaultChannels, "Global/default_channels", "Frontpage|||F-chat Desktop Client")
 //Logging
@@ -28,6 +28,8 @@ public:
 
 //Account
 	PROTOGETSET(UserAccount, QString)
+//Server
+	PROTOGETSET(ChatServer, QString)
 //Channels
 	PROTOGETSET(DefaultChannels, QString)
 //Logging
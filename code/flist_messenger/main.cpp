@@ -24,22 +24,70 @@
 #include <QTextCodec>
 #include "flist_messenger.h"
 #include "flist_global.h"
+#include "flist_capture.h"
+#include "flist_replay.h"
 
 int main(int argc, char** argv)
 {
-	bool d = (argc > 1 && strcmp(argv[1], "-d") == 0) ? true : false;
+	bool d = false;
+	bool realtime = false;
+	QString capturefile;
+	QString replayfile;
+	QString statsfile;
+	int statsinterval = 60;
+	int latencylimit = 0;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-d") == 0) {
+			d = true;
+		} else if(strcmp(argv[i], "-capture") == 0 && i + 1 < argc) {
+			//Record all session traffic to the given file.
+			capturefile = QString::fromLocal8Bit(argv[++i]);
+		} else if(strcmp(argv[i], "-replay") == 0 && i + 1 < argc) {
+			//Play a capture back into a session without connecting or showing any windows, then exit.
+			replayfile = QString::fromLocal8Bit(argv[++i]);
+		} else if(strcmp(argv[i], "-stats") == 0 && i + 1 < argc) {
+			//Periodically append the '/stats' report to the given file.
+			statsfile = QString::fromLocal8Bit(argv[++i]);
+		} else if(strcmp(argv[i], "-statsinterval") == 0 && i + 1 < argc) {
+			//Seconds between reports written for -stats.
+			statsinterval = QByteArray(argv[++i]).toInt();
+		} else if(strcmp(argv[i], "-latencylimit") == 0 && i + 1 < argc) {
+			//Fail the replay if high priority frames wait longer than this many milliseconds (p99).
+			latencylimit = QByteArray(argv[++i]).toInt();
+		} else if(strcmp(argv[i], "-realtime") == 0) {
+			//Replay with the original timing, instead of as fast as possible.
+			realtime = true;
+		}
+	}
 	QApplication *app = new QApplication(argc, argv);
 	app->setOrganizationName("F-list.net");
 	app->setOrganizationDomain("www.f-list.net");
 	app->setApplicationName("F-list Messenger");
 	globalInit();
+	if(!replayfile.isEmpty()) {
+		int result = runReplay(replayfile, realtime, latencylimit);
+		globalQuit();
+		return result;
+	}
+	if(!capturefile.isEmpty()) {
+		capture = new FCapture();
+		if(!capture->open(capturefile)) {
+			debugMessage("Could not open the capture file '" + capturefile + "'.");
+			delete capture;
+			capture = 0;
+		}
+	}
 	QFile stylefile("default.qss");
 	stylefile.open(QFile::ReadOnly);
 	QString stylesheet = QLatin1String(stylefile.readAll());
 	app->setStyleSheet(stylesheet);
 	flist_messenger::init();
 	flist_messenger *fmessenger = new flist_messenger(d);
+	if(!statsfile.isEmpty() && !fmessenger->startMetricsDump(statsfile, statsinterval)) {
+		debugMessage("Could not open the statistics file '" + statsfile + "'.");
+	}
 	fmessenger->show();
-	return app->exec();
-	//todo: globalQuit();
+	int result = app->exec();
+	globalQuit();
+	return result;
 }
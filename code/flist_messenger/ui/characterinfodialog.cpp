@@ -74,24 +74,32 @@ FCharacterInfoDialog::~FCharacterInfoDialog()
 	delete ui;
 }
 
-void FCharacterInfoDialog::setDisplayedCharacter(FCharacter *c)
+void FCharacterInfoDialog::setDisplayedCharacter(FCharacter *c, FCharacterProfile *p)
 {
 	QString name = QSL("<b>%1</b> (%2)").arg(c->name(),c->statusString());
 	ui->name->setText(name);
 
 	ui->status->setText(c->statusMsg());
-	updateProfile(c);
-	updateKinks(c);
+	updateProfile(p);
+	updateKinks(p);
 }
 
-void FCharacterInfoDialog::updateProfile(FCharacter *c)
+void FCharacterInfoDialog::updateProfile(FCharacterProfile *p)
 {
-	updateKeyValues(c->getProfileDataKeys(), c->getProfileData(), ui->profileTab);
+	if (!p) {
+		ui->profileTab->clear();
+		return;
+	}
+	updateKeyValues(p->getProfileDataKeys(), p->getProfileData(), ui->profileTab);
 }
 
-void FCharacterInfoDialog::updateKinks(FCharacter *c)
+void FCharacterInfoDialog::updateKinks(FCharacterProfile *p)
 {
-	updateKeyValues(c->getCustomKinkDataKeys(), c->getCustomKinkData(), ui->kinkTab);
+	if (!p) {
+		ui->kinkTab->clear();
+		return;
+	}
+	updateKeyValues(p->getCustomKinkDataKeys(), p->getCustomKinkData(), ui->kinkTab);
 }
 
 void FCharacterInfoDialog::updateKeyValues(QStringList &k, QHash<QString,QString> &kv, QTextEdit *te)
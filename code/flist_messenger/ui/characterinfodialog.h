@@ -6,6 +6,7 @@
 #include <QTextEdit>
 
 #include "flist_character.h"
+#include "flist_characterprofile.h"
 
 namespace Ui
 {
@@ -19,9 +20,9 @@ public:
 	explicit FCharacterInfoDialog(QWidget *parent = 0);
 	~FCharacterInfoDialog();
 
-	void setDisplayedCharacter(FCharacter *c);
-	void updateProfile(FCharacter *c);
-	void updateKinks(FCharacter *c);
+	void setDisplayedCharacter(FCharacter *c, FCharacterProfile *p);
+	void updateProfile(FCharacterProfile *p);
+	void updateKinks(FCharacterProfile *p);
 
 signals:
 
@@ -5,6 +5,7 @@
 #include "ui/stringcharacterlistmodel.h"
 
 #include <QListWidgetItem>
+#include <QHash>
 
 class IgnoreDataProvider : public AddRemoveListData
 {
@@ -72,6 +73,7 @@ FriendsDialog::FriendsDialog(FSession *session, QWidget *parent) :
 	connect(ui->lwFriendsList,&QListWidget::itemDoubleClicked, this, &FriendsDialog::friendListDoubleClicked);
 	
 	connect(session, &FSession::notifyCharacterOnline, this, &FriendsDialog::notifyCharacterOnline);
+	connect(session, &FSession::notifyCharactersOnline, this, &FriendsDialog::notifyCharactersOnline);
 	connect(session, &FSession::notifyCharacterStatusUpdate, this, &FriendsDialog::notifyCharacterStatus);	
 	this->notifyFriendsList(session);
 
@@ -120,6 +122,41 @@ void FriendsDialog::notifyCharacterOnline(FSession *s, QString character, bool o
 	}
 }
 
+void FriendsDialog::notifyCharactersOnline(FSession *s, QStringList characters, bool online)
+{
+	//Index what is already listed once, instead of searching the list widget for every character.
+	QMultiHash<QString, QListWidgetItem*> listed;
+	for(int row = 0; row < ui->lwFriendsList->count(); row++)
+	{
+		QListWidgetItem *item = ui->lwFriendsList->item(row);
+		listed.insert(item->text().toLower(), item);
+	}
+	
+	ui->lwFriendsList->setUpdatesEnabled(false);
+	foreach(const QString &character, characters)
+	{
+		if(!s->isCharacterFriend(character)) { continue; }
+		
+		QString key = character.toLower();
+		if(online && !listed.contains(key))
+		{
+			FCharacter *f = s->getCharacter(character);
+			QListWidgetItem *lwi = new QListWidgetItem(*(f->statusIcon()),f->name());
+			ui->lwFriendsList->addItem(lwi);
+			listed.insert(key, lwi);
+		}
+		else if(!online)
+		{
+			foreach(QListWidgetItem *i, listed.values(key))
+			{
+				delete (ui->lwFriendsList->takeItem(ui->lwFriendsList->row(i)));
+			}
+			listed.remove(key);
+		}
+	}
+	ui->lwFriendsList->setUpdatesEnabled(true);
+}
+
 void FriendsDialog::notifyCharacterStatus(FSession *s, QString character)
 {
 	FCharacter *c = s->getCharacter(character);
@@ -140,15 +177,16 @@ void FriendsDialog::notifyFriendsList(FSession *s)
 	}
 	
 	ui->lwFriendsList->clear();
-	foreach(QString i, s->getFriendsList())
+	foreach(FCharacterId i, s->getFriendsList())
 	{
-		if(session->isCharacterOnline(i))
+		FCharacter *f = s->getCharacter(i);
+		if(f)
 		{
-			FCharacter *f = session->getCharacter(i);
 			QListWidgetItem *lwi = new QListWidgetItem(*(f->statusIcon()), f->name());
 			ui->lwFriendsList->addItem(lwi);
 		}
 	}
+	ui->lwFriendsList->sortItems();
 	
 	if(selectedName.length() > 0)
 	{
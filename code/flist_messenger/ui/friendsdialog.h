@@ -31,6 +31,7 @@ signals:
 
 public slots:
 	void notifyCharacterOnline(FSession *s, QString character, bool online);
+	void notifyCharactersOnline(FSession *s, QStringList characters, bool online);
 	void notifyCharacterStatus(FSession *s, QString character);
 	
 	void notifyFriendsList(FSession *s);
@@ -47,6 +47,7 @@ public:
 		              "/code<br />"
 		              "/roll &lt;1d10&gt; (WIP)<br />"
 		              "/status &lt;Online|Looking|Busy|DND&gt; &lt;optional message&gt;<br />"
+		              "/stats &lt;optional reset&gt;<br />"
 		              "<b>Channel owners:</b><br />"
 		              "/makeroom &lt;name&gt;<br />"
 		              "/invite &lt;person&gt;<br />"
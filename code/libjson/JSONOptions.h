@@ -77,6 +77,16 @@
 #define JSON_REF_COUNT
 
 
+/*
+ *  JSON_ATOMIC_REF_COUNT makes the reference counts atomic, so that copies of the same
+ *  node can be made and thrown away on different threads, such as a tree parsed on
+ *  one thread and read on another.  Reading a node normally finishes parsing it as it
+ *  goes, so a tree should have freeze() called on it before it is shared, after which
+ *  nothing that only reads it will change it.  It requires JSON_REF_COUNT
+ */
+#define JSON_ATOMIC_REF_COUNT
+
+
 /*
  *  JSON_BINARY is used to support binary, which is base64 encoded and decoded by libjson,
  *  if this option is not turned on, no base64 support is included
@@ -90,8 +100,10 @@
  *  that some users would like to further add speed by having the library utilize a memory
  *  pool.  With this option turned on, the default behavior is still done internally unless
  *  a callback is registered.  So you can have this option on and mot use it.
+ *  It also provides JSONArena, which lets a block of code allocate its nodes from
+ *  one pool that is thrown away all at once.
  */
-//#define JSON_MEMORY_CALLBACKS
+#define JSON_MEMORY_CALLBACKS
 
 /*
  *  JSON_MEMORY_MANAGE is used to create functionality to automatically track and clean
@@ -193,6 +205,14 @@
 #define JSON_CASE_INSENSITIVE_FUNCTIONS
 
 
+/*
+ *  JSON_INDEX_KEYS makes finding a child by name in a large object take about the
+ *  same time no matter how many children it has, by building a hash table of the
+ *  names the first time one is looked up.  Small objects are still searched in order
+ */
+#define JSON_INDEX_KEYS
+
+
 /*
  *  JSON_UNIT_TEST is used to maintain and debug the libjson.  It makes all private
  *  members and functions public so that tests can do checks of the inner workings
@@ -208,5 +228,13 @@
  */
 //#define JSON_INDEX_TYPE unsigned int
 
+
+/*
+ *  JSON_MAX_DEPTH is how deeply nodes and arrays can be nested in json that is parsed.  The
+ *  parser recurses for each level, so anything nested deeper is rejected rather than let it
+ *  run out of stack.  If this option is not used then 512 is used
+ */
+//#define JSON_MAX_DEPTH 512
+
 #endif
 
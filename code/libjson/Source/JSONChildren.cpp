@@ -2,53 +2,60 @@
 #include "JSONNode.h"
 
 void jsonChildren::inc(void) {
-    if (mysize == mycapacity) { //it's full
-        if (!mycapacity) { //the array hasn't been created yet
-            JSON_ASSERT(!array, JSON_TEXT("Expanding a 0 capacity array, but not null"));
+    if (!array) { //the array hasn't been created yet
 #ifdef JSON_LESS_MEMORY
-            array = json_malloc<JSONNode*>(1);
-            mycapacity = 1;
+        allocate(1);
 #else
-            array = json_malloc<JSONNode*>(8);  //8 seems average for JSON, and it's only 64 bytes
-            mycapacity = 8;
+        allocate(8);  //8 seems average for JSON, and it's only 64 bytes
 #endif
-        } else {
+    } else if (head() -> size == head() -> capacity) { //it's full
 #ifdef JSON_LESS_MEMORY
-            mycapacity += 1;  //increment the size of the array
+        resize(head() -> capacity + 1);  //increment the size of the array
 #else
-            mycapacity <<= 1;  //double the size of the array
+        resize(head() -> capacity << 1);  //double the size of the array
 #endif
-            array = json_realloc<JSONNode*>(array, mycapacity);
-        }
     }
 }
 
 
 void jsonChildren::inc(json_index_t amount) {
     if (!amount) return;
-    if (mysize + amount >= mycapacity) { //it's full
-        if (!mycapacity) { //the array hasn't been created yet
-            JSON_ASSERT(!array, JSON_TEXT("Expanding a 0 capacity array, but not null"));
+    if (!array) { //the array hasn't been created yet
 #ifdef JSON_LESS_MEMORY
-            array = json_malloc<JSONNode*>(amount);
-            mycapacity = amount;
+        allocate(amount);
 #else
-            array = json_malloc<JSONNode*>(amount > 8 ? amount : 8);  //8 seems average for JSON, and it's only 64 bytes
-            mycapacity = amount > 8 ? amount : 8;
+        allocate(amount > 8 ? amount : 8);  //8 seems average for JSON, and it's only 64 bytes
 #endif
-        } else {
+    } else if (head() -> size + amount >= head() -> capacity) { //it's full
 #ifdef JSON_LESS_MEMORY
-            mycapacity = mysize + amount;  //increment the size of the array
+        resize(head() -> size + amount);  //increment the size of the array
 #else
-            while (mysize + amount > mycapacity) {
-                mycapacity <<= 1;  //double the size of the array
-            }
-#endif
-            array = json_realloc<JSONNode*>(array, mycapacity);
+        json_index_t capacity = head() -> capacity;
+        while (head() -> size + amount > capacity) {
+            capacity <<= 1;  //double the size of the array
         }
+        resize(capacity);
+#endif
     }
 }
 
+void jsonChildren::allocate(json_index_t amount) {
+    JSON_ASSERT(!array, JSON_TEXT("allocating an array that already exists"));
+    JSON_ASSERT(amount, JSON_TEXT("allocating an empty array"));
+    array = json_malloc<JSONNode*>(HEADER_SLOTS + amount) + HEADER_SLOTS;
+    head() -> size = 0;
+    head() -> capacity = amount;
+    #ifdef JSON_INDEX_KEYS
+        head() -> index = 0;
+    #endif
+}
+
+void jsonChildren::resize(json_index_t amount) {
+    JSON_ASSERT(array, JSON_TEXT("resizing an array that hasn't been created"));
+    array = json_realloc<JSONNode*>(array - HEADER_SLOTS, HEADER_SLOTS + amount) + HEADER_SLOTS;
+    head() -> capacity = amount;
+}
+
 //actually deletes everything within the vector, this is safe to do on an empty or even a null array
 void jsonChildren::deleteAll(void) {
     json_foreach((*this), runner) {
@@ -60,14 +67,140 @@ void jsonChildren::deleteAll(void) {
 void jsonChildren::doerase(JSONNode ** position, json_index_t number) {
     JSON_ASSERT(array, JSON_TEXT("erasing something from a null array 2"));
     JSON_ASSERT(position >= array, JSON_TEXT("position is beneath the start of the array 2"));
-    JSON_ASSERT(position + number <= array + mysize, JSON_TEXT("erasing out of bounds 2"));
-    if (position + number >= array + mysize) {
-        mysize = (json_index_t)(position - array);
+    JSON_ASSERT(position + number <= array + head() -> size, JSON_TEXT("erasing out of bounds 2"));
+    if (position + number >= array + head() -> size) {
+        head() -> size = (json_index_t)(position - array);
 #ifndef JSON_ISO_STRICT
         JSON_ASSERT((long long)position - (long long)array >= 0, JSON_TEXT("doing negative allocation"));
 #endif
     } else {
-        memmove(position, position + number, (mysize - (position - array) - number) * sizeof(JSONNode *));
-        mysize -= number;
+        memmove(position, position + number, (head() -> size - (position - array) - number) * sizeof(JSONNode *));
+        head() -> size -= number;
+    }
+}
+
+#ifdef JSON_INDEX_KEYS
+std::atomic<size_t> jsonChildren::renames(0);
+
+void jsonChildren::renamed(void) {
+    renames.fetch_add(1, std::memory_order_relaxed);
+}
+
+//FNV-1a, with A - Z folded down to a - z the same way that AreEqualNoCase does
+json_index_t jsonChildren::hashName(const json_char * name, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (const json_char * end = name + length; name != end; ++name) {
+        json_char ch = *name;
+        if ((ch > 64) && (ch < 91)) ch += 32;
+        hash = (hash ^ (unsigned int)ch) * 16777619u;
+    }
+    return (json_index_t)hash;
+}
+
+jsonChildren::keyIndex * jsonChildren::getIndex(void) {
+    if (size() < INDEX_MIN) return 0;
+    keyIndex * index = head() -> index;
+    if (!index) {
+        buildIndex();
+    } else if ((index -> generation != renames.load(std::memory_order_relaxed)) && (index -> generation != FROZEN)) {
+        revalidate();
+    }
+    return head() -> index;
+}
+
+//something has been renamed since the index was checked, but it's usually not one of these children, so the
+//index is only rebuilt if one of their names no longer hashes to what its slot says
+void jsonChildren::revalidate(void) {
+    keyIndex * index = head() -> index;
+    const size_t generation = renames.load(std::memory_order_relaxed);  //before looking, so a rename from now on is caught next time
+    for (json_index_t i = 0; i <= index -> mask; ++i) {
+        if (!index -> slots[i].position) continue;
+        internalJSONNode * child = array[index -> slots[i].position - 1] -> internal;
+        if (index -> slots[i].hash != hashName(child -> _name.data(), child -> _name.length())) {
+            buildIndex();
+            return;
+        }
+        child -> _indexed = true;  //may be a copy that has taken the old one's place
+    }
+    index -> generation = generation;
+}
+
+void jsonChildren::buildIndex(void) {
+    const json_index_t mysize = head() -> size;
+    json_index_t slots = INDEX_MIN * 2;
+    while (slots < mysize * 2) slots <<= 1;  //never more than half full, so the probes stay short
+    keyIndex * index = head() -> index;
+    if (index) {
+        libjson_free<keyIndex::slot>(index -> slots);
+    } else {
+        index = head() -> index = json_malloc<keyIndex>(1);
+    }
+    index -> slots = json_malloc<keyIndex::slot>(slots);
+    memset(index -> slots, 0, slots * sizeof(keyIndex::slot));
+    index -> mask = slots - 1;
+    index -> count = 0;
+    index -> generation = renames.load(std::memory_order_relaxed);
+    for (json_index_t i = 0; i < mysize; ++i) {
+        addToIndex(i);
+    }
+}
+
+//children are added in order, so the first of two with the same name is always found first
+void jsonChildren::addToIndex(json_index_t position) {
+    keyIndex * index = head() -> index;
+    if ((index -> count + 1) * 2 > index -> mask + 1) {
+        buildIndex();  //picks up the new one too
+        return;
     }
+    internalJSONNode * child = array[position] -> internal;
+    child -> _indexed = true;
+    const json_index_t hash = hashName(child -> _name.data(), child -> _name.length());
+    json_index_t i = hash & index -> mask;
+    while (index -> slots[i].position) i = (i + 1) & index -> mask;
+    index -> slots[i].hash = hash;
+    index -> slots[i].position = position + 1;
+    ++index -> count;
+}
+
+void jsonChildren::dropIndex(void) {
+    libjson_free<keyIndex::slot>(head() -> index -> slots);
+    libjson_free<keyIndex>(head() -> index);
+    head() -> index = 0;
 }
+
+JSONNode ** jsonChildren::find(const json_string & name_t) {
+    if (keyIndex * keys = getIndex()) {
+        const json_index_t hash = hashName(name_t.data(), name_t.length());
+        for (json_index_t i = hash & keys -> mask; keys -> slots[i].position; i = (i + 1) & keys -> mask) {
+            if (keys -> slots[i].hash != hash) continue;
+            JSONNode ** child = array + keys -> slots[i].position - 1;
+            if ((*child) -> internal -> _name == name_t) return child;
+        }
+        return 0;
+    }
+    json_foreach((*this), runner) {
+        JSON_ASSERT(*runner, JSON_TEXT("a null pointer within the children"));
+        if ((*runner) -> internal -> _name == name_t) return runner;
+    }
+    return 0;
+}
+
+#ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
+JSONNode ** jsonChildren::find_nocase(const json_string & name_t) {
+    if (keyIndex * keys = getIndex()) {
+        const json_index_t hash = hashName(name_t.data(), name_t.length());
+        for (json_index_t i = hash & keys -> mask; keys -> slots[i].position; i = (i + 1) & keys -> mask) {
+            if (keys -> slots[i].hash != hash) continue;
+            JSONNode ** child = array + keys -> slots[i].position - 1;
+            if (internalJSONNode::AreEqualNoCase((*child) -> internal -> _name.c_str(), name_t.c_str())) return child;
+        }
+        return 0;
+    }
+    json_foreach((*this), runner) {
+        JSON_ASSERT(*runner, JSON_TEXT("a null pointer within the children"));
+        if (internalJSONNode::AreEqualNoCase((*runner) -> internal -> _name.c_str(), name_t.c_str())) return runner;
+    }
+    return 0;
+}
+#endif
+#endif
@@ -3,6 +3,9 @@
 
 #include "JSONMemory.h"
 #include "JSONDebug.h"  //for JSON_ASSERT macro
+#ifdef JSON_INDEX_KEYS
+    #include <atomic>
+#endif
 
 #define json_foreach(children, iterator)\
     JSONNode ** iterator = children.begin();\
@@ -14,6 +17,11 @@
  expanding array.  On destruction, this container automatically destroys everything contained
  in it as well, so that you libJSON doesn't have to do that.
  
+ Every node has one of these, but most nodes are strings and numbers that never have children,
+ so the only thing kept in the object itself is the pointer to the array.  The size, capacity
+ and key index are kept in a header just in front of the array, and an empty one is a null
+ pointer that takes up nothing else.
+
  T is JSONNode*, I can't define it that way directly because JSONNode uses this container, and because
  the container deletes the children automatically, forward declaration can't be used
  */
@@ -23,13 +31,14 @@ class JSONNode;  //forward declaration
 class jsonChildren {
 public:
     //starts completely empty and the array is not allocated
-    jsonChildren(void) : array(0), mysize(0), mycapacity(0) { }
+    jsonChildren(void) : array(0) { }
     
     //deletes the array and everything that is contained within it (using delete)
     ~jsonChildren(void){
 	   if (array){  //the following function calls are safe, but take more time than a check here
+		  unindex();
 		  deleteAll();
-		  libjson_free<JSONNode*>(array);
+		  release();
 	   }
     }
     
@@ -40,47 +49,52 @@ public:
     //Adds something to the vector, doubling the array if necessary
     void push_back(JSONNode * item){
 	   inc();
-	   array[mysize++] = item;
+	   array[head() -> size++] = item;
+	   #ifdef JSON_INDEX_KEYS
+		  if (head() -> index) addToIndex(head() -> size - 1);
+	   #endif
     }
     
     //Adds something to the front of the vector, doubling the array if necessary
     void push_front(JSONNode * item){
+	   unindex();
 	   inc();
-	   memmove(array + 1, array, mysize++ * sizeof(JSONNode *));
+	   memmove(array + 1, array, head() -> size++ * sizeof(JSONNode *));
 	   array[0] = item;
     }
     
     //gets an item out of the vector by it's position
     inline JSONNode * operator[] (json_index_t position) const {
-	   JSON_ASSERT(position < mysize, JSON_TEXT("Using [] out of bounds"));
-	   JSON_ASSERT(position < mycapacity, JSON_TEXT("Using [] out of bounds"));
 	   JSON_ASSERT(array, JSON_TEXT("Array is null"));
+	   JSON_ASSERT(position < head() -> size, JSON_TEXT("Using [] out of bounds"));
+	   JSON_ASSERT(position < head() -> capacity, JSON_TEXT("Using [] out of bounds"));
 	   return array[position];
     }
     
     //returns the allocated capacity, but keep in mind that some might not be valid
     inline json_index_t capacity() const {
-	   return mycapacity;
+	   return array ? head() -> capacity : 0;
     }
     
     //returns the number of valid objects within the vector
     inline json_index_t size() const {
-	   return mysize;
+	   return array ? head() -> size : 0;
     }
     
     //tests whether or not the vector is empty
     inline bool empty() const {
-	   return mysize == 0;
+	   return size() == 0;
     }
     
     //clears (and deletes) everything from the vector and sets it's size to 0
     inline void clear(){
 	   if (array){  //don't bother clearing anything if there is nothing in it
-		  JSON_ASSERT(mycapacity != 0, JSON_TEXT("mycapacity is not zero, but array is null"));
+		  JSON_ASSERT(head() -> capacity != 0, JSON_TEXT("mycapacity is zero, but array is not null"));
+		  unindex();
 		  deleteAll();
-		  mysize = 0;
+		  head() -> size = 0;
 	   }
-	   JSON_ASSERT(mysize == 0, JSON_TEXT("mysize is not zero after clear"));
+	   JSON_ASSERT(size() == 0, JSON_TEXT("mysize is not zero after clear"));
     }
     
     //returns the beginning of the array
@@ -90,7 +104,7 @@ public:
     
     //returns the end of the array
     inline JSONNode ** end(void) const {
-	   return array + mysize;
+	   return array + size();
     }
     
     //makes sure that even after shirnking and expanding, the iterator is in same relative position
@@ -105,7 +119,7 @@ public:
 		  iteratorKeeper(jsonChildren * pthis, JSONNode ** & position, bool reverse = false) : 
              myChildren(pthis),
              myPos(position),
-             myRelativeOffset(reverse ? (json_index_t)(pthis -> array + (size_t)pthis -> mysize - position) : (json_index_t)(position - pthis -> array)),
+             myRelativeOffset(reverse ? (json_index_t)(pthis -> array + (size_t)pthis -> size() - position) : (json_index_t)(position - pthis -> array)),
              myReverse(reverse){}
 	   #endif
 
@@ -114,7 +128,7 @@ public:
 			 myPos = myChildren -> array + myRelativeOffset;
 		  #else
 			 if (myReverse){
-				myPos = myChildren -> array + myChildren -> mysize - myRelativeOffset;
+				myPos = myChildren -> array + myChildren -> size() - myRelativeOffset;
 			 } else {
 				myPos = myChildren -> array + myRelativeOffset;
 			 }
@@ -136,14 +150,16 @@ public:
     inline void erase(JSONNode ** & position){
 	   JSON_ASSERT(array, JSON_TEXT("erasing something from a null array 1"));
 	   JSON_ASSERT(position >= array, JSON_TEXT("position is beneath the start of the array 1"));
-	   JSON_ASSERT(position <= array + mysize, JSON_TEXT("erasing out of bounds 1"));
-	   memmove(position, position + 1, (mysize-- - (position - array) - 1) * sizeof(JSONNode *));
+	   JSON_ASSERT(position <= array + head() -> size, JSON_TEXT("erasing out of bounds 1"));
+	   unindex();
+	   memmove(position, position + 1, (head() -> size-- - (position - array) - 1) * sizeof(JSONNode *));
 	   iteratorKeeper ik(this, position);
 	   shrink();
     }
     
     //This function DOES NOT delete the item it points to
     inline void erase(JSONNode ** & position, json_index_t number){
+	   unindex();
 	   doerase(position, number);
 	   iteratorKeeper ik(this, position);
 	   shrink();
@@ -152,6 +168,7 @@ public:
     
     //This function DOES NOT delete the item it points to
     inline void erase(JSONNode ** position, json_index_t number, JSONNode ** & starter){
+	   unindex();
 	   doerase(position, number);
 	   iteratorKeeper ik(this, starter);
 	   shrink();
@@ -164,7 +181,8 @@ public:
     #endif
 	   //position isnt relative to array because of realloc
 	   JSON_ASSERT(position >= array, JSON_TEXT("position is beneath the start of the array insert 1"));
-	   JSON_ASSERT(position <= array + mysize, JSON_TEXT("position is above the end of the array insert 1"));
+	   JSON_ASSERT(position <= array + size(), JSON_TEXT("position is above the end of the array insert 1"));
+	   unindex();
 	   {
 		  #ifdef JSON_LIBRARY
 			 iteratorKeeper ik(this, position);
@@ -173,33 +191,32 @@ public:
 		  #endif
 		  inc();
 	   }
-	   memmove(position + 1, position, (mysize++ - (position - array)) * sizeof(JSONNode *));
+	   memmove(position + 1, position, (head() -> size++ - (position - array)) * sizeof(JSONNode *));
 	   *position = item;
     }
 
     void insert(JSONNode ** & position, JSONNode ** items, json_index_t num){
 	   JSON_ASSERT(position >= array, JSON_TEXT("position is beneath the start of the array insert 2"));
-	   JSON_ASSERT(position <= array + mysize, JSON_TEXT("position is above the end of the array insert 2"));
+	   JSON_ASSERT(position <= array + size(), JSON_TEXT("position is above the end of the array insert 2"));
+	   unindex();
 	   {
 		  iteratorKeeper ik(this, position);
 		  inc(num);
 	   }
-	   const size_t ptrs = ((JSONNode **)(array + mysize)) - position;
+	   const size_t ptrs = ((JSONNode **)(array + head() -> size)) - position;
 	   memmove(position + num, position, ptrs * sizeof(JSONNode *));
 	   memcpy(position, items, num * sizeof(JSONNode *));
-	   mysize += num;
+	   head() -> size += num;
     }
     
     inline void reserve(json_index_t amount){
 	   JSON_ASSERT(!array, JSON_TEXT("reserve is not meant to expand a preexisting array"));
-	   JSON_ASSERT(!mycapacity, JSON_TEXT("reservec is not meant to expand a preexisting array"));
-	   JSON_ASSERT(!mysize, JSON_TEXT("reserves is not meant to expand a preexisting array"));
-	   array = json_malloc<JSONNode*>(mycapacity = amount);
+	   if (amount) allocate(amount);  //an array is never allocated empty, inc() relies on that
     }
 
     inline void reserve2(json_index_t amount){
 	   if (array){
-		  if (mycapacity < amount) inc(amount - mycapacity);
+		  if (head() -> capacity < amount) inc(amount - head() -> capacity);
 	   } else {
 		  reserve(amount);
 	   }
@@ -207,17 +224,39 @@ public:
 		  
     //shrinks the array to only as large as it needs to be to hold everything within it
     inline void shrink(){
-	   if (mysize == 0){  //size is zero, we should completely free the array
-		  libjson_free<JSONNode*>(array);  //free does checks for a null pointer, so don't bother checking
-		  array = 0;
-		  #ifdef JSON_LESS_MEMORY
-			 } else {  //need to shrink it, using realloc
-				JSON_ASSERT(array, JSON_TEXT("shrinking a null array that is not size 0"));
-				array = json_realloc<JSONNode*>(array, mysize);
-		  #endif  
+	   if (!array) return;
+	   if (head() -> size == 0){  //size is zero, we should completely free the array
+		  release();
+	   #ifdef JSON_LESS_MEMORY
+		  } else {  //need to shrink it, using realloc
+			 resize(head() -> size);
+	   #endif
 	   }
-	   mycapacity = mysize;
     }
+
+    #ifdef JSON_INDEX_KEYS
+	   //the first child with this name, or 0 if there isn't one
+	   JSONNode ** find(const json_string & name_t);
+	   #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
+		  JSONNode ** find_nocase(const json_string & name_t);
+	   #endif
+	   static void renamed(void);  //a child that might be in an index has had its name changed
+    #endif
+    #ifdef JSON_ATOMIC_REF_COUNT
+	   #ifdef JSON_INDEX_KEYS
+		  //builds the index if it's big enough to have one, and keeps it even when something is renamed
+		  inline void freeze(void){
+			 if (keyIndex * keys = getIndex()) keys -> generation = FROZEN;
+		  }
+		  //lets it go out of date again, because this one is about to be changed
+		  inline void thaw(void){
+			 if (array && head() -> index && (head() -> index -> generation == FROZEN)) head() -> index -> generation = renames.load(std::memory_order_relaxed);
+		  }
+	   #else
+		  inline void freeze(void){}
+		  inline void thaw(void){}
+	   #endif
+    #endif
 JSON_PRIVATE
     //to make sure it's not copyable
     jsonChildren(const jsonChildren &);
@@ -226,10 +265,72 @@ JSON_PRIVATE
     void deleteAll(void);  //implemented in JSONNode.cpp
     void doerase(JSONNode ** position, json_index_t number);
     
-    JSONNode ** array;  //the expandable array
+    #ifdef JSON_INDEX_KEYS
+	   struct keyIndex;
+    #endif
+
+    //what's kept in front of the array
+    struct header {
+	   json_index_t size;	     //the number of valid items
+	   json_index_t capacity;   //the number of possible items
+	   #ifdef JSON_INDEX_KEYS
+		  keyIndex * index;
+	   #endif
+    };
+    //how many of the array's slots the header takes up
+    enum { HEADER_SLOTS = (sizeof(header) + sizeof(JSONNode *) - 1) / sizeof(JSONNode *) };
+
+    inline header * head(void) const {
+	   return (header *)(array - HEADER_SLOTS);
+    }
+    void allocate(json_index_t amount);  //for an array that hasn't been created yet
+    void resize(json_index_t amount);    //for one that has
+    inline void release(void){
+	   JSONNode ** block = array - HEADER_SLOTS;
+	   libjson_free<JSONNode*>(block);
+	   array = 0;
+    }
+
+    JSONNode ** array;  //the expandable array, with its header just before it
 
-    json_index_t mysize;	     //the number of valid items
-    json_index_t mycapacity;   //the number of possible items
+    #ifdef JSON_INDEX_KEYS
+	   /*
+		  Objects with only a few children are searched in order, but once there
+		  are at least INDEX_MIN of them, the first search builds an open addressed
+		  table from the hash of each name to its position.  Names are hashed without
+		  case so that find_nocase can use the same table.  Anything that moves
+		  children around throws the table away and the next search builds a new one.
+		  Renaming a child that is in a table only bumps renames, as a child doesn't
+		  know its parent, so the next search in each table checks that its names
+		  still hash the same and only rebuilds it if one doesn't.
+	   */
+	   struct keyIndex {
+		  struct slot {
+			 json_index_t hash;
+			 json_index_t position;  //one past the child's position, 0 for an empty slot
+		  };
+		  size_t generation;  //the value of renames when it was built or last checked
+		  json_index_t mask;  //the number of slots minus one
+		  json_index_t count;
+		  slot * slots;
+	   };
+	   enum { INDEX_MIN = 8 };
+	   static const size_t FROZEN = (size_t)-1;  //the generation of an index that freeze has made permanent
+
+	   inline void unindex(void){
+		  if (array && head() -> index) dropIndex();
+	   }
+	   keyIndex * getIndex(void);
+	   void buildIndex(void);
+	   void revalidate(void);
+	   void addToIndex(json_index_t position);
+	   void dropIndex(void);
+	   static json_index_t hashName(const json_char * name, size_t length);
+
+	   static std::atomic<size_t> renames;
+    #else
+	   inline void unindex(void){}
+    #endif
 };
 
 
@@ -20,6 +20,10 @@
     #include <string>
 #endif
 
+#if defined(JSON_ATOMIC_REF_COUNT) && !defined(JSON_REF_COUNT)
+    #error JSON_ATOMIC_REF_COUNT also requires JSON_REF_COUNT
+#endif
+
 #ifdef JSON_UNICODE
     #ifdef JSON_ISO_STRICT
 	   #error, You can not use unicode under ISO Strict C++
@@ -52,6 +56,12 @@
     typedef double json_number;
 #endif
 
+#ifdef JSON_ISO_STRICT
+    typedef long json_int_t;  //long long isn't standard C++
+#else
+    typedef long long json_int_t;
+#endif
+
 #if defined JSON_DEBUG || defined JSON_SAFE
     #ifdef JSON_LIBRARY
 	   typedef void (*json_error_callback_t)(const json_char *);
@@ -66,6 +76,10 @@
     typedef unsigned int json_index_t;
 #endif
 
+#ifndef JSON_MAX_DEPTH
+    #define JSON_MAX_DEPTH 512
+#endif
+
 typedef void (*json_mutex_callback_t)(void *);
 typedef void (*json_free_t)(void *);
 #ifndef JSON_LIBRARY
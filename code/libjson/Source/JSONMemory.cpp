@@ -21,12 +21,29 @@ void auto_expand_node::purge(void) {
 #endif
 
 #ifdef JSON_MEMORY_CALLBACKS
+#include <mutex>
+#ifdef _WIN32
+    #include <malloc.h>  //for _aligned_malloc
+#endif
 
 json_malloc_t mymalloc = 0;
 json_realloc_t myrealloc = 0;
 json_free_t myfree = 0;
 
-void * JSONMemory::json_malloc(size_t siz) {
+/*
+    Everything that an arena hands out is preceded by one of these.  Heap memory has nothing
+    extra in front of it, it's told apart by looking its address up in the block map below
+*/
+struct AllocationHeader {
+    JSONArena * arena;
+    size_t size;
+};
+
+static inline AllocationHeader * HeaderOf(void * ptr) {
+    return ((AllocationHeader *)ptr) - 1;
+}
+
+static void * HeapMalloc(size_t siz) {
     if (mymalloc) {
 #ifdef JSON_DEBUG  //in debug mode, see if the malloc was successful
         void * result = mymalloc(siz);
@@ -45,7 +62,7 @@ void * JSONMemory::json_malloc(size_t siz) {
 #endif
 }
 
-void * JSONMemory::json_realloc(void * ptr, size_t siz) {
+static void * HeapRealloc(void * ptr, size_t siz) {
     if (myrealloc) {
 #ifdef JSON_DEBUG  //in debug mode, see if the malloc was successful
         void * result = myrealloc(ptr, siz);
@@ -64,7 +81,7 @@ void * JSONMemory::json_realloc(void * ptr, size_t siz) {
 #endif
 }
 
-void JSONMemory::json_free(void * ptr) {
+static void HeapFree(void * ptr) {
     if (myfree) {
         myfree(ptr);
     } else {
@@ -72,10 +89,265 @@ void JSONMemory::json_free(void * ptr) {
     }
 }
 
+static thread_local JSONArena * currentarena = 0;
+
+void * JSONMemory::json_malloc(size_t siz) {
+    if (currentarena) return currentarena -> allocate(siz);
+    return HeapMalloc(siz);
+}
+
+void * JSONMemory::json_realloc(void * ptr, size_t siz) {
+    if (!ptr) return json_malloc(siz);
+    JSONArena::Block * block = JSONArena::blockOf(ptr);
+    if (!block) return HeapRealloc(ptr, siz);
+    AllocationHeader * header = HeaderOf(ptr);
+    if ((header -> arena == currentarena) && currentarena -> grow(ptr, siz)) return ptr;
+    //it has to move, into the current arena if there is one, otherwise onto the heap
+    void * result = json_malloc(siz);
+    if (!result) return 0;
+    memcpy(result, ptr, (header -> size < siz) ? header -> size : siz);
+    JSONArena::release(block, header -> arena);
+    return result;
+}
+
+void JSONMemory::json_free(void * ptr) {
+    if (!ptr) return;
+    if (JSONArena::Block * block = JSONArena::blockOf(ptr)) {
+        JSONArena::release(block, HeaderOf(ptr) -> arena);
+    } else {
+        HeapFree(ptr);
+    }
+}
+
 void JSONMemory::registerMemoryCallbacks(json_malloc_t mal, json_realloc_t real, json_free_t fre) {
     mymalloc = mal;
     myrealloc = real;
     myfree = fre;
 }
 
+static std::mutex idlelock;
+static JSONArena * idlearenas = 0;  //emptied arenas waiting for a scope, linked through nextidle
+static size_t idlecount = 0;
+static std::atomic<size_t> blockcount(0);
+
+/*
+    One bit for each block sized piece of the address space, set while an arena block is there.
+    The bits are kept in leaves that are made when they are first needed and then never freed,
+    so looking a pointer up takes no lock.  A bit is set before anything in its block is handed
+    out and cleared only once everything in it has been freed, so a pointer that is being freed
+    always finds the right answer
+*/
+static const unsigned int leafbits = 20;  //blocks covered by each leaf
+static const unsigned int rootbits = 12;  //leaves, enough for 48 bit addresses with 64k blocks
+static std::atomic<std::atomic<unsigned char> *> blockmap[1 << rootbits];
+static std::mutex blockmaplock;
+
+static inline size_t RoundUp(size_t siz) {
+    return (siz + 15) & ~(size_t)15;
+}
+
+JSONArena::JSONArena(void) : blocks(0), top(0), limit(0), last(0), used(0), live(0), nextidle(0) {}
+
+JSONArena::~JSONArena(void) {
+    while (blocks) {
+        Block * next = blocks -> next;
+        deleteBlock(blocks);
+        blocks = next;
+    }
+}
+
+//sets or clears the bit for a block, returns false if the block is somewhere the map doesn't cover
+bool JSONArena::mark(Block * block, bool inuse) {
+    const unsigned long long index = (unsigned long long)(size_t)block >> blockbits;
+    if ((index >> leafbits) >= (1ULL << rootbits)) return false;
+    std::atomic<std::atomic<unsigned char> *> & root = blockmap[index >> leafbits];
+    std::atomic<unsigned char> * leaf = root.load(std::memory_order_acquire);
+    if (!leaf) {
+        std::lock_guard<std::mutex> lock(blockmaplock);
+        leaf = root.load(std::memory_order_relaxed);
+        if (!leaf) {
+            leaf = new std::atomic<unsigned char>[(1 << leafbits) / 8]();
+            root.store(leaf, std::memory_order_release);
+        }
+    }
+    const size_t bit = (size_t)(index & ((1 << leafbits) - 1));
+    if (inuse) {
+        leaf[bit / 8].fetch_or((unsigned char)(1 << (bit % 8)));
+    } else {
+        leaf[bit / 8].fetch_and((unsigned char)~(1 << (bit % 8)));
+    }
+    return true;
+}
+
+//the arena block that ptr is in, or 0 if it came from the heap
+JSONArena::Block * JSONArena::blockOf(const void * ptr) {
+    const unsigned long long index = (unsigned long long)(size_t)ptr >> blockbits;
+    if ((index >> leafbits) >= (1ULL << rootbits)) return 0;
+    const std::atomic<unsigned char> * leaf = blockmap[index >> leafbits].load(std::memory_order_acquire);
+    if (!leaf) return 0;
+    const size_t bit = (size_t)(index & ((1 << leafbits) - 1));
+    if (!(leaf[bit / 8].load(std::memory_order_acquire) & (1 << (bit % 8)))) return 0;
+    return (Block *)((size_t)ptr & ~(blocksize - 1));
+}
+
+//blocks are aligned to their size so that blockOf can find them, and come straight from the system rather than the callbacks
+JSONArena::Block * JSONArena::newBlock(void) {
+    void * memory;
+#ifdef _WIN32
+    memory = _aligned_malloc(blocksize, blocksize);
+#else
+    if (posix_memalign(&memory, blocksize, blocksize)) memory = 0;
+#endif
+    JSON_ASSERT(memory, JSON_TEXT("out of memory"));
+    if (!memory) return 0;
+    Block * block = new(memory) Block;
+    block -> next = 0;
+    block -> live = 1;
+    if (!mark(block, true)) {
+        deleteBlock(block);
+        return 0;
+    }
+    ++blockcount;
+    return block;
+}
+
+void JSONArena::deleteBlock(Block * block) {
+    if (mark(block, false)) --blockcount;
+    block -> ~Block();
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+//anything too big for a block, or that finds no room for one, goes to the heap as though there were no scope
+void * JSONArena::allocate(size_t siz) {
+    const size_t total = RoundUp(sizeof(AllocationHeader) + (siz ? siz : 1));  //never ends on the edge of the block, where blockOf would miss it
+    if (total > blocksize - RoundUp(sizeof(Block))) return HeapMalloc(siz);
+    if ((size_t)(limit - top) < total) {
+        Block * block = newBlock();
+        if (!block) return HeapMalloc(siz);
+        block -> next = blocks;
+        blocks = block;
+        top = (char *)block + RoundUp(sizeof(Block));
+        limit = (char *)block + blocksize;
+    }
+    AllocationHeader * header = (AllocationHeader *)(last = top);
+    header -> arena = this;
+    header -> size = siz;
+    top += total;
+    used += total;
+    ++blocks -> live;
+    ++live;
+    return header + 1;
+}
+
+//resizes ptr where it is if nothing has been allocated after it and there is room
+bool JSONArena::grow(void * ptr, size_t siz) {
+    if ((char *)HeaderOf(ptr) != last) return false;
+    char * newtop = last + RoundUp(sizeof(AllocationHeader) + (siz ? siz : 1));
+    if (newtop > limit) return false;
+    used -= top - last;
+    top = newtop;
+    used += top - last;
+    HeaderOf(ptr) -> size = siz;
+    return true;
+}
+
+//an allocation from block has been freed
+void JSONArena::release(Block * block, JSONArena * arena) {
+    if (!--block -> live) deleteBlock(block);
+    arena -> release();
+}
+
+//once nothing is using the arena, it's either kept for the next scope or deleted
+void JSONArena::release(void) {
+    if (--live) return;
+    {
+        std::lock_guard<std::mutex> lock(idlelock);
+        if (idlecount < maxidle) {
+            nextidle = idlearenas;
+            idlearenas = this;
+            ++idlecount;
+            return;
+        }
+    }
+    delete this;
+}
+
+/*
+    The scope using the arena has ended.  Usually everything allocated in it has already gone,
+    and the arena is emptied for the next scope.  If something has outlived the scope, the arena
+    lets go of its blocks instead, so that each one is freed as soon as its own allocations are,
+    rather than one leftover node holding on to every block until it goes
+*/
+void JSONArena::close(void) {
+    if (live == 1) {
+        empty();
+    } else {
+        Block * block = blocks;
+        blocks = 0;
+        top = limit = last = 0;
+        used = 0;
+        while (block) {
+            Block * next = block -> next;
+            if (!--block -> live) deleteBlock(block);
+            block = next;
+        }
+    }
+    release();
+}
+
+//frees every block but one, so that a huge message doesn't keep its memory forever
+void JSONArena::empty(void) {
+    Block * keep = blocks;
+    if (keep) {
+        blocks = keep -> next;
+        while (blocks) {
+            Block * next = blocks -> next;
+            deleteBlock(blocks);
+            blocks = next;
+        }
+        keep -> next = 0;
+    }
+    blocks = keep;
+    top = keep ? (char *)keep + RoundUp(sizeof(Block)) : 0;
+    limit = keep ? (char *)keep + blocksize : 0;
+    last = 0;
+    used = 0;
+}
+
+size_t JSONArena::idle(void) {
+    std::lock_guard<std::mutex> lock(idlelock);
+    return idlecount;
+}
+
+size_t JSONArena::held(void) {
+    return blockcount * blocksize;
+}
+
+JSONArena::Scope::Scope(void) : arena(0), previous(currentarena) {
+    {
+        std::lock_guard<std::mutex> lock(idlelock);
+        if (idlearenas) {
+            arena = idlearenas;
+            idlearenas = arena -> nextidle;
+            --idlecount;
+        }
+    }
+    if (!arena) arena = new JSONArena();
+    arena -> live = 1;
+    currentarena = arena;
+}
+
+JSONArena::Scope::~Scope(void) {
+    currentarena = previous;
+    arena -> close();
+}
+
+size_t JSONArena::Scope::used(void) const {
+    return arena -> used;
+}
+
 #endif
@@ -13,6 +13,8 @@
 #endif
 
 #ifdef JSON_MEMORY_CALLBACKS
+    #include <atomic>
+
     class JSONMemory {
     public:
 	   static void * json_malloc(size_t siz);
@@ -21,6 +23,74 @@
 	   static void registerMemoryCallbacks(json_malloc_t mal, json_realloc_t real, json_free_t fre);
     };
 
+    /*
+	   A bump allocator for nodes that are built and thrown away together, such as the
+	   tree for one message.  While a JSONArena::Scope is alive, the nodes, internals and
+	   child arrays that libjson allocates on that thread are carved out of one arena
+	   rather than each going to malloc, and freeing them costs nothing.  Once the scope
+	   has ended and the last of them is gone, the whole arena is emptied at once and kept
+	   for the next scope to use.
+
+	   The nodes may outlive the scope and may be freed on any thread.  If any do, the
+	   arena gives up its blocks and each block is freed as soon as what is left in it
+	   is, so a node that is kept only keeps the block it is in.  Strings are not
+	   affected, json_string still uses its own allocator.
+
+	   Arena blocks are aligned to their size and recorded in a map of the address space,
+	   which is how a pointer being freed is known to be from one.  Memory from the heap
+	   has nothing added to it.
+    */
+    class JSONArena {
+    public:
+	   class Scope {
+	   public:
+		  Scope(void);
+		  ~Scope(void);
+		  size_t used(void) const;  //bytes that have been taken from the arena so far
+	   private:
+		  JSONArena * arena;
+		  JSONArena * previous;  //so that scopes can nest
+		  Scope(const Scope &);
+		  Scope & operator = (const Scope &);
+	   };
+
+	   static size_t idle(void);  //how many emptied arenas are waiting to be reused
+	   static size_t held(void);  //bytes of blocks that arenas have between them, in use or not
+    JSON_PRIVATE
+	   friend class JSONMemory;
+	   struct Block {
+		  Block * next;
+		  std::atomic<size_t> live;  //allocations in the block that haven't been freed, plus one while it belongs to an arena
+	   };
+
+	   JSONArena(void);
+	   ~JSONArena(void);
+	   void * allocate(size_t siz);
+	   bool grow(void * ptr, size_t siz);
+	   void release(void);
+	   void close(void);
+	   void empty(void);
+	   static void release(Block * block, JSONArena * arena);
+	   static Block * newBlock(void);
+	   static void deleteBlock(Block * block);
+	   static bool mark(Block * block, bool inuse);
+	   static Block * blockOf(const void * ptr);
+
+	   static const size_t blockbits = 16;
+	   static const size_t blocksize = (size_t)1 << blockbits;
+	   static const size_t maxidle = 8;
+
+	   Block * blocks;  //newest first, the one being allocated from is at the front.  None once the scope has ended
+	   char * top;  //where the next allocation goes
+	   char * limit;  //the end of the front block
+	   char * last;  //the most recent allocation, which can grow in place
+	   size_t used;
+	   std::atomic<size_t> live;  //allocations that haven't been freed, plus one while a scope is using it
+	   JSONArena * nextidle;
+	   JSONArena(const JSONArena &);
+	   JSONArena & operator = (const JSONArena &);
+    };
+
     template <typename T> static inline T * json_malloc(size_t count){
 	   return (T *)JSONMemory::json_malloc(sizeof(T) * count);
     }
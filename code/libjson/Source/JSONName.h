@@ -0,0 +1,117 @@
+#ifndef JSONNAME_H
+#define JSONNAME_H
+
+#include "JSONMemory.h"
+#include "JSONDebug.h"  //for JSON_ASSERT macro
+#include <cstring>
+
+/*
+    This holds the name of a node.  Most nodes are in arrays and don't have a
+    name at all, and most of the rest have short keys like "identity", so names
+    that fit are kept inside the object itself, and only longer ones get an
+    allocation.  It takes up half as much room as a json_string.
+
+    The last character is the tag: for a name held inside, it's how many more
+    characters could still fit, so a name that fills it is ended by that being
+    0.  For a longer name it's LONG, and the start of the object is the pointer
+    and length.  Either way, data() is always null terminated.
+*/
+class jsonName {
+public:
+    jsonName(void){ setShort(0, 0); }
+    jsonName(const json_string & value){ set(value.data(), value.length()); }
+    jsonName(const jsonName & orig){ set(orig.data(), orig.length()); }
+    ~jsonName(void){ release(); }
+
+    inline jsonName & operator = (const jsonName & orig){
+	   if (this != &orig) assign(orig.data(), orig.length());
+	   return *this;
+    }
+    inline jsonName & operator = (const json_string & value){
+	   assign(value.data(), value.length());
+	   return *this;
+    }
+
+    inline const json_char * data(void) const {
+	   return isLong() ? heap.ptr : chars;
+    }
+    inline const json_char * c_str(void) const {
+	   return data();
+    }
+    inline size_t length(void) const {
+	   return isLong() ? heap.length : (size_t)(INSIDE - chars[INSIDE]);
+    }
+    inline bool empty(void) const {
+	   return length() == 0;
+    }
+    //how many characters it can hold without allocating again
+    inline size_t capacity(void) const {
+	   return isLong() ? heap.length : (size_t)INSIDE;
+    }
+    inline json_string str(void) const {
+	   return json_string(data(), length());
+    }
+
+    inline bool operator == (const json_string & other) const {
+	   return (length() == other.length()) && (memcmp(data(), other.data(), length() * sizeof(json_char)) == 0);
+    }
+    inline bool operator != (const json_string & other) const {
+	   return !(*this == other);
+    }
+    inline bool operator == (const jsonName & other) const {
+	   return (length() == other.length()) && (memcmp(data(), other.data(), length() * sizeof(json_char)) == 0);
+    }
+    inline bool operator != (const jsonName & other) const {
+	   return !(*this == other);
+    }
+JSON_PRIVATE
+    enum { SIZE = 16 / sizeof(json_char) };  //the whole thing, in characters
+    enum { INSIDE = SIZE - 1 };  //the most that can be kept inside, the last one is the tag
+    enum { LONG = (json_char)-1 };
+
+    inline bool isLong(void) const {
+	   return chars[INSIDE] == (json_char)LONG;
+    }
+    inline void setShort(const json_char * value, size_t length){
+	   JSON_ASSERT(length <= INSIDE, JSON_TEXT("short name is too long"));
+	   if (length) memcpy(chars, value, length * sizeof(json_char));
+	   chars[length] = JSON_TEXT('\0');
+	   chars[INSIDE] = (json_char)(INSIDE - length);
+    }
+    inline void set(const json_char * value, size_t length){
+	   if (length <= INSIDE){
+		  setShort(value, length);
+		  return;
+	   }
+	   heap.ptr = json_malloc<json_char>(length + 1);
+	   memcpy(heap.ptr, value, length * sizeof(json_char));
+	   heap.ptr[length] = JSON_TEXT('\0');
+	   heap.length = (unsigned int)length;
+	   chars[INSIDE] = (json_char)LONG;
+    }
+    inline void assign(const json_char * value, size_t length){
+	   //a long name that is replaced by one no longer than it keeps its allocation
+	   if (isLong() && (length > INSIDE) && (length <= heap.length)){
+		  memmove(heap.ptr, value, length * sizeof(json_char));
+		  heap.ptr[length] = JSON_TEXT('\0');
+		  heap.length = (unsigned int)length;
+		  return;
+	   }
+	   release();
+	   set(value, length);
+    }
+    inline void release(void){
+	   if (isLong()) libjson_free<json_char>(heap.ptr);
+    }
+
+    struct longName {
+	   json_char * ptr;
+	   unsigned int length;  //ends before the tag for both char and wchar_t
+    };
+    union {
+	   json_char chars[SIZE];
+	   longName heap;
+    };
+};
+
+#endif
@@ -1,10 +1,16 @@
 #include "JSONNode.h"
 
 #ifdef JSON_UNIT_TEST
-int allocCount = 0;
-int deallocCount = 0;
-int internalAllocCount = 0;
-int internalDeallocCount = 0;
+#ifdef JSON_ATOMIC_REF_COUNT
+    #include <atomic>
+    typedef std::atomic<int> json_alloc_count_t;  //nodes can be copied and freed on other threads
+#else
+    typedef int json_alloc_count_t;
+#endif
+json_alloc_count_t allocCount(0);
+json_alloc_count_t deallocCount(0);
+json_alloc_count_t internalAllocCount(0);
+json_alloc_count_t internalDeallocCount(0);
 int JSONNode::getNodeAllocationCount(void) {
     return allocCount;
 }
@@ -164,6 +170,9 @@ JSONNode JSONNode::duplicate(void) const {
     mycopy.makeUniqueInternal();
 #endif
     JSON_ASSERT(internal != mycopy.internal, JSON_TEXT("makeUniqueInternal failed"));
+    #ifdef JSON_INDEX_KEYS
+	   mycopy.internal -> _indexed = false;  //it isn't in this one's parent
+    #endif
     return mycopy;
 }
 
@@ -242,6 +251,38 @@ const JSONNode & JSONNode::at_nocase(const json_string & name_t) const {
 }
 #endif
 
+JSONNode * JSONNode::try_at(const json_string & name_t) {
+    JSON_CHECK_INTERNAL();
+    if (type() != JSON_NODE) return 0;
+    makeUniqueInternal();
+    JSONNode ** res = internal -> at(name_t);
+    return res ? *res : 0;
+}
+
+const JSONNode * JSONNode::try_at(const json_string & name_t) const {
+    JSON_CHECK_INTERNAL();
+    if (type() != JSON_NODE) return 0;
+    JSONNode ** res = internal -> at(name_t);
+    return res ? *res : 0;
+}
+
+#ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
+JSONNode * JSONNode::try_at_nocase(const json_string & name_t) {
+    JSON_CHECK_INTERNAL();
+    if (type() != JSON_NODE) return 0;
+    makeUniqueInternal();
+    JSONNode ** res = internal -> at_nocase(name_t);
+    return res ? *res : 0;
+}
+
+const JSONNode * JSONNode::try_at_nocase(const json_string & name_t) const {
+    JSON_CHECK_INTERNAL();
+    if (type() != JSON_NODE) return 0;
+    JSONNode ** res = internal -> at_nocase(name_t);
+    return res ? *res : 0;
+}
+#endif
+
 #ifndef JSON_LIBRARY
 struct auto_delete {
 public:
@@ -113,6 +113,9 @@ public:
     #ifndef JSON_PREPARSE
 	   void preparse(void);
     #endif
+    #ifdef JSON_ATOMIC_REF_COUNT
+	   void freeze(void);  //finishes parsing and indexing everything, so that the tree can be read from other threads
+    #endif
     #ifdef JSON_VALIDATE
 	   #ifndef JSON_SAFE
 		  #error JSON_VALIDATE also requires JSON_SAFE
@@ -120,8 +123,8 @@ public:
 	   bool validate(void);
     #endif
     
-    json_string as_string(void) const;
-    long as_int(void) const;
+    const json_string & as_string(void) const;  //only valid for as long as the node is, and isn't changed
+    json_int_t as_int(void) const;
     json_number as_float(void) const;
     bool as_bool(void) const;
     JSONNode as_node(void) const;
@@ -146,6 +149,14 @@ public:
     JSONNode & operator[](const json_string & name_t);
     const JSONNode & operator[](const json_string & name_t) const;
 
+    //like at, but null instead of throwing when there's no such child, for fields that can be left out
+    JSONNode * try_at(const json_string & name_t);
+    const JSONNode * try_at(const json_string & name_t) const;
+    #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
+	   JSONNode * try_at_nocase(const json_string & name_t);
+	   const JSONNode * try_at_nocase(const json_string & name_t) const;
+    #endif
+
     #ifdef JSON_LIBRARY
 	   void push_back(JSONNode * node);
     #else
@@ -443,9 +454,6 @@ JSON_PRIVATE
     static JSONNode * newJSONNode(const JSONNode & orig     JSON_MUTEX_COPY_DECL2);
     static JSONNode * newJSONNode(internalJSONNode * internal_t);
     //used by JSONWorker
-    JSONNode(const json_string & unparsed) : internal(internalJSONNode::newInternal(unparsed)){ //root, specialized because it can only be array or node
-	   incAllocCount();
-    }
     JSONNode(internalJSONNode * internal_t) : internal(internal_t){ //do not increment anything, this is only used in one case and it's already taken care of 
 	   incAllocCount();
     }
@@ -475,6 +483,7 @@ JSON_PRIVATE
     mutable internalJSONNode * internal;
     friend class JSONWorker;
     friend class internalJSONNode;
+    friend class jsonChildren;  //looks at the names of children directly for its key index
 };
 
 
@@ -556,12 +565,12 @@ inline void JSONNode::set_name(const json_string & newname){
     }
 #endif
 
-inline json_string JSONNode::as_string(void) const {
+inline const json_string & JSONNode::as_string(void) const {
     JSON_CHECK_INTERNAL();
     return internal -> as_string();
 }
 
-inline long JSONNode::as_int(void) const {
+inline json_int_t JSONNode::as_int(void) const {
     JSON_CHECK_INTERNAL();
     return internal -> as_int();
 }
@@ -620,6 +629,9 @@ inline JSONNode & JSONNode::operator = (const JSONNode & orig){
     #ifdef JSON_REF_COUNT
 	   if (internal == orig.internal) return *this;  //don't want it accidentally deleting itself
     #endif
+    #ifdef JSON_INDEX_KEYS
+	   if (internal -> _indexed) jsonChildren::renamed();  //the new one probably has a different name
+    #endif
     decRef();  //dereference my current one
     internal = orig.internal -> incRef();  //increase reference of original
     return *this;
@@ -703,6 +715,9 @@ inline void JSONNode::nullify(void){
 
 inline void JSONNode::swap(JSONNode & other){
     JSON_CHECK_INTERNAL();
+    #ifdef JSON_INDEX_KEYS
+	   if (internal -> _indexed || other.internal -> _indexed) jsonChildren::renamed();
+    #endif
     internalJSONNode * temp = other.internal;
     other.internal = internal;
     internal = temp;
@@ -712,8 +727,7 @@ inline void JSONNode::swap(JSONNode & other){
 inline void JSONNode::decRef(void){ //decrements internal's counter, deletes it if needed
     JSON_CHECK_INTERNAL();
     #ifdef JSON_REF_COUNT
-	   internal -> decRef();
-	   if (internal -> hasNoReferences()){
+	   if (internal -> decRef()){
 		  internalJSONNode::deleteInternal(internal);
 	   }
     #else
@@ -724,7 +738,13 @@ inline void JSONNode::decRef(void){ //decrements internal's counter, deletes it
 #ifdef JSON_REF_COUNT
     inline void JSONNode::makeUniqueInternal(){ //makes internal it's own
 	   JSON_CHECK_INTERNAL();
-	   internal = internal -> makeUnique();  //might return itself or a new one that's exactly the same
+	   #ifdef JSON_INDEX_KEYS
+		  const bool indexed = internal -> _indexed;  //a copy takes the old one's place in its parent's index
+		  internal = internal -> makeUnique();  //might return itself or a new one that's exactly the same
+		  internal -> _indexed = indexed;
+	   #else
+		  internal = internal -> makeUnique();  //might return itself or a new one that's exactly the same
+	   #endif
     }
 #endif
 
@@ -838,6 +858,13 @@ inline void JSONNode::decRef(void){ //decrements internal's counter, deletes it
     }
 #endif
 
+#ifdef JSON_ATOMIC_REF_COUNT
+    inline void JSONNode::freeze(void){
+	   JSON_CHECK_INTERNAL();
+	   internal -> freeze();
+    }
+#endif
+
 #ifdef JSON_VALIDATE
     inline bool JSONNode::validate(void){
 	   JSON_CHECK_INTERNAL();
@@ -139,8 +139,10 @@ void internalJSONNode::_set_mutex(void * mutex, bool unset){
 			 ++it -> second;
 		  }
 	   #endif
-	   json_foreach(Children, myrunner){
-		  (*myrunner) -> set_mutex(mutex);
+	   if (isContainer()) {
+		  json_foreach(Children, myrunner){
+			 (*myrunner) -> set_mutex(mutex);
+		  }
 	   }
     }
 }
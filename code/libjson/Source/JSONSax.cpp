@@ -0,0 +1,184 @@
+#include "JSONSax.h"
+#include "JSONWorker.h"
+#include "JSONScan.h"
+#include <stdexcept>
+
+#define SAX_FAIL(msg)\
+    {\
+	   JSON_FAIL(msg);\
+	   throw std::invalid_argument(EMPTY_STRING2);\
+    }
+
+//hands an event to the handler, and stops if it asks to
+#define SAX_CALL(call)\
+    if (!(handler.call)) return false
+
+//reads the quoted string at p, leaving p past the closing quote
+#define SAX_STRING(callback)\
+    {\
+	   bool escaped = false;\
+	   const json_char * start = ++p;\
+	   p = JSONWorker::FindEndOfString(p, end, escaped);\
+	   ++p;\
+	   if (escaped){\
+		  Unescape(start, p - 1, scratch);\
+		  SAX_CALL(callback(scratch.data(), scratch.length()));\
+	   } else {\
+		  SAX_CALL(callback(start, p - 1 - start));\
+	   }\
+    }
+
+//the same unescaping that FixString does, for [p, end)
+void JSONSax::Unescape(const json_char * p, const json_char * end, json_string & res) {
+    res.clear();
+    res.reserve(end - p);
+    while (p != end) {
+        const json_char * backslash = JSONScan::FindBackslash(p, end);
+        res.append(p, backslash - p);
+        if ((p = backslash) == end) break;
+        ++p;
+        size_t digits = 0;  //how many characters SpecialChar is going to read past this one
+        switch (*p) {
+        case JSON_TEXT('u'):
+            digits = 4;
+            break;
+        case JSON_TEXT('x'):
+        case JSON_TEXT('0'):
+        case JSON_TEXT('1'):
+        case JSON_TEXT('2'):
+        case JSON_TEXT('3'):
+        case JSON_TEXT('4'):
+        case JSON_TEXT('5'):
+        case JSON_TEXT('6'):
+        case JSON_TEXT('7'):
+            digits = 2;
+            break;
+        }
+        if ((size_t)(end - p) <= digits) SAX_FAIL(JSON_TEXT("Escaped character runs past the end of the string"));
+        JSONWorker::SpecialChar(p, res);
+        ++p;
+    }
+}
+
+static inline bool MatchLiteral(const json_char * & p, const json_char * end, const json_char * literal, size_t length) {
+    if ((size_t)(end - p) < length) return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (p[i] != literal[i]) return false;
+    }
+    p += length;
+    return true;
+}
+
+bool JSONSax::parse(const json_char * json, size_t length, JSONSaxHandler & handler) {
+    const json_char * p = json;
+    const json_char * const end = json + length;
+    json_string containers;  //the { and [ that are still open, innermost last
+    json_string scratch;  //where strings with escapes in them are unescaped to
+    enum { VALUE, FIRST_VALUE, KEY, FIRST_KEY, AFTER_VALUE } expect = VALUE;
+
+    JSONWorker::SkipWhiteSpace(p, end);
+    if ((p == end) || ((*p != JSON_TEXT('{')) && (*p != JSON_TEXT('[')))) SAX_FAIL(JSON_TEXT("Not JSON!"));
+
+    while (true) {
+        JSONWorker::SkipWhiteSpace(p, end);
+        if (expect == AFTER_VALUE) {
+            if (containers.empty()) {
+                if (p != end) SAX_FAIL(JSON_TEXT("Extra characters after the end of the JSON"));
+                return true;
+            }
+            const json_char open = containers[containers.length() - 1];
+            if (p == end) {
+                if (open == JSON_TEXT('{')) SAX_FAIL(JSON_TEXT("Missing final }"));
+                SAX_FAIL(JSON_TEXT("Missing final ]"));
+            }
+            if (*p == JSON_TEXT(',')) {
+                ++p;
+                expect = (open == JSON_TEXT('{')) ? KEY : VALUE;
+                continue;
+            }
+            if ((open == JSON_TEXT('{')) && (*p == JSON_TEXT('}'))) {
+                ++p;
+                containers.erase(containers.length() - 1);
+                SAX_CALL(end_node());
+                continue;
+            }
+            if ((open == JSON_TEXT('[')) && (*p == JSON_TEXT(']'))) {
+                ++p;
+                containers.erase(containers.length() - 1);
+                SAX_CALL(end_array());
+                continue;
+            }
+            SAX_FAIL(JSON_TEXT("Missing , between values"));
+        }
+
+        if (p == end) SAX_FAIL(JSON_TEXT("Missing value"));
+
+        if ((expect == KEY) || (expect == FIRST_KEY)) {
+            if ((expect == FIRST_KEY) && (*p == JSON_TEXT('}'))) {  //a {} (blank node)
+                ++p;
+                containers.erase(containers.length() - 1);
+                SAX_CALL(end_node());
+                expect = AFTER_VALUE;
+                continue;
+            }
+            if (*p != JSON_TEXT('\"')) SAX_FAIL(JSON_TEXT("Missing name"));
+            SAX_STRING(key);
+            JSONWorker::SkipWhiteSpace(p, end);
+            if ((p == end) || (*p != JSON_TEXT(':'))) SAX_FAIL(JSON_TEXT("Missing :"));
+            ++p;
+            expect = VALUE;
+            continue;
+        }
+
+        if ((expect == FIRST_VALUE) && (*p == JSON_TEXT(']'))) {  //a [] (blank array)
+            ++p;
+            containers.erase(containers.length() - 1);
+            SAX_CALL(end_array());
+            expect = AFTER_VALUE;
+            continue;
+        }
+
+        switch (*p) {
+        case JSON_TEXT('{'):
+            ++p;
+            containers += JSON_TEXT('{');
+            SAX_CALL(start_node());
+            expect = FIRST_KEY;
+            continue;
+        case JSON_TEXT('['):
+            ++p;
+            containers += JSON_TEXT('[');
+            SAX_CALL(start_array());
+            expect = FIRST_VALUE;
+            continue;
+        case JSON_TEXT('\"'):
+            SAX_STRING(string);
+            break;
+        case JSON_TEXT('t'):
+            if (!MatchLiteral(p, end, JSON_TEXT("true"), 4)) SAX_FAIL(JSON_TEXT("Not a value"));
+            SAX_CALL(boolean(true));
+            break;
+        case JSON_TEXT('f'):
+            if (!MatchLiteral(p, end, JSON_TEXT("false"), 5)) SAX_FAIL(JSON_TEXT("Not a value"));
+            SAX_CALL(boolean(false));
+            break;
+        case JSON_TEXT('n'):
+            if (!MatchLiteral(p, end, JSON_TEXT("null"), 4)) SAX_FAIL(JSON_TEXT("Not a value"));
+            SAX_CALL(null());
+            break;
+        default: {
+            const json_char * start = p;
+            while (p != end) {
+                const json_char ch = *p;
+                if (((ch < JSON_TEXT('0')) || (ch > JSON_TEXT('9'))) && (ch != JSON_TEXT('-')) && (ch != JSON_TEXT('+')) &&
+                        (ch != JSON_TEXT('.')) && (ch != JSON_TEXT('e')) && (ch != JSON_TEXT('E'))) break;
+                ++p;
+            }
+            if (p == start) SAX_FAIL(JSON_TEXT("Not a value"));
+            SAX_CALL(number(start, p - start));
+            break;
+        }
+        }
+        expect = AFTER_VALUE;
+    }
+}
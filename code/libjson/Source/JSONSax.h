@@ -0,0 +1,43 @@
+#ifndef JSON_SAX_H
+#define JSON_SAX_H
+
+#include "JSONDefs.h"
+#include "JSONDebug.h"
+
+/*
+    An event driven alternative to libJSON::parse.  Instead of building a tree of
+    nodes, the json is read once from start to finish and each piece of it is
+    handed to a JSONSaxHandler as it goes past.  This is for json that is only
+    read once, such as a huge array that is going to be copied into something
+    else anyway, where building the nodes would be wasted work.
+
+    Strings and names are passed as pointers into the json itself whenever they
+    have no escapes in them, so they are only valid until the callback returns
+    and are not null terminated.  Numbers are passed as the text that was in the
+    json, so that the handler can decide how to convert them.
+*/
+class JSONSaxHandler {
+public:
+    virtual ~JSONSaxHandler(void){}
+
+    //each callback returns false to stop parsing, true to carry on
+    virtual bool start_node(void){ return true; }
+    virtual bool end_node(void){ return true; }
+    virtual bool start_array(void){ return true; }
+    virtual bool end_array(void){ return true; }
+    virtual bool key(const json_char *, size_t){ return true; }  //the name of the next value in a node
+    virtual bool string(const json_char *, size_t){ return true; }
+    virtual bool number(const json_char *, size_t){ return true; }
+    virtual bool boolean(bool){ return true; }
+    virtual bool null(void){ return true; }
+};
+
+class JSONSax {
+public:
+    //if json is invalid, it throws a std::invalid_argument exception, returns false if the handler stopped early
+    static bool parse(const json_char * json, size_t length, JSONSaxHandler & handler);
+JSON_PRIVATE
+    static void Unescape(const json_char * p, const json_char * end, json_string & res);
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "JSONScan.h"
+
+#if !defined(JSON_UNICODE) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define JSON_SCAN_X86
+    #include <immintrin.h>
+#endif
+
+static inline bool IsSpace(json_char ch) {
+    return (ch == JSON_TEXT(' ')) || (ch == JSON_TEXT('\t')) || (ch == JSON_TEXT('\n')) || (ch == JSON_TEXT('\r'));
+}
+
+//one character at a time, also used by the vector versions for whatever is left over at the end
+static const json_char * ScalarFindQuoteOrBackslash(const json_char * p, const json_char * end) {
+    while ((p != end) && (*p != JSON_TEXT('\"')) && (*p != JSON_TEXT('\\'))) ++p;
+    return p;
+}
+
+static const json_char * ScalarFindBackslash(const json_char * p, const json_char * end) {
+    while ((p != end) && (*p != JSON_TEXT('\\'))) ++p;
+    return p;
+}
+
+static const json_char * ScalarSkipSpaces(const json_char * p, const json_char * end) {
+    while ((p != end) && IsSpace(*p)) ++p;
+    return p;
+}
+
+#ifdef JSON_SCAN_X86
+    /*
+	   Each kernel compares a whole vector against the characters it's looking for,
+	   squashes the result down to one bit per character, and the lowest set bit is
+	   the first match.  Whitespace is usually only a character or two, so SkipSpaces
+	   checks the first one before bothering with the vectors.
+    */
+    #define SCAN_KERNELS(name, isa, vector, width, load, set1, cmpeq, or_, movemask, allbits)\
+	   __attribute__((target(isa)))\
+	   static const json_char * name##FindQuoteOrBackslash(const json_char * p, const json_char * end){\
+		  const vector quote = set1('\"');\
+		  const vector backslash = set1('\\');\
+		  for (; end - p >= width; p += width){\
+			 const vector chunk = load((const vector *)p);\
+			 const unsigned int mask = (unsigned int)movemask(or_(cmpeq(chunk, quote), cmpeq(chunk, backslash)));\
+			 if (mask) return p + __builtin_ctz(mask);\
+		  }\
+		  return ScalarFindQuoteOrBackslash(p, end);\
+	   }\
+	   __attribute__((target(isa)))\
+	   static const json_char * name##FindBackslash(const json_char * p, const json_char * end){\
+		  const vector backslash = set1('\\');\
+		  for (; end - p >= width; p += width){\
+			 const unsigned int mask = (unsigned int)movemask(cmpeq(load((const vector *)p), backslash));\
+			 if (mask) return p + __builtin_ctz(mask);\
+		  }\
+		  return ScalarFindBackslash(p, end);\
+	   }\
+	   __attribute__((target(isa)))\
+	   static const json_char * name##SkipSpaces(const json_char * p, const json_char * end){\
+		  if ((p == end) || !IsSpace(*p)) return p;\
+		  const vector space = set1(' ');\
+		  const vector tab = set1('\t');\
+		  const vector newline = set1('\n');\
+		  const vector carriagereturn = set1('\r');\
+		  for (; end - p >= width; p += width){\
+			 const vector chunk = load((const vector *)p);\
+			 const vector spaces = or_(or_(cmpeq(chunk, space), cmpeq(chunk, tab)), or_(cmpeq(chunk, newline), cmpeq(chunk, carriagereturn)));\
+			 const unsigned int mask = ~(unsigned int)movemask(spaces) & allbits;\
+			 if (mask) return p + __builtin_ctz(mask);\
+		  }\
+		  return ScalarSkipSpaces(p, end);\
+	   }
+
+    SCAN_KERNELS(SSE2, "sse2", __m128i, 16, _mm_loadu_si128, _mm_set1_epi8, _mm_cmpeq_epi8, _mm_or_si128, _mm_movemask_epi8, 0xFFFFu)
+    SCAN_KERNELS(AVX2, "avx2", __m256i, 32, _mm256_loadu_si256, _mm256_set1_epi8, _mm256_cmpeq_epi8, _mm256_or_si256, _mm256_movemask_epi8, 0xFFFFFFFFu)
+#endif
+
+static bool Supported(JSONScan::Kernel kernel) {
+    switch (kernel) {
+    case JSONScan::Scalar:
+        return true;
+#ifdef JSON_SCAN_X86
+    case JSONScan::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case JSONScan::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+static JSONScan::Kernel Best(void) {
+    if (Supported(JSONScan::AVX2)) return JSONScan::AVX2;
+    if (Supported(JSONScan::SSE2)) return JSONScan::SSE2;
+    return JSONScan::Scalar;
+}
+
+//in case anything is parsed before the static initializer below has run
+static const json_char * ResolveFindQuoteOrBackslash(const json_char * p, const json_char * end) {
+    JSONScan::setKernel(Best());
+    return JSONScan::FindQuoteOrBackslash(p, end);
+}
+
+static const json_char * ResolveFindBackslash(const json_char * p, const json_char * end) {
+    JSONScan::setKernel(Best());
+    return JSONScan::FindBackslash(p, end);
+}
+
+static const json_char * ResolveSkipSpaces(const json_char * p, const json_char * end) {
+    JSONScan::setKernel(Best());
+    return JSONScan::SkipSpaces(p, end);
+}
+
+JSONScan::scanner_t JSONScan::findquote = ResolveFindQuoteOrBackslash;
+JSONScan::scanner_t JSONScan::findbackslash = ResolveFindBackslash;
+JSONScan::scanner_t JSONScan::skipspaces = ResolveSkipSpaces;
+JSONScan::Kernel JSONScan::current = JSONScan::Scalar;
+static const bool chosen = JSONScan::setKernel(Best());
+
+JSONScan::Kernel JSONScan::kernel(void) {
+    return current;
+}
+
+bool JSONScan::setKernel(Kernel kernel) {
+    if (!Supported(kernel)) return false;
+    switch (kernel) {
+#ifdef JSON_SCAN_X86
+    case SSE2:
+        findquote = SSE2FindQuoteOrBackslash;
+        findbackslash = SSE2FindBackslash;
+        skipspaces = SSE2SkipSpaces;
+        break;
+    case AVX2:
+        findquote = AVX2FindQuoteOrBackslash;
+        findbackslash = AVX2FindBackslash;
+        skipspaces = AVX2SkipSpaces;
+        break;
+#endif
+    default:
+        findquote = ScalarFindQuoteOrBackslash;
+        findbackslash = ScalarFindBackslash;
+        skipspaces = ScalarSkipSpaces;
+        break;
+    }
+    current = kernel;
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include "JSONDefs.h"
+#include "JSONDebug.h"
+
+/*
+    The loops that the parsers spend most of their time in, looking through
+    json for the next interesting character.  On x86 these look at 16 or 32
+    characters at a time with SSE2 or AVX2, whichever the processor has, and
+    everywhere else (or with JSON_UNICODE) they go one character at a time.
+
+    Every function looks at [p, end) and returns end if it didn't find anything.
+*/
+class JSONScan {
+public:
+    enum Kernel { Scalar, SSE2, AVX2 };
+
+    //the next " or \, which is all that matters inside of a string
+    static inline const json_char * FindQuoteOrBackslash(const json_char * p, const json_char * end){
+	   return findquote(p, end);
+    }
+    //the next \, for unescaping
+    static inline const json_char * FindBackslash(const json_char * p, const json_char * end){
+	   return findbackslash(p, end);
+    }
+    //the first character that isn't a space, tab, newline or carriage return
+    static inline const json_char * SkipSpaces(const json_char * p, const json_char * end){
+	   return skipspaces(p, end);
+    }
+
+    static Kernel kernel(void);  //the kernel in use, the best one that the processor has unless it's been changed
+    static bool setKernel(Kernel kernel);  //for testing and benchmarking, returns false if the processor can't run it
+JSON_PRIVATE
+    typedef const json_char * (*scanner_t)(const json_char * p, const json_char * end);
+    static scanner_t findquote;
+    static scanner_t findbackslash;
+    static scanner_t skipspaces;
+    static Kernel current;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "JSONStreamWriter.h"
+#include "NumberToString.h"
+
+#ifdef JSON_WRITER
+
+static inline bool NeedsEscape(json_char ch) {
+    return (ch == JSON_TEXT('\"')) || (ch == JSON_TEXT('\\')) || ((ch >= 0) && (ch < 0x20));
+}
+
+//writes one character that NeedsEscape said couldn't go in as it is
+void JSONStreamWriter::escape(json_char ch) {
+    static const json_char hex[] = JSON_TEXT("0123456789abcdef");
+    buffer += JSON_TEXT('\\');
+    switch (ch) {
+	   case JSON_TEXT('\"'):
+	   case JSON_TEXT('\\'):
+		  buffer += ch;
+		  break;
+	   case JSON_TEXT('\b'):
+		  buffer += JSON_TEXT('b');
+		  break;
+	   case JSON_TEXT('\f'):
+		  buffer += JSON_TEXT('f');
+		  break;
+	   case JSON_TEXT('\n'):
+		  buffer += JSON_TEXT('n');
+		  break;
+	   case JSON_TEXT('\r'):
+		  buffer += JSON_TEXT('r');
+		  break;
+	   case JSON_TEXT('\t'):
+		  buffer += JSON_TEXT('t');
+		  break;
+	   default:  //any other control character
+		  buffer += JSON_TEXT("u00");
+		  buffer += hex[(ch >> 4) & 0xF];
+		  buffer += hex[ch & 0xF];
+		  break;
+    }
+}
+
+//copies [p, end) in runs, only stopping for the characters that have to be escaped
+void JSONStreamWriter::escape(const json_char * p, const json_char * end) {
+    buffer += JSON_TEXT('\"');
+    while (p != end) {
+	   const json_char * start = p;
+	   while ((p != end) && !NeedsEscape(*p)) ++p;
+	   buffer.append(start, p - start);
+	   if (p != end) escape(*p++);
+    }
+    buffer += JSON_TEXT('\"');
+}
+
+JSONStreamWriter & JSONStreamWriter::raw(const json_char * text, size_t length) {
+    buffer.append(text, length);
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::start_node(void) {
+    separate();
+    buffer += JSON_TEXT('{');
+    first = true;
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::end_node(void) {
+    buffer += JSON_TEXT('}');
+    first = false;
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::start_array(void) {
+    separate();
+    buffer += JSON_TEXT('[');
+    first = true;
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::end_array(void) {
+    buffer += JSON_TEXT(']');
+    first = false;
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::key(const json_char * name, size_t length) {
+    separate();
+    escape(name, name + length);
+    buffer += JSON_TEXT(':');
+    first = true;  //the value goes straight after the colon
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::key(const json_char * name) {
+    return key(name, json_strlen(name));
+}
+
+JSONStreamWriter & JSONStreamWriter::string(const json_char * value, size_t length) {
+    separate();
+    escape(value, value + length);
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::string(const json_char * value) {
+    return string(value, json_strlen(value));
+}
+
+#ifndef JSON_UNICODE
+    /*
+	   Turns utf-16 into utf-8 as it goes, so that something like a QString can be
+	   written without making a utf-8 copy of it first.  A surrogate without its
+	   other half is written as U+FFFD.
+    */
+    JSONStreamWriter & JSONStreamWriter::string(const unsigned short * value, size_t length) {
+	   separate();
+	   buffer += JSON_TEXT('\"');
+	   const unsigned short * end = value + length;
+	   while (value != end) {
+		  unsigned long ch = *value++;
+		  if (ch < 0x80) {
+			 if (NeedsEscape((json_char)ch)) {
+				escape((json_char)ch);
+			 } else {
+				buffer += (json_char)ch;
+			 }
+			 continue;
+		  }
+		  if ((ch >= 0xD800) && (ch < 0xE000)) {
+			 if ((ch < 0xDC00) && (value != end) && (*value >= 0xDC00) && (*value < 0xE000)) {
+				ch = 0x10000 + ((ch - 0xD800) << 10) + (*value++ - 0xDC00);
+			 } else {
+				ch = 0xFFFD;
+			 }
+		  }
+		  if (ch < 0x800) {
+			 buffer += (json_char)(0xC0 | (ch >> 6));
+		  } else {
+			 if (ch < 0x10000) {
+				buffer += (json_char)(0xE0 | (ch >> 12));
+			 } else {
+				buffer += (json_char)(0xF0 | (ch >> 18));
+				buffer += (json_char)(0x80 | ((ch >> 12) & 0x3F));
+			 }
+			 buffer += (json_char)(0x80 | ((ch >> 6) & 0x3F));
+		  }
+		  buffer += (json_char)(0x80 | (ch & 0x3F));
+	   }
+	   buffer += JSON_TEXT('\"');
+	   return *this;
+    }
+#endif
+
+JSONStreamWriter & JSONStreamWriter::number(long value) {
+    separate();
+    json_char digits[24];
+    json_char * p = digits + 24;
+    unsigned long remaining = (value < 0) ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+	   *--p = (json_char)(JSON_TEXT('0') + (remaining % 10));
+	   remaining /= 10;
+    } while (remaining);
+    if (value < 0) *--p = JSON_TEXT('-');
+    buffer.append(p, digits + 24 - p);
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::number(json_number value) {
+    separate();
+    buffer += NumberToString::_ftoa<json_number>(value);
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::boolean(bool value) {
+    separate();
+    buffer += value ? JSON_TEXT("true") : JSON_TEXT("false");
+    return *this;
+}
+
+JSONStreamWriter & JSONStreamWriter::null(void) {
+    separate();
+    buffer += JSON_TEXT("null");
+    return *this;
+}
+#endif
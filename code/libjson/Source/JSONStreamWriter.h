@@ -0,0 +1,61 @@
+#ifndef JSON_STREAM_WRITER_H
+#define JSON_STREAM_WRITER_H
+
+#include "JSONDefs.h"
+#include "JSONDebug.h"
+
+#ifdef JSON_WRITER
+/*
+    The writing counterpart to JSONSax.  Instead of building a tree of nodes and
+    then writing it, each call appends straight onto one buffer.  clear() empties
+    the buffer but keeps its memory, so a writer that is reused doesn't allocate
+    once it has grown to fit the biggest thing written with it.
+
+    It only writes compact json, and it's up to the caller to open and close
+    things in the right order and to give every value in a node a key first.
+    Every call returns the writer so that they can be chained.
+*/
+class JSONStreamWriter {
+public:
+    JSONStreamWriter(void) : buffer(), first(true) {}
+
+    inline void clear(void){ buffer.clear(); first = true; }
+    inline const json_string & str(void) const { return buffer; }
+    inline const json_char * data(void) const { return buffer.data(); }
+    inline size_t length(void) const { return buffer.length(); }
+
+    //text that is written as it is, such as a command in front of the json
+    JSONStreamWriter & raw(const json_char * text, size_t length);
+
+    JSONStreamWriter & start_node(void);
+    JSONStreamWriter & end_node(void);
+    JSONStreamWriter & start_array(void);
+    JSONStreamWriter & end_array(void);
+    JSONStreamWriter & key(const json_char * name, size_t length);
+    JSONStreamWriter & key(const json_char * name);
+    inline JSONStreamWriter & key(const json_string & name){ return key(name.data(), name.length()); }
+    JSONStreamWriter & string(const json_char * value, size_t length);
+    JSONStreamWriter & string(const json_char * value);
+    inline JSONStreamWriter & string(const json_string & value){ return string(value.data(), value.length()); }
+    #ifndef JSON_UNICODE
+	   JSONStreamWriter & string(const unsigned short * value, size_t length);  //utf-16, written out as utf-8
+    #endif
+    JSONStreamWriter & number(long value);
+    inline JSONStreamWriter & number(int value){ return number((long)value); }
+    JSONStreamWriter & number(json_number value);
+    JSONStreamWriter & boolean(bool value);
+    JSONStreamWriter & null(void);
+JSON_PRIVATE
+    inline void separate(void){
+	   if (!first) buffer += JSON_TEXT(',');
+	   first = false;
+    }
+    void escape(const json_char * p, const json_char * end);
+    void escape(json_char ch);
+
+    json_string buffer;
+    bool first;  //nothing has been written at this level yet, or a key has just been written, so no comma is needed
+};
+#endif
+
+#endif
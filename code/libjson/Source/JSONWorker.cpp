@@ -1,4 +1,5 @@
 #include "JSONWorker.h"
+#include "JSONScan.h"
 
 #ifdef JSON_VALIDATE
 JSONNode JSONWorker::validate(const json_string & json) {
@@ -10,196 +11,254 @@ JSONNode JSONWorker::validate(const json_string & json) {
 }
 #endif
 
-JSONNode JSONWorker::parse(const json_string & json) {
-    json_auto<json_char> s;
-#if defined JSON_DEBUG || defined JSON_SAFE
-    json_char lastchar;
-    s.set(RemoveWhiteSpace(json, lastchar));
+JSONNode JSONWorker::parse(const json_string & json, json_parse_policy policy) {
+    return parse(json.c_str(), json.length(), policy);
+}
+
+#define PARSE_FAIL(msg)\
+    {\
+	   JSON_FAIL(msg);\
+	   throw std::invalid_argument(EMPTY_STRING2);\
+    }
+
+/*
+    Parses the json held in [json, json + length) without copying it into a json_string first, the
+    range does not need to be null terminated.  The json is read once from start to finish, nodes
+    and arrays are built as they are found, and strings and numbers keep the text they were written
+    as until they are fetched, so the cost is linear in the size of the json however deeply it nests.
+
+    With JSON_PARSE_PREPARSE everything is fetched before it's returned, and with JSON_PARSE_TRUSTED
+    the literals aren't checked.  The structure is always checked, as that's what keeps the parser
+    inside of the range, and so is the depth, as the parser recurses once for each level and json
+    nested deeper than JSON_MAX_DEPTH would otherwise run it out of stack.  Everything in the range
+    has to be used, a null terminator included.
+*/
+JSONNode JSONWorker::parse(const json_char * json, size_t length, json_parse_policy policy) {
+    const json_char * p = json;
+    const json_char * const end = json + length;
+#ifdef JSON_COMMENTS
+    json_string _comment;
+    SkipWhiteSpace(p, end, &_comment);
 #else
-    s.set(RemoveWhiteSpace(json));
+    SkipWhiteSpace(p, end);
 #endif
+    if ((p == end) || ((*p != JSON_TEXT('{')) && (*p != JSON_TEXT('[')))) PARSE_FAIL(JSON_TEXT("Not JSON!"));
 
+    JSONNode root((*p == JSON_TEXT('{')) ? JSON_NODE : JSON_ARRAY);
 #ifdef JSON_COMMENTS
-    json_char firstchar = s.ptr[0];
-    json_string _comment;
-    json_char * runner = s.ptr;
-    if (firstchar == '\5') { //multiple comments will be consolidated into one
-newcomment:
-        while (*(++runner) != '\5') {
-            JSON_ASSERT(*runner, JSON_TEXT("Removing white space failed"));
-            _comment += *runner;
-        }
-        firstchar = *(++runner); //step past the trailing tag
-        if (firstchar == '\5') {
-            _comment += '\n';
-            goto newcomment;
-        }
+    root.set_comment(_comment);
+#endif
+    const bool trusted = (policy & JSON_PARSE_TRUSTED) != 0;
+    if (*p == JSON_TEXT('{')) {
+        ParseNode(root.internal, p, end, trusted, 1);
+    } else {
+        ParseArray(root.internal, p, end, trusted, 1);
     }
-#else
-    const json_char firstchar = s.ptr[0];
+    SkipWhiteSpace(p, end);
+    if (p != end) PARSE_FAIL(JSON_TEXT("Extra characters after the end of the JSON"));
+#ifndef JSON_PREPARSE
+    if (policy & JSON_PARSE_PREPARSE) root.preparse();
 #endif
+    return root;
+}
 
-    switch (firstchar) {
-    case '{':
-    case '[':
-#if defined JSON_DEBUG || defined JSON_SAFE
-        if (firstchar == '[') {
-            if (lastchar != ']') {
-                JSON_FAIL(JSON_TEXT("Missing final ]"));
-                break;
+//skips white space and comments, handing the text of the comments to comment if it isn't null
+void JSONWorker::SkipWhiteSpace(const json_char * & p, const json_char * end, json_string * comment) {
+    while ((p = JSONScan::SkipSpaces(p, end)) != end) {
+        const json_char * text;
+        switch (*p) {
+        case JSON_TEXT('/'):  //a C comment
+            if ((p + 1 != end) && (*(p + 1) == JSON_TEXT('*'))) {
+                text = p += 2;
+                while ((p != end) && ((*p != JSON_TEXT('*')) || (p + 1 == end) || (*(p + 1) != JSON_TEXT('/')))) {
+                    ++p;
+                }
+                if (p == end) PARSE_FAIL(JSON_TEXT("Null terminator inside of a multiline quote"));
+                p += 2;
+                if (comment) AddComment(*comment, text, p - 2);
+                continue;
             }
-        } else {
-            if (lastchar != '}') {
-                JSON_FAIL(JSON_TEXT("Missing final }"));
-                break;
+            if ((p + 1 == end) || (*(p + 1) != JSON_TEXT('/'))) return;  //a stray /, which the caller will complain about
+            ++p;
+            //a single line C comment, so let it fall through to use the bash comment skipper
+        case JSON_TEXT('#'):  //a bash comment
+            text = ++p;
+            while ((p != end) && (*p != JSON_TEXT('\n'))) {
+                ++p;
             }
+            if (comment) AddComment(*comment, text, p);
+            continue;
+        default:
+            return;
         }
-#endif
-#ifdef JSON_COMMENTS
-        JSONNode foo(runner);
-        foo.set_comment(_comment);
-        return JSONNode(true, foo);  //forces it to simply return the original interal, even with ref counting off
-#else
-        return JSONNode(s.ptr);
-#endif
     }
+}
 
-    JSON_FAIL(JSON_TEXT("Not JSON!"));
-    throw std::invalid_argument(EMPTY_STRING2);
+//consecutive comments are consolidated into one, a line each
+void JSONWorker::AddComment(json_string & comment, const json_char * start, const json_char * end) {
+    if (!comment.empty()) comment += JSON_TEXT('\n');
+    comment.append(start, end - start);
 }
 
-#define QUOTECASE()\
-    case JSON_TEXT('\"'):\
-	   while (*(++p) != JSON_TEXT('\"')){\
-		  JSON_ASSERT_SAFE(*p, JSON_TEXT("Null terminator inside of a quotation"), return json_string::npos;);\
-	   }\
-	   break;
+//p is just past the opening quote, returns the closing quote and whether there was anything escaped in between
+const json_char * JSONWorker::FindEndOfString(const json_char * p, const json_char * end, bool & escaped) {
+    while ((p = JSONScan::FindQuoteOrBackslash(p, end)) != end) {
+        if (*p == JSON_TEXT('\"')) return p;
+        escaped = true;
+        if (++p == end) PARSE_FAIL(JSON_TEXT("Escape at the end of a quotation"));
+        ++p;  //whatever was escaped, even if it's a quote
+    }
+    PARSE_FAIL(JSON_TEXT("Null terminator inside of a quotation"));
+}
 
-#ifdef JSON_DEBUG
-#define NULLCASE(error)\
-	   case JSON_TEXT('\0'):\
-		  JSON_FAIL_SAFE(error, return json_string::npos;);\
-		  break;
+//reads the members of the node that p is at, leaving p just past its closing }.  depth is how deeply the node is nested, the root being 1
+void JSONWorker::ParseNode(internalJSONNode * parent, const json_char * & p, const json_char * end, bool trusted, unsigned int depth) {
+    ++p;  //the {
+    while (true) {
+#ifdef JSON_COMMENTS
+        json_string _comment;
+        SkipWhiteSpace(p, end, &_comment);
 #else
-#define NULLCASE(error)
+        SkipWhiteSpace(p, end);
 #endif
-
-#define BRACKET(left, right)\
-    case left: {\
-	   size_t brac = 1;\
-	   while (brac){\
-		  switch (*(++p)){\
-			 case right:\
-				--brac;\
-				break;\
-			 case left:\
-				++brac;\
-				break;\
-			 QUOTECASE()\
-			 NULLCASE(JSON_TEXT("Null terminator inside of a bracket"))\
-		  }\
-	   }\
-	   break;}\
-    case right:\
-	   return json_string::npos;
-
-size_t JSONWorker::FindNextRelevant(json_char ch, const json_string & value_t, const size_t pos) {
-    const json_char * start = value_t.c_str();
-    const json_char * p = start + pos; //start at the correct offset
-    do {
-        if (*p == ch) return p - start;
-        switch (*p) {
-            BRACKET(JSON_TEXT('['), JSON_TEXT(']'))
-            BRACKET(JSON_TEXT('{'), JSON_TEXT('}'))
-            QUOTECASE()
+        if (p == end) PARSE_FAIL(JSON_TEXT("Missing final }"));
+        if ((*p == JSON_TEXT('}')) && parent -> Children.empty()) {  //a {} (blank node)
+            ++p;
+            return;
         }
-    } while (*(++p));
-    return json_string::npos;
-}
-
+        if (*p != JSON_TEXT('\"')) PARSE_FAIL(JSON_TEXT("Missing name"));
+        bool escaped = false;
+        const json_char * name = ++p;
+        p = FindEndOfString(p, end, escaped);
+        const json_string name_t(name, p - name);
+        ++p;
+        SkipWhiteSpace(p, end);
+        if ((p == end) || (*p != JSON_TEXT(':'))) PARSE_FAIL(JSON_TEXT("Missing :"));
+        ++p;
+        ParseValue(parent, name_t, escaped, p, end, trusted, depth);
 #ifdef JSON_COMMENTS
-#define COMMENT_DELIMITER() *runner++ = '\5'
-#define AND_RUNNER ,runner
-inline void SingleLineComment(const json_char * & p, json_char * & runner) {
-    COMMENT_DELIMITER();
-    while ((*(++p)) && (*p != JSON_TEXT('\n'))) {
-        *runner++ = *p;
+        parent -> Children[parent -> Children.size() - 1] -> set_comment(_comment);
+#endif
+        SkipWhiteSpace(p, end);
+        if (p == end) PARSE_FAIL(JSON_TEXT("Missing final }"));
+        if (*p == JSON_TEXT('}')) {
+            ++p;
+            return;
+        }
+        if (*p != JSON_TEXT(',')) PARSE_FAIL(JSON_TEXT("Missing , between values"));
+        ++p;
     }
-    COMMENT_DELIMITER();
 }
+
+//reads the values of the array that p is at, leaving p just past its closing ]
+void JSONWorker::ParseArray(internalJSONNode * parent, const json_char * & p, const json_char * end, bool trusted, unsigned int depth) {
+    ++p;  //the [
+    while (true) {
+#ifdef JSON_COMMENTS
+        json_string _comment;
+        SkipWhiteSpace(p, end, &_comment);
 #else
-#define COMMENT_DELIMITER() (void)0
-#define AND_RUNNER
+        SkipWhiteSpace(p, end);
 #endif
-
-inline void SingleLineComment(const json_char * & p) {
-    while ((*(++p)) && (*p != JSON_TEXT('\n')));
+        if (p == end) PARSE_FAIL(JSON_TEXT("Missing final ]"));
+        if ((*p == JSON_TEXT(']')) && parent -> Children.empty()) {  //a [] (blank array)
+            ++p;
+            return;
+        }
+        ParseValue(parent, json_string(), false, p, end, trusted, depth);
+#ifdef JSON_COMMENTS
+        parent -> Children[parent -> Children.size() - 1] -> set_comment(_comment);
+#endif
+        SkipWhiteSpace(p, end);
+        if (p == end) PARSE_FAIL(JSON_TEXT("Missing final ]"));
+        if (*p == JSON_TEXT(']')) {
+            ++p;
+            return;
+        }
+        if (*p == JSON_TEXT(':')) PARSE_FAIL(JSON_TEXT("Key/Value pairs are not allowed in arrays"));
+        if (*p != JSON_TEXT(',')) PARSE_FAIL(JSON_TEXT("Missing , between values"));
+        ++p;
+    }
 }
 
+//a name with nothing escaped in it is already what it says, so it isn't copied again by FixString
+static inline void SetName(internalJSONNode * node, const json_string & name_t, bool escaped) {
+    if (!escaped) {
+        node -> _name = name_t;
+        return;
+    }
+    node -> _name = JSONWorker::FixString(name_t, node, true);
+}
 
-#if defined JSON_DEBUG || defined JSON_SAFE
-json_char * JSONWorker::RemoveWhiteSpace(const json_string & value_t, json_char & last) {
-#else
-json_char * JSONWorker::RemoveWhiteSpace(const json_string & value_t) {
-#endif
-    json_char * result;
-    json_char * runner = result = json_malloc<json_char>(value_t.length() + 1);  //dealing with raw memory is faster than adding to a json_string
-    JSON_ASSERT(result, JSON_TEXT("Out of memory"));
-    const json_char * p = value_t.c_str();
-    while (*p) {
+//reads the value at p and attaches it to parent, leaving p just past it.  depth is the parent's
+void JSONWorker::ParseValue(internalJSONNode * parent, const json_string & name_t, bool nameescaped, const json_char * & p, const json_char * end, bool trusted, unsigned int depth) {
+    SkipWhiteSpace(p, end);
+    const json_char * start = p;
+    if (p != end) {
         switch (*p) {
-        case JSON_TEXT(' '):   //defined as white space
-        case JSON_TEXT('\t'):  //defined as white space
-        case JSON_TEXT('\n'):  //defined as white space
-        case JSON_TEXT('\r'):  //defined as white space
-            break;
-        case JSON_TEXT('/'):  //a C comment
-            if (*(++p) == JSON_TEXT('*')) { //a multiline comment
-                COMMENT_DELIMITER();
-                while ((*(++p) != JSON_TEXT('*')) || (*(p + 1) != JSON_TEXT('/'))) {
-                    JSON_ASSERT_SAFE(*p, JSON_TEXT("Null terminator inside of a multiline quote"), COMMENT_DELIMITER(); goto endofloop;);
-                    *runner++ = *p;
-                }
-                ++p;
-                COMMENT_DELIMITER();
-                break;
+        case JSON_TEXT('{'):
+        case JSON_TEXT('['): {
+            if (depth >= JSON_MAX_DEPTH) PARSE_FAIL(JSON_TEXT("Nested too deeply"));
+            internalJSONNode * myinternal = internalJSONNode::newInternal((*p == JSON_TEXT('{')) ? JSON_NODE : JSON_ARRAY);
+            SetName(myinternal, name_t, nameescaped);
+            parent -> Children.push_back(JSONNode::newJSONNode(myinternal));  //attached before it's filled in, so that it gets freed if the rest of the json is bad
+            if (*p == JSON_TEXT('{')) {
+                ParseNode(myinternal, p, end, trusted, depth + 1);
+            } else {
+                ParseArray(myinternal, p, end, trusted, depth + 1);
             }
-            //Should be a single line C comment, so let it fall through to use the bash comment stripper
-            JSON_ASSERT_SAFE(*p == JSON_TEXT('/'), JSON_TEXT("stray / character, not quoted, or a comment"), goto endofloop;);
-        case JSON_TEXT('#'):  //a bash comment
-            SingleLineComment(p AND_RUNNER);
-            break;
-        case JSON_TEXT('\"'):  //a quote
-            *runner++ = JSON_TEXT('\"');
-            while (*(++p) != JSON_TEXT('\"')) {  //find the end of the quotation, as white space is preserved within it
-                JSON_ASSERT_SAFE(*p, JSON_TEXT("Null terminator inside of a quotation"), goto endofloop;);
+            return;
+        }
+        case JSON_TEXT('\"'): {
+            //only the text between the quotes is kept, and it's only unescaped if something asks for it
+            bool escaped = false;
+            const json_char * text = p + 1;
+            p = FindEndOfString(text, end, escaped);
+            internalJSONNode * myinternal = internalJSONNode::newInternal(JSON_STRING);
+            SetName(myinternal, name_t, nameescaped);
+            myinternal -> SetParsedString(text, p, escaped);
+            ++p;
+            parent -> Children.push_back(JSONNode::newJSONNode(myinternal));
+            return;
+        }
+        default:  //a number or literal, or nothing at all, which is null
+            while ((p != end) && (*p)) {
                 switch (*p) {
-                case JSON_TEXT('\\'):
-                    *runner++ = JSON_TEXT('\\');
-                    *runner++ = (*++p == JSON_TEXT('\"')) ? JSON_TEXT('\1') : *p;  //an escaped quote will reak havoc will all of my searching functions, so change it into an illegal character in JSON for convertion later on
-                    break;
-                default:
-                    *runner++ = *p;
-                    break;
+                case JSON_TEXT(','):
+                case JSON_TEXT('}'):
+                case JSON_TEXT(']'):
+                case JSON_TEXT(':'):
+                case JSON_TEXT('{'):
+                case JSON_TEXT('['):
+                case JSON_TEXT('\"'):
+                case JSON_TEXT(' '):
+                case JSON_TEXT('\t'):
+                case JSON_TEXT('\n'):
+                case JSON_TEXT('\r'):
+                case JSON_TEXT('/'):
+                case JSON_TEXT('#'):
+                    goto endofvalue;
                 }
+                ++p;
             }
-            //no break, let it fall through so that the trailing quote gets added
-        default:
-            JSON_ASSERT_SAFE((unsigned json_char)*p >= 32, JSON_TEXT("Invalid JSON character detected (lo)"), goto endofloop;);
-            JSON_ASSERT_SAFE((unsigned json_char)*p <= 126, JSON_TEXT("Invalid JSON character detected (hi)"), goto endofloop;);
-            *runner++ = *p;
+endofvalue:
             break;
         }
-        ++p;
     }
-#ifdef JSON_SAFE
-endofloop:
-#endif
-#if defined JSON_DEBUG || defined JSON_SAFE
-    last = *(runner - 1);
-#endif
-    *runner = JSON_TEXT('\0');
-    return result;
+    //the text is kept as it was written, it isn't converted until something asks for it
+    internalJSONNode * myinternal;
+    if (trusted) {
+        myinternal = internalJSONNode::newInternal();
+        myinternal -> SetTrustedLiteral(start, p);
+    } else {
+        myinternal = internalJSONNode::newInternal(json_string(), json_string(start, p - start));
+    }
+    SetName(myinternal, name_t, nameescaped);
+    parent -> Children.push_back(JSONNode::newJSONNode(myinternal));
+}
+
+inline void SingleLineComment(const json_char * & p) {
+    while ((*(++p)) && (*p != JSON_TEXT('\n')));
 }
 
 json_string JSONWorker::RemoveWhiteSpaceAndComments(const json_string & value_t) {
@@ -233,7 +292,7 @@ json_string JSONWorker::RemoveWhiteSpaceAndComments(const json_string & value_t)
                 switch (*p) {
                 case JSON_TEXT('\\'):
                     result += JSON_TEXT('\\');
-                    result += (*++p == JSON_TEXT('\"')) ? JSON_TEXT('\1') : *p;  //an escaped quote will reak havoc will all of my searching functions, so change it into an illegal character in JSON for convertion later on
+                    result += *++p;
                     break;
                 default:
                     result += *p;
@@ -343,7 +402,7 @@ void JSONWorker::SpecialChar(const json_char * & pos, json_string & res) {
     convert these escaped characters into C characters
     */
     switch (*pos) {
-    case JSON_TEXT('\1'):  //quote character (altered by RemoveWhiteSpace)
+    case JSON_TEXT('\"'):  //quote character
         res += JSON_TEXT('\"');
         break;
     case JSON_TEXT('t'):	//tab character
@@ -403,7 +462,6 @@ void JSONWorker::SpecialChar(const json_char * & pos, json_string & res) {
     }
 }
 
-#ifdef JSON_LESS_MEMORY
 inline void doflag(const internalJSONNode * flag, bool which, bool x) {
     if (which) {
         flag -> _name_encoded = x;
@@ -413,28 +471,24 @@ inline void doflag(const internalJSONNode * flag, bool which, bool x) {
 }
 
 json_string JSONWorker::FixString(const json_string & value_t, const internalJSONNode * flag, bool which) {
+    return FixString(value_t.data(), value_t.data() + value_t.length(), flag, which);
+}
+
+json_string JSONWorker::FixString(const json_char * p, const json_char * end, const internalJSONNode * flag, bool which) {
 #define setflag(x) doflag(flag, which, x)
-#else
-json_string JSONWorker::FixString(const json_string & value_t, bool & flag) {
-#define setflag(x) flag = x
-#endif
     /*
-    Do things like unescaping
+    Do things like unescaping, copying everything between the escapes in one go
     */
     setflag(false);
     json_string res;
-    res.reserve(value_t.length());	 //since it goes one character at a time, want to reserve it first so that it doens't have to reallocating
-    const json_char * p = value_t.c_str();
-    while (*p) {
-        switch (*p) {
-        case JSON_TEXT('\\'):
-            setflag(true);
-            SpecialChar(++p, res);
-            break;
-        default:
-            res += *p;
-            break;
-        }
+    res.reserve(end - p);
+    while (p < end) {
+        const json_char * backslash = JSONScan::FindBackslash(p, end);
+        res.append(p, backslash - p);
+        if (backslash == end) break;
+        setflag(true);
+        p = backslash;
+        SpecialChar(++p, res);
         ++p;
     }
     return res;
@@ -533,102 +587,3 @@ json_string JSONWorker::UnfixString(const json_string & value_t, bool flag) {
     }
     return res;
 }
-
-
-//Create a childnode
-#ifdef JSON_COMMENTS
-#define ARRAY_PARAM bool array  //Just to supress warnings
-#else
-#define ARRAY_PARAM bool
-#endif
-inline void JSONWorker::NewNode(const internalJSONNode * parent, const json_string & name, const json_string & value, ARRAY_PARAM) {
-#ifdef JSON_COMMENTS
-    const json_char * runner = (array) ? value.c_str() : name.c_str();
-    json_string _comment;
-    if (*runner == '\5') { //multiple comments will be consolidated into one
-newcomment:
-        while (*(++runner) != '\5') {
-            JSON_ASSERT(*runner, JSON_TEXT("Removing white space failed"));
-            _comment += *runner;
-        }
-        if (*(++runner) == '\5') { //step past the trailing tag
-            _comment += '\n';
-            goto newcomment;
-        }
-    }
-    internalJSONNode * myinternal;
-    if (array) {
-        myinternal = internalJSONNode::newInternal(name, runner);
-    } else {
-        myinternal = internalJSONNode::newInternal(++runner, value);
-    }
-    JSONNode * child = JSONNode::newJSONNode(myinternal);
-    child -> set_comment(_comment);
-    const_cast<internalJSONNode*>(parent) -> Children.push_back(child);   //attach it to the parent node
-#else
-    const_cast<internalJSONNode*>(parent) -> Children.push_back(JSONNode::newJSONNode(internalJSONNode::newInternal(name.c_str() + 1, value)));	    //attach it to the parent node
-#endif
-}
-
-//Create a subarray
-void JSONWorker::DoArray(const internalJSONNode * parent, const json_string & value_t) {
-    /*
-    This takes an array and creates nodes out of them
-    */
-    JSON_ASSERT(!value_t.empty(), JSON_TEXT("DoArray is empty"));
-    JSON_ASSERT_SAFE(value_t[0] == JSON_TEXT('['), JSON_TEXT("DoArray is not an array"), parent -> Nullify(); return;);
-    const size_t len = value_t.length();
-    if (len <= 2) return;  // just a [] (blank array)
-
-    //Not sure what's in the array, so we have to use commas
-    size_t starting = 1;  //ignore the [
-    size_t ending = FindNextRelevant(JSON_TEXT(','), value_t, 1);
-    while (ending != json_string::npos) {
-#ifdef JSON_SAFE
-        json_string newValue = value_t.substr(starting, ending - starting);
-        JSON_ASSERT_SAFE(FindNextRelevant(JSON_TEXT(':'), newValue, 0) == json_string::npos, JSON_TEXT("Key/Value pairs are not allowed in arrays"), parent -> Nullify(); return;);
-        NewNode(parent, JSON_TEXT(""), newValue, true);
-#else
-        NewNode(parent, JSON_TEXT(""), value_t.substr(starting, ending - starting), true);
-#endif
-        starting = ending + 1;
-        ending = FindNextRelevant(JSON_TEXT(','), value_t, starting);
-    }
-    //since the last one will not find the comma, we have to add it here, but ignore the final ]
-
-#ifdef JSON_SAFE
-    json_string newValue = value_t.substr(starting, len - starting - 1);
-    JSON_ASSERT_SAFE(FindNextRelevant(JSON_TEXT(':'), newValue, 0) == json_string::npos, JSON_TEXT("Key/Value pairs are not allowed in arrays"), parent -> Nullify(); return;);
-    NewNode(parent, JSON_TEXT(""), newValue, true);
-#else
-    NewNode(parent, JSON_TEXT(""), value_t.substr(starting, len - starting - 1), true);
-#endif
-}
-
-
-//Create all child nodes
-void JSONWorker::DoNode(const internalJSONNode * parent, const json_string & value_t) {
-    /*
-    This take a node and creates its members and such
-    */
-    JSON_ASSERT(!value_t.empty(), JSON_TEXT("DoNode is empty"));
-    JSON_ASSERT_SAFE(value_t[0] == JSON_TEXT('{'), JSON_TEXT("DoNode is not an node"), parent -> Nullify(); return;);
-    const size_t len = value_t.length();
-    if (len <= 2) return;  // just a {} (blank node)
-
-    size_t name_starting = 1;  //ignore the {
-    size_t name_ending = FindNextRelevant(JSON_TEXT(':'), value_t, 1);  //find where the name ends
-    JSON_ASSERT_SAFE(name_ending != json_string::npos, JSON_TEXT("Missing :"), parent -> Nullify(); return;);
-    json_string name = value_t.substr(name_starting, name_ending - 2);	  //pull the name out
-    size_t value_ending = FindNextRelevant(JSON_TEXT(','), value_t, name_ending);  //find the end of the value
-    while (value_ending != json_string::npos) {
-        NewNode(parent, name, value_t.substr(name_ending + 1, value_ending - name_ending - 1), false);
-        name_starting = value_ending + 1;
-        name_ending = FindNextRelevant(JSON_TEXT(':'), value_t, name_starting);
-        JSON_ASSERT_SAFE(name_ending != json_string::npos, JSON_TEXT("Missing :"), parent -> Nullify(); return;);
-        name = value_t.substr(name_starting, name_ending - name_starting - 1);
-        value_ending = FindNextRelevant(JSON_TEXT(','), value_t, name_ending);
-    }
-    //since the last one will not find the comma, we have to add it here
-    NewNode(parent, name, value_t.substr(name_ending + 1, len - name_ending - 2), false);
-}
@@ -3,33 +3,35 @@
 
 #include "JSONNode.h"
 
+//how parse treats what it's given, PREPARSE and TRUSTED can be used together
+enum json_parse_policy {
+    JSON_PARSE_LAZY = 0,  //strings and numbers aren't decoded until they're read
+    JSON_PARSE_PREPARSE = 1,  //everything is decoded before parse returns
+    JSON_PARSE_TRUSTED = 2  //the json comes from somewhere that only sends valid json, so literals are known by their first character without checking the rest
+};
+
+//so that a combination is still a policy, and not an int that would be taken for a length
+inline json_parse_policy operator | (json_parse_policy one, json_parse_policy two){
+    return (json_parse_policy)((int)one | (int)two);
+}
+
 class JSONWorker {
 public:
-    static JSONNode parse(const json_string & json);
+    static JSONNode parse(const json_string & json, json_parse_policy policy = JSON_PARSE_LAZY);
+    static JSONNode parse(const json_char * json, size_t length, json_parse_policy policy = JSON_PARSE_LAZY);
     #ifdef JSON_VALIDATE
 	   static JSONNode validate(const json_string & json);
     #endif
-    #if defined JSON_DEBUG || defined JSON_SAFE
-	   static json_char * RemoveWhiteSpace(const json_string & value_t, json_char & last);
-    #else
-	   static json_char * RemoveWhiteSpace(const json_string & value_t);
-    #endif
     static json_string RemoveWhiteSpaceAndComments(const json_string & value_t);
-    
-    static void DoArray(const internalJSONNode * parent, const json_string & value_t);
-    static void DoNode(const internalJSONNode * parent, const json_string & value_t);
 
-    #ifdef JSON_LESS_MEMORY
-	   #define NAME_ENCODED this, true
-	   #define STRING_ENCODED this, false
-	   static json_string FixString(const json_string & value_t, const internalJSONNode * flag, bool which);
-    #else
-	   #define NAME_ENCODED _name_encoded
-	   #define STRING_ENCODED _string_encoded
-	   static json_string FixString(const json_string & value_t, bool & flag);
-    #endif
+    //the flags are bits, which can't be passed by reference, so it's the node and which of its flags to set
+    #define NAME_ENCODED this, true
+    #define STRING_ENCODED this, false
+    static json_string FixString(const json_string & value_t, const internalJSONNode * flag, bool which);
+    static json_string FixString(const json_char * p, const json_char * end, const internalJSONNode * flag, bool which);
     static json_string UnfixString(const json_string & value_t, bool flag);
 JSON_PRIVATE
+    friend class JSONSax;  //shares the scanning and unescaping
     static json_char Hex(const json_char * & pos);
     static unsigned json_char UTF8(const json_char * & pos);
     static json_string toUTF8(unsigned json_char p);
@@ -38,8 +40,12 @@ JSON_PRIVATE
 	   static json_string toSurrogatePair(unsigned json_char pos);
     #endif
     static void SpecialChar(const json_char * & pos, json_string & res);
-    static size_t FindNextRelevant(json_char ch, const json_string & value_t, const size_t pos);
-    static void NewNode(const internalJSONNode * parent, const json_string & name, const json_string & value, bool array);
+    static void SkipWhiteSpace(const json_char * & p, const json_char * end, json_string * comment = 0);
+    static void AddComment(json_string & comment, const json_char * start, const json_char * end);
+    static const json_char * FindEndOfString(const json_char * p, const json_char * end, bool & escaped);
+    static void ParseNode(internalJSONNode * parent, const json_char * & p, const json_char * end, bool trusted, unsigned int depth);
+    static void ParseArray(internalJSONNode * parent, const json_char * & p, const json_char * end, bool trusted, unsigned int depth);
+    static void ParseValue(internalJSONNode * parent, const json_string & name_t, bool nameescaped, const json_char * & p, const json_char * end, bool trusted, unsigned int depth);
 };
 
 #endif
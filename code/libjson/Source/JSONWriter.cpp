@@ -32,7 +32,7 @@ json_string internalJSONNode::WriteName(bool formatted, bool arrayChild) const {
     if (arrayChild) {
         return WRITER_EMPTY ;
     } else {
-        return JSON_TEXT("\"") + JSONWorker::UnfixString(_name, _name_encoded) + ((formatted) ? JSON_TEXT("\" : ") : JSON_TEXT("\":"));
+        return JSON_TEXT("\"") + JSONWorker::UnfixString(_name.str(), _name_encoded) + ((formatted) ? JSON_TEXT("\" : ") : JSON_TEXT("\":"));
     }
 }
 
@@ -118,6 +118,7 @@ json_string internalJSONNode::Write(unsigned int indent, bool arrayChild) {
 
 #ifndef JSON_PREPARSE
     if (!(formatted || fetched)) { //It's not formatted or fetched, just do a raw dump
+        if (type() == JSON_STRING) return WriteComment(indent) + WriteName(false, arrayChild) + JSON_TEXT("\"") + _string + JSON_TEXT("\"");
         return WriteComment(indent) + WriteName(false, arrayChild) + _string;
     }
 #endif
@@ -140,7 +141,7 @@ json_string internalJSONNode::Write(unsigned int indent, bool arrayChild) {
     //If it go here, then it's a json_string
 #ifndef JSON_PREPARSE
     if (fetched) return WriteComment(indent) + WriteName(formatted, arrayChild) + JSON_TEXT("\"") + JSONWorker::UnfixString(_string, _string_encoded) + JSON_TEXT("\"");  //It's already been fetched, meaning that it's unescaped
-    return WriteComment(indent) + WriteName(formatted, arrayChild) + _string;  //it hasn't yet been fetched, so it's already unescaped, just do a dump
+    return WriteComment(indent) + WriteName(formatted, arrayChild) + JSON_TEXT("\"") + _string + JSON_TEXT("\"");  //it hasn't yet been fetched, so it's still escaped, just do a dump
 #else
     return WriteComment(indent) + WriteName(formatted, arrayChild) + JSON_TEXT("\"") + JSONWorker::UnfixString(_string, _string_encoded) + JSON_TEXT("\"");
 #endif
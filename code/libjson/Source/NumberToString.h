@@ -4,6 +4,8 @@
 #include "JSONDebug.h"
 #include "JSONMemory.h"
 #include <cstdio>
+#include <cstdlib>
+#include <limits>
 
 template <unsigned int GETLENSIZE>
 struct getLenSize
@@ -109,10 +111,96 @@ public:
 	   return result;    
     }
     
+    /*
+	   Reads [p, end) as a json integer, returns false if it isn't one, such as when
+	   it has a fraction or an exponent, or if it's too big for a json_int_t
+    */
+    static bool _atoi(const json_char * p, const json_char * end, json_int_t & result){
+	   const bool negative = (p != end) && (*p == JSON_TEXT('-'));
+	   if (negative) ++p;
+	   if (p == end) return false;
+	   json_int_t value = 0;
+	   do {
+		  const int digit = (int)(*p - JSON_TEXT('0'));
+		  if ((digit < 0) || (digit > 9)) return false;
+		  if (value > (std::numeric_limits<json_int_t>::max() - digit) / 10) return false;
+		  value = value * 10 + digit;
+	   } while (++p != end);
+	   result = negative ? -value : value;
+	   return true;
+    }
+    
+    /*
+	   Reads [p, end) as a json number.  When all of its digits fit in a double and
+	   the power of ten is one that a double holds exactly, a single multiply or
+	   divide gives the correctly rounded answer, which is most of the numbers
+	   anyone writes.  Anything else is handed to strtod.
+    */
+    static json_number _atof(const json_char * p, const json_char * end){
+	   static const double powers[] = {
+		  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	   };
+	   const json_char * const start = p;
+	   const bool negative = (p != end) && (*p == JSON_TEXT('-'));
+	   if (negative) ++p;
+	   json_int_t mantissa = 0;
+	   int digits = 0;  //how many significant digits are in mantissa
+	   int exponent = 0;
+	   bool exact = true;  //no digits were left out of mantissa
+	   for(; (p != end) && isDigit(*p); ++p){
+		  if (digits < std::numeric_limits<json_int_t>::digits10){
+			 mantissa = mantissa * 10 + (*p - JSON_TEXT('0'));
+			 if (mantissa) ++digits;
+		  } else {
+			 ++exponent;
+			 if (*p != JSON_TEXT('0')) exact = false;
+		  }
+	   }
+	   if ((p != end) && (*p == JSON_TEXT('.'))){
+		  for(++p; (p != end) && isDigit(*p); ++p){
+			 if (digits < std::numeric_limits<json_int_t>::digits10){
+				mantissa = mantissa * 10 + (*p - JSON_TEXT('0'));
+				if (mantissa) ++digits;
+				--exponent;
+			 } else if (*p != JSON_TEXT('0')){
+				exact = false;
+			 }
+		  }
+	   }
+	   if ((p != end) && ((*p == JSON_TEXT('e')) || (*p == JSON_TEXT('E')))){
+		  bool negativeexponent = false;
+		  if ((++p != end) && ((*p == JSON_TEXT('-')) || (*p == JSON_TEXT('+')))) negativeexponent = (*p++ == JSON_TEXT('-'));
+		  int written = 0;
+		  for(; (p != end) && isDigit(*p); ++p){
+			 if (written < 100000) written = written * 10 + (*p - JSON_TEXT('0'));
+		  }
+		  exponent += negativeexponent ? -written : written;
+	   }
+	   if (exact && (p == end) && ((double)mantissa < 9007199254740992.0) && (exponent >= -22) && (exponent <= 22)){
+		  const double value = (exponent < 0) ? (double)mantissa / powers[-exponent] : (double)mantissa * powers[exponent];
+		  return (json_number)(negative ? -value : value);
+	   }
+	   
+	   //strtod wants a null terminated char string, and the characters of a number are all ascii
+	   const size_t length = end - start;
+	   json_auto<char> temp(length + 1);
+	   for(size_t i = 0; i < length; ++i){
+		  temp.ptr[i] = (char)start[i];
+	   }
+	   temp.ptr[length] = '\0';
+	   return (json_number)strtod(temp.ptr, 0);
+    }
+    
     static inline bool areEqual(const json_number & one, const json_number & two){
+	   if (one == two) return true;  //infinity minus itself isn't zero
 	   const json_number temp = one - two;
 	   return (temp > 0.0) ? temp < 0.00001 : temp > -0.00001;   
     }
+JSON_PRIVATE
+    static inline bool isDigit(json_char ch){
+	   return (ch >= JSON_TEXT('0')) && (ch <= JSON_TEXT('9'));
+    }
 };
 
 #endif
@@ -2,6 +2,7 @@
 #include "NumberToString.h"  //So that I can convert numbers into strings
 #include "JSONNode.h"  //To fill in the foreward declaration
 #include "JSONWorker.h"  //For fetching and parsing and such
+#include "JSONScan.h"  //To see if a string has anything escaped in it
 
 /*
     The point of these constants is for faster assigning, if I
@@ -29,11 +30,14 @@ internalJSONNode::internalJSONNode(const internalJSONNode & orig) :
     #endif
         _type(orig._type),
         _name_encoded(orig._name_encoded),
+        _string_encoded(orig._string_encoded),
+        _integral(orig._integral)
+        initializeIndexed(false)  //a copy isn't in anyone's index
+        initializeValid(orig.isValid)
+        initializeFetch(orig.fetched),
         _name(orig._name),
-        _string(orig._string), _string_encoded(orig._string_encoded), _value(orig._value),
+        _string(orig._string),
         Children()
-        initializeValid(orig.isValid)
-        initializeFetch(orig.fetched)
         initializeMutex()
         initializeComment(orig._comment)
 {
@@ -43,7 +47,9 @@ internalJSONNode::internalJSONNode(const internalJSONNode & orig) :
 #ifdef JSON_MUTEX_CALLBACKS
     _set_mutex(orig.mylock, false);
 #endif
-    if (!orig.Children.empty()) {
+    if (!orig.isContainer()) {
+        _value = orig._value;
+    } else if (!orig.Children.empty()) {
         Children.reserve(orig.Children.size());
         json_foreach(orig.Children, myrunner) {
             Children.push_back(JSONNode::newJSONNode((*myrunner) -> duplicate()));
@@ -63,45 +69,6 @@ internalJSONNode::internalJSONNode(const internalJSONNode & orig) :
 #define NOTVALID
 #endif
 
-//this one is specialized because the root can only be array or node
-internalJSONNode::internalJSONNode(const json_string & unparsed) :
-    #ifdef JSON_REF_COUNT
-        //initializeRefCount(1)
-        refcount(1),
-    #endif
-        _type(),
-        _name_encoded(false),
-        _name(),
-        _string(unparsed),
-        _string_encoded(),
-        _value(),
-        Children()
-        initializeMutex(0)
-        initializeValid()
-        initializeFetch(false)
-        initializeComment()
-{
-
-    incinternalAllocCount();
-    switch (unparsed[0]) {
-    case JSON_TEXT('{'):  //node
-        _type = JSON_NODE;
-#ifdef JSON_PREPARSE
-        FetchNode();
-#endif
-        break;
-    case JSON_TEXT('['):  //array
-        _type = JSON_ARRAY;
-#ifdef JSON_PREPARSE
-        FetchArray();
-#endif
-        break;
-    default:
-        JSON_FAIL_SAFE(JSON_TEXT("root not starting with either { or ["), Nullify(NOTVALID););
-        break;
-    }
-}
-
 internalJSONNode::internalJSONNode(const json_string & name_t, const json_string & value_t) :
     #ifdef JSON_REF_COUNT
         //initializeRefCount(1)
@@ -109,14 +76,15 @@ internalJSONNode::internalJSONNode(const json_string & name_t, const json_string
     #endif
         _type(),
         _name_encoded(),
+        _string_encoded(),
+        _integral()
+        initializeIndexed(false)
+        initializeValid()
+        initializeFetch(),
         _name(JSONWorker::FixString(name_t, NAME_ENCODED)),
         _string(),
-        _string_encoded(),
-        _value(),
         Children()
         initializeMutex(0)
-        initializeValid()
-        initializeFetch()
         initializeComment()
 {
 
@@ -138,21 +106,13 @@ internalJSONNode::internalJSONNode(const json_string & name_t, const json_string
 #endif
 
     switch (firstchar) {
-    case JSON_TEXT('\"'):  //a json_string literal, still escaped and with leading and trailing quotes
-        JSON_ASSERT_SAFE(lastchar == JSON_TEXT('\"'), JSON_TEXT("Unterminated quote"), Nullify(NOTVALID); return;);
-        _type = JSON_STRING;
-        SetFetchedFalseOrDo(FetchString());
-        break;
-    case JSON_TEXT('{'):  //a child node, or set of children
-        JSON_ASSERT_SAFE(lastchar == JSON_TEXT('}'), JSON_TEXT("Missing }"), Nullify(NOTVALID); return;);
-        _type = JSON_NODE;
-        SetFetchedFalseOrDo(FetchNode());
-        break;
-    case JSON_TEXT('['):  //an array
-        JSON_ASSERT_SAFE(lastchar == JSON_TEXT(']'), JSON_TEXT("Missing ]"), Nullify(NOTVALID); return;);
-        _type = JSON_ARRAY;
-        SetFetchedFalseOrDo(FetchArray());
+    case JSON_TEXT('\"'): {  //a json_string literal, still escaped and with leading and trailing quotes
+        JSON_ASSERT_SAFE((value_t.length() > 1) && (lastchar == JSON_TEXT('\"')), JSON_TEXT("Unterminated quote"), Nullify(NOTVALID); return;);
+        const json_char * text = value_t.data() + 1;
+        const json_char * close = value_t.data() + value_t.length() - 1;
+        SetParsedString(text, close, JSONScan::FindBackslash(text, close) != close);
         break;
+    }
     case JSON_TEXT('t'):
         JSON_ASSERT_SAFE(value_t == JSON_TEXT("true"), json_string(json_string(JSON_TEXT("unknown JSON literal: ")) + value_t).c_str(), Nullify(NOTVALID); return;);
         _value._bool = true;
@@ -174,7 +134,7 @@ internalJSONNode::internalJSONNode(const json_string & name_t, const json_string
 #endif
         break;
     default:
-        JSON_ASSERT_SAFE(value_t.find_first_not_of(JSON_TEXT("0123456789.e+-")) == json_string::npos, json_string(json_string(JSON_TEXT("unknown JSON literal: ")) + value_t).c_str(), Nullify(NOTVALID); return;);
+        JSON_ASSERT_SAFE(value_t.find_first_not_of(JSON_TEXT("0123456789.eE+-")) == json_string::npos, json_string(json_string(JSON_TEXT("unknown JSON literal: ")) + value_t).c_str(), Nullify(NOTVALID); return;);
         _type = JSON_NUMBER;
         SetFetchedFalseOrDo(FetchNumber());
         break;
@@ -186,44 +146,19 @@ internalJSONNode::~internalJSONNode(void) {
 #ifdef JSON_MUTEX_CALLBACKS
     _unset_mutex();
 #endif
-    //DO NOT delete the children!  It automatically gets removed
+    if (isContainer()) Children.~jsonChildren();  //it shares its memory with the value, so it isn't destroyed by itself
 }
 
 void internalJSONNode::FetchString(void) const {
-    JSON_ASSERT_SAFE(!_string.empty(), JSON_TEXT("JSON json_string type is empty?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[0] == JSON_TEXT('\"'), JSON_TEXT("JSON json_string type doesn't start with a quotation?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[_string.length() - 1] == JSON_TEXT('\"'), JSON_TEXT("JSON json_string type doesn't end with a quotation?"), Nullify(NOTVALID); return;);
-    _string = JSONWorker::FixString(_string.substr(1, _string.length() - 2), STRING_ENCODED);
-}
-
-void internalJSONNode::FetchNode(void) const {
-    JSON_ASSERT_SAFE(!_string.empty(), JSON_TEXT("JSON node type is empty?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[0] == JSON_TEXT('{'), JSON_TEXT("JSON node type doesn't start with a bracket?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[_string.length() - 1] == JSON_TEXT('}'), JSON_TEXT("JSON node type doesn't end with a bracket?"), Nullify(NOTVALID); return;);
-    JSONWorker::DoNode(this, _string);
-    clearString(_string);
-}
-
-void internalJSONNode::FetchArray(void) const {
-    JSON_ASSERT_SAFE(!_string.empty(), JSON_TEXT("JSON node type is empty?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[0] == JSON_TEXT('['), JSON_TEXT("JSON node type doesn't start with a square bracket?"), Nullify(NOTVALID); return;);
-    JSON_ASSERT_SAFE(_string[_string.length() - 1] == JSON_TEXT(']'), JSON_TEXT("JSON node type doesn't end with a square bracket?"), Nullify(NOTVALID); return;);
-    JSONWorker::DoArray(this, _string);
-    clearString(_string);
+    _string = JSONWorker::FixString(_string, STRING_ENCODED);
 }
 
+//integers are kept as they are, so that as_int doesn't have to go through a double to get them back
 void internalJSONNode::FetchNumber(void) const {
-#ifdef JSON_UNICODE
-    {
-        const size_t len = _string.length();
-        json_auto<char> temp(len + 1);
-        wcstombs(temp.ptr, _string.c_str(), len);
-        temp.ptr[len] = '\0';
-        _value._number = (json_number)atof(temp.ptr);
-    }
-#else
-    _value._number = (json_number)atof(_string.c_str());
-#endif
+    const json_char * start = _string.data();
+    const json_char * end = start + _string.length();
+    _integral = NumberToString::_atoi(start, end, _value._integer);
+    if (!_integral) _value._number = NumberToString::_atof(start, end);
 }
 
 #ifndef JSON_PREPARSE
@@ -233,12 +168,6 @@ void internalJSONNode::Fetch(void) const {
     case JSON_STRING:
         FetchString();
         break;
-    case JSON_NODE:
-        FetchNode();
-        break;
-    case JSON_ARRAY:
-        FetchArray();
-        break;
     case JSON_NUMBER:
         FetchNumber();
         break;
@@ -253,40 +182,94 @@ void internalJSONNode::Fetch(void) const {
 #endif
 
 void internalJSONNode::Set(const json_string & val) {
+    dropChildren();
     _type = JSON_STRING;
     _string = val;
     _string_encoded = true;
     SetFetched(true);
 }
 
+/*
+    Takes the text between a string's quotes as it was written.  If nothing in it
+    was escaped then it's already the value, otherwise it's kept escaped until
+    something asks for it.
+*/
+void internalJSONNode::SetParsedString(const json_char * start, const json_char * end, bool escaped) {
+    _type = JSON_STRING;
+    _string.assign(start, end - start);
+    _string_encoded = escaped;
+    if (escaped) {
+        SetFetchedFalseOrDo(FetchString());
+    } else {
+        SetFetched(true);
+    }
+}
+
+/*
+    Takes a number, true, false or null from json that's trusted to be valid, so
+    it's told apart by its first character alone instead of being checked the way
+    the constructor does.  Nothing at all is a null, as it is there.
+*/
+void internalJSONNode::SetTrustedLiteral(const json_char * start, const json_char * end) {
+    _string.assign(start, end - start);
+    switch ((start == end) ? JSON_TEXT('n') : *start) {
+    case JSON_TEXT('t'):
+        _value._bool = true;
+        _type = JSON_BOOL;
+        SetFetched(true);
+        break;
+    case JSON_TEXT('f'):
+        _value._bool = false;
+        _type = JSON_BOOL;
+        SetFetched(true);
+        break;
+    case JSON_TEXT('n'):
+        _type = JSON_NULL;
+        SetFetched(true);
+        break;
+    default:
+        _type = JSON_NUMBER;
+        SetFetchedFalseOrDo(FetchNumber());
+        break;
+    }
+}
+
 
 #ifdef JSON_LIBRARY
 void internalJSONNode::Set(long val) {
+    dropChildren();
     _type = JSON_NUMBER;
     _value._number = (json_number)val;
+    _integral = false;
     _string = NumberToString::_itoa<long>(val);
     SetFetched(true);
 }
 
 void internalJSONNode::Set(json_number val) {
+    dropChildren();
     _type = JSON_NUMBER;
     _value._number = val;
+    _integral = false;
     _string = NumberToString::_ftoa<json_number>(val);
     SetFetched(true);
 }
 #else
 #define SET(converter, type)\
 	   void internalJSONNode::Set(type val){\
+		  dropChildren();\
 		  _type = JSON_NUMBER;\
 		  _value._number = (json_number)val;\
+		  _integral = false;\
 		  _string = NumberToString::converter<type>(val);\
 		  SetFetched(true);\
 	   }
 #define SET_INTEGER(type) SET(_itoa, type) SET(_uitoa, unsigned type)
 #define SET_FLOAT(type) \
 	   void internalJSONNode::Set(type val){\
+		  dropChildren();\
 		  _type = JSON_NUMBER;\
 		  _value._number = (json_number)val;\
+		  _integral = false;\
 		  _string = NumberToString::_ftoa<type>(val);\
 		  SetFetched(true);\
 	   }
@@ -304,6 +287,7 @@ SET_FLOAT(double)
 #endif
 
 void internalJSONNode::Set(bool val) {
+    dropChildren();
     _type = JSON_BOOL;
     _value._bool = val;
     _string = val ? CONST_TRUE : CONST_FALSE;
@@ -325,7 +309,7 @@ bool internalJSONNode::IsEqualTo(const internalJSONNode * val) const {
     case JSON_STRING:
         return val -> _string == _string;
     case JSON_NUMBER:
-        return NumberToString::areEqual(val -> _value._number, _value._number);
+        return NumberToString::areEqual(val -> as_float(), as_float());
     case JSON_BOOL:
         return val -> _value._bool == _value._bool;
     };
@@ -351,6 +335,7 @@ void internalJSONNode::Nullify(bool validation) const {
 #else
 void internalJSONNode::Nullify(void) const {
 #endif
+    dropChildren();
     _type = JSON_NULL;
     _string = CONST_NULL;
     SetFetched(true);
@@ -367,19 +352,20 @@ void internalJSONNode::push_back(JSONNode * node) {
 #else
 void internalJSONNode::push_back(const JSONNode & node) {
 #endif
-    JSON_ASSERT(type() == JSON_ARRAY || type() == JSON_NODE, JSON_TEXT("pushing back to something that is not an array or object"));
 #ifdef JSON_LIBRARY
+    JSON_ASSERT_SAFE(isContainer(), JSON_TEXT("pushing back to something that is not an array or object"), JSONNode::deleteJSONNode(node); return;);
 #ifdef JSON_MUTEX_CALLBACKS
     if (mylock) node -> set_mutex(mylock);
 #endif
     Children.push_back(node);
 #else
+    JSON_ASSERT_SAFE(isContainer(), JSON_TEXT("pushing back to something that is not an array or object"), return;);
     Children.push_back(JSONNode::newJSONNode(node   JSON_MUTEX_COPY));
 #endif
 }
 
 void internalJSONNode::push_front(const JSONNode & node) {
-    JSON_ASSERT(type() == JSON_ARRAY || type() == JSON_NODE, JSON_TEXT("pushing front to something that is not an array or object"));
+    JSON_ASSERT_SAFE(isContainer(), JSON_TEXT("pushing front to something that is not an array or object"), return;);
     Children.push_front(JSONNode::newJSONNode(node   JSON_MUTEX_COPY));
 }
 
@@ -411,12 +397,17 @@ JSONNode * internalJSONNode::pop_back_nocase(const json_string & name_t) {
 #endif
 
 JSONNode ** internalJSONNode::at(const json_string & name_t) {
+    if (!isContainer()) return 0;
     Fetch();
+#ifdef JSON_INDEX_KEYS
+    return Children.find(name_t);
+#else
     json_foreach(Children, myrunner) {
         JSON_ASSERT(*myrunner, JSON_TEXT("a null pointer within the children"));
-        if ((*myrunner) -> name() == name_t) return myrunner;
+        if ((*myrunner) -> internal -> _name == name_t) return myrunner;
     }
     return 0;
+#endif
 }
 
 #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
@@ -441,26 +432,50 @@ bool internalJSONNode::AreEqualNoCase(const json_char * ch_one, const json_char
 }
 
 JSONNode ** internalJSONNode::at_nocase(const json_string & name_t) {
+    if (!isContainer()) return 0;
     Fetch();
+#ifdef JSON_INDEX_KEYS
+    return Children.find_nocase(name_t);
+#else
     json_foreach(Children, myrunner) {
         JSON_ASSERT(*myrunner, JSON_TEXT("a null pointer within the children"));
-        if (AreEqualNoCase((*myrunner) -> name().c_str(), name_t.c_str())) return myrunner;
+        if (AreEqualNoCase((*myrunner) -> internal -> _name.c_str(), name_t.c_str())) return myrunner;
     }
     return 0;
+#endif
 }
 #endif
 
 #ifndef JSON_PREPARSE
 void internalJSONNode::preparse(void) {
     Fetch();
+    if (!isContainer()) return;
     json_foreach(Children, myrunner) {
         (*myrunner) -> preparse();
     }
 }
 #endif
 
+#ifdef JSON_ATOMIC_REF_COUNT
+/*
+    Everything that reading a node can change is done here instead: the json is
+    fetched, and the key indexes are built and kept even when something else in
+    the program is renamed.  A frozen node that is changed through a copy is
+    copied first, and one that only has one reference is thawed by makeUnique.
+*/
+void internalJSONNode::freeze(void) {
+    Fetch();
+    if (!isContainer()) return;
+    json_foreach(Children, myrunner) {
+        (*myrunner) -> internal -> freeze();
+    }
+    Children.freeze();
+}
+#endif
+
 #ifdef JSON_VALIDATE
 bool internalJSONNode::validate(void) {
+    if (!isContainer()) return true;
     json_foreach(Children, myrunner) {
         if ((*myrunner) -> type() != JSON_NULL) {
 #ifndef JSON_PREPARSE
@@ -468,7 +483,7 @@ bool internalJSONNode::validate(void) {
 #endif
             if ((*myrunner) -> type() == JSON_NULL) return false;
         } else if (!((*myrunner) -> internal -> isValid)) {
-            JSON_FAIL(_name + JSON_TEXT(" is null and not valid"));
+            JSON_FAIL(_name.str() + JSON_TEXT(" is null and not valid"));
             return false;
         }
     }
@@ -486,10 +501,12 @@ JSONNode internalJSONNode::Dump(size_t & totalbytes) const {
     dumpage.set_name(JSON_TEXT("internalJSONNode"));
     dumpage.push_back(JSON_NEW(JSONNode(JSON_TEXT("this"), (long)this)));
 
+    //only a container's children are real, anything else has its value there instead
+    const json_index_t capacity = isContainer() ? Children.capacity() : 0;
     size_t memory = sizeof(internalJSONNode);
     memory += _name.capacity() * sizeof(json_char);
     memory += _string.capacity() * sizeof(json_char);
-    memory += Children.capacity() * sizeof(JSONNode*);
+    memory += capacity * sizeof(JSONNode*);
 #ifdef JSON_COMMENTS
     memory += _comment.capacity() * sizeof(json_char);
 #endif
@@ -498,7 +515,7 @@ JSONNode internalJSONNode::Dump(size_t & totalbytes) const {
 
 
 #ifdef JSON_REF_COUNT
-    dumpage.push_back(JSON_NEW(JSONNode(JSON_TEXT("refcount"), refcount)));
+    dumpage.push_back(JSON_NEW(JSONNode(JSON_TEXT("refcount"), (unsigned int)refcount)));
 #endif
 #ifdef JSON_MUTEX_CALLBACKS
     dumpage.push_back(JSON_NEW(DumpMutex()));
@@ -523,7 +540,7 @@ JSONNode internalJSONNode::Dump(size_t & totalbytes) const {
 
     JSONNode str(JSON_NODE);
     str.set_name(JSON_TEXT("_name"));
-    str.push_back(JSON_NEW(JSONNode(json_string(JSON_TEXT("value")), _name)));
+    str.push_back(JSON_NEW(JSONNode(json_string(JSON_TEXT("value")), _name.str())));
     str.push_back(JSON_NEW(JSONNode(JSON_TEXT("length"), _name.length())));
     str.push_back(JSON_NEW(JSONNode(JSON_TEXT("capactiy"), _name.capacity())));
 
@@ -562,11 +579,11 @@ JSONNode internalJSONNode::Dump(size_t & totalbytes) const {
 
     JSONNode arra(JSON_NODE);
     arra.set_name(JSON_TEXT("Children"));
-    arra.push_back(JSON_NEW(JSONNode(JSON_TEXT("size"), Children.size())));
-    arra.push_back(JSON_NEW(JSONNode(JSON_TEXT("capacity"), Children.capacity())));
+    arra.push_back(JSON_NEW(JSONNode(JSON_TEXT("size"), size())));
+    arra.push_back(JSON_NEW(JSONNode(JSON_TEXT("capacity"), capacity)));
     JSONNode chil(JSON_ARRAY);
     chil.set_name(JSON_TEXT("array"));
-    json_foreach(Children, it) {
+    for (JSONNode ** it = begin(), ** stop = end(); it != stop; ++it) {
         chil.push_back(JSON_NEW((*it) -> dump(totalbytes)));
     }
     arra.push_back(JSON_NEW(chil));
@@ -3,9 +3,13 @@
 
 #include "JSONDebug.h"
 #include "JSONChildren.h"
+#include "JSONName.h"
 #include "JSONMemory.h"
 #ifdef JSON_DEBUG
-    #include <climits>  //to check int value
+    #include <limits>  //to check int value
+#endif
+#ifdef JSON_ATOMIC_REF_COUNT
+    #include <atomic>
 #endif
 
 /*
@@ -62,17 +66,21 @@ class JSONNode;  //forward declaration
     #define initializeValid(x)
 #endif
 
+#ifdef JSON_INDEX_KEYS
+    #define initializeIndexed(x) ,_indexed(x)
+#else
+    #define initializeIndexed(x)
+#endif
+
 class internalJSONNode {
 public:
     internalJSONNode(char mytype = JSON_NULL);
-    internalJSONNode(const json_string & unparsed);
     internalJSONNode(const json_string & name_t, const json_string & value_t);
     internalJSONNode(const internalJSONNode & orig);  
     internalJSONNode & operator = (const internalJSONNode &);
     ~internalJSONNode(void);
     
     static internalJSONNode * newInternal(char mytype = JSON_NULL);
-    static internalJSONNode * newInternal(const json_string & unparsed);
     static internalJSONNode * newInternal(const json_string & name_t, const json_string & value_t);
     static internalJSONNode * newInternal(const internalJSONNode & orig);  //not copyable, only by this class
     static void deleteInternal(internalJSONNode * ptr);
@@ -87,14 +95,17 @@ public:
 	   void setcomment(const json_string & comment);
 	   json_string getcomment(void) const;
     #endif
-    json_string as_string(void) const;
-    long as_int(void) const;
+    const json_string & as_string(void) const;
+    json_int_t as_int(void) const;
     json_number as_float(void) const;
     bool as_bool(void) const;
  
     #ifndef JSON_PREPARSE
 	   void preparse(void);
     #endif
+    #ifdef JSON_ATOMIC_REF_COUNT
+	   void freeze(void);
+    #endif
     
     #ifdef JSON_LIBRARY
 	   void push_back(JSONNode * node);
@@ -117,6 +128,8 @@ public:
     #endif
     
     void Set(const json_string & val);
+    void SetParsedString(const json_char * start, const json_char * end, bool escaped);
+    void SetTrustedLiteral(const json_char * start, const json_char * end);
     #ifdef JSON_LIBRARY
 	   void Set(json_number val);
 	   void Set(long val);
@@ -143,15 +156,18 @@ public:
 
     internalJSONNode * incRef(void);
     #ifdef JSON_REF_COUNT
-	   void decRef(void);
-	   bool hasNoReferences(void);
+	   bool decRef(void);  //true if that was the last reference
     #endif
     internalJSONNode * makeUnique(void);
     
     JSONNode ** begin(void) const;
     JSONNode ** end(void) const;
     #ifdef JSON_REF_COUNT
-	   size_t refcount BITS(20);
+	   #ifdef JSON_ATOMIC_REF_COUNT
+		  std::atomic<unsigned int> refcount;
+	   #else
+		  size_t refcount BITS(20);
+	   #endif
     #endif
     bool Fetched(void) const;
     #ifdef JSON_MUTEX_CALLBACKS
@@ -178,24 +194,46 @@ public:
     #endif
     
     //json parts
+    //the flags are all together, and always packed into bits, so that they fit in the word the reference count is in
     mutable unsigned char _type BITS(3);
-    mutable bool _name_encoded BITS(1);  //must be above name due to initialization list order
-    json_string _name;	
+    mutable bool _name_encoded : 1;  //must be above name due to initialization list order
+    mutable bool _string_encoded : 1;  //for a string that hasn't been fetched, whether it still has escapes in it
+    mutable bool _integral : 1;  //the number was written as an integer, and is held in _value._integer
+    #ifdef JSON_INDEX_KEYS
+	   mutable bool _indexed : 1;  //has been put in a parent's key index, so renaming it has to tell them
+    #endif
+    #ifdef JSON_VALIDATE
+	   mutable bool isValid : 1;  //this does not need to be initialized, it's only used if it's null
+    #endif
+    #ifndef JSON_PREPARSE
+	   mutable bool fetched : 1;
+    #endif
+
+    jsonName _name;
     
-    mutable json_string _string;   //these are both mutable because the string can change when it's fetched
-    mutable bool _string_encoded BITS(1);
+    mutable json_string _string;   //mutable because the string can change when it's fetched
     
     //the value of the json
     union value_union_t {
 	   bool _bool;
 	   json_number _number;
+	   json_int_t _integer;
     };
-    mutable value_union_t _value; //internal structure changes depending on type
-    
-    jsonChildren Children;  //container that holds all of my children
+    /*
+	   Only a string, number, bool or null has a value and only an array or node has
+	   children, so they share their memory.  Children is what the constructors
+	   initialize, as an empty one is all zeros, and it has to be emptied before a
+	   container becomes anything else, which is what dropChildren is for.  Nothing
+	   that isn't a container may look at Children.
+    */
+    union {
+	   mutable value_union_t _value; //internal structure changes depending on type
+	   jsonChildren Children;  //container that holds all of my children
+    };
+    bool isContainer(void) const;
+    void dropChildren(void) const;
     
     #ifdef JSON_VALIDATE
-	   mutable bool isValid BITS(1);  //this does not need to be initialized, it's only used if it's null
 	   void Nullify(bool validation = true) const;
 	   bool validate(void);
     #else
@@ -204,7 +242,6 @@ public:
     
     //Fetching and such
     #ifndef JSON_PREPARSE
-	   mutable bool fetched BITS(1);
 	   void SetFetched(bool val) const;
 	   void Fetch(void) const;  //it's const because it doesn't change the VALUE of the function
     #endif
@@ -214,8 +251,6 @@ public:
     #endif
 	   
     void FetchString(void) const;
-    void FetchNode(void) const;
-    void FetchArray(void) const;
     void FetchNumber(void) const;
     #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
 	   static bool AreEqualNoCase(const json_char * ch_one, const json_char * ch_two);
@@ -229,14 +264,16 @@ inline internalJSONNode::internalJSONNode(char mytype) :
   #endif
     initializeMutex(0)
     , _type(mytype)
-    , _name_encoded(), _name()
-    , _string()
+    , _name_encoded()
     , _string_encoded()
-    , _value()
-    , Children()
-    initializeComment()
+    , _integral()
+    initializeIndexed(false)
     initializeValid(true)
     initializeFetch(true)
+    , _name()
+    , _string()
+    , Children()
+    initializeComment()
 {
 	   
     incinternalAllocCount();
@@ -244,7 +281,11 @@ inline internalJSONNode::internalJSONNode(char mytype) :
 
 inline internalJSONNode * internalJSONNode::incRef(void){
     #ifdef JSON_REF_COUNT
-	   ++refcount;
+	   #ifdef JSON_ATOMIC_REF_COUNT
+		  refcount.fetch_add(1, std::memory_order_relaxed);  //whoever is copying it already has a reference, so nothing else needs ordering
+	   #else
+		  ++refcount;
+	   #endif
 	   return this;
     #else
 	   return makeUnique();
@@ -252,16 +293,28 @@ inline internalJSONNode * internalJSONNode::incRef(void){
 }
 
 inline json_index_t internalJSONNode::size(void) const {
+    if (!isContainer()) return 0;
     Fetch();
     return Children.size();
 }
 
 inline bool internalJSONNode::empty(void) const {
-    if (type() != JSON_NODE && type() != JSON_ARRAY) return true;
+    if (!isContainer()) return true;
     Fetch();
     return Children.empty();
 }
 
+inline bool internalJSONNode::isContainer(void) const {
+    return (type() == JSON_NODE) || (type() == JSON_ARRAY);
+}
+
+inline void internalJSONNode::dropChildren(void) const {
+    if (!isContainer()) return;
+    jsonChildren & children = const_cast<jsonChildren &>(Children);  //Nullify is const
+    children.clear();
+    children.shrink();  //so that the value it leaves behind is all zeros
+}
+
 inline unsigned char internalJSONNode::type(void) const {
     #ifdef JSON_LESS_MEMORY
 	   return _type & 0xF;
@@ -271,10 +324,13 @@ inline unsigned char internalJSONNode::type(void) const {
 }
 
 inline json_string internalJSONNode::name(void) const {
-    return _name;
+    return _name.str();
 }
 
 inline void internalJSONNode::setname(const json_string & newname){
+    #ifdef JSON_INDEX_KEYS
+	   if (_indexed) jsonChildren::renamed();
+    #endif
     _name = newname;
     #ifdef JSON_LESS_MEMORY
 	   _type |= 0x10;
@@ -293,12 +349,12 @@ inline void internalJSONNode::setname(const json_string & newname){
     }
 #endif
 
-inline json_string internalJSONNode::as_string(void) const {
+inline const json_string & internalJSONNode::as_string(void) const {
     Fetch();
     return _string;
 }
 
-inline long internalJSONNode::as_int(void) const {
+inline json_int_t internalJSONNode::as_int(void) const {
     Fetch();
     switch(type()){
 	   case JSON_NULL:
@@ -307,10 +363,11 @@ inline long internalJSONNode::as_int(void) const {
 		  return _value._bool ? 1 : 0;
     }
     JSON_ASSERT(type() == JSON_NUMBER, JSON_TEXT("as_int returning undefined results"));
-    JSON_ASSERT(_value._number > LONG_MIN, _string + JSON_TEXT(" is outside the lower range of long"));
-    JSON_ASSERT(_value._number < LONG_MAX, _string + JSON_TEXT(" is outside the upper range of long"));
-    JSON_ASSERT(_value._number == (json_number)((int)_value._number), json_string(JSON_TEXT("as_int will truncate ")) + _string);
-    return (int)_value._number;
+    if (_integral) return _value._integer;
+    JSON_ASSERT(_value._number > (json_number)std::numeric_limits<json_int_t>::min(), _string + JSON_TEXT(" is outside the lower range of json_int_t"));
+    JSON_ASSERT(_value._number < (json_number)std::numeric_limits<json_int_t>::max(), _string + JSON_TEXT(" is outside the upper range of json_int_t"));
+    JSON_ASSERT(_value._number == (json_number)((json_int_t)_value._number), json_string(JSON_TEXT("as_int will truncate ")) + _string);
+    return (json_int_t)_value._number;
 }
 
 inline json_number internalJSONNode::as_float(void) const {
@@ -322,6 +379,7 @@ inline json_number internalJSONNode::as_float(void) const {
 		  return (json_number)(_value._bool ? 1.0 : 0.0);
     }
     JSON_ASSERT(type() == JSON_NUMBER, JSON_TEXT("as_float returning undefined results"));
+    if (_integral) return (json_number)_value._integer;
     return _value._number;   
 }
 
@@ -329,7 +387,7 @@ inline bool internalJSONNode::as_bool(void) const {
     Fetch();
     switch(type()){
 	   case JSON_NUMBER:
-		  return _value._number != 0.0f;
+		  return _integral ? (_value._integer != 0) : (_value._number != 0.0f);
 	   case JSON_NULL:
 		  return false;
     }
@@ -352,28 +410,33 @@ inline bool internalJSONNode::IsEqualTo(bool val) const {
 template<typename T>
 inline bool internalJSONNode::IsEqualToNum(T val) const {
     if (type() != JSON_NUMBER) return false;
-    Fetch(); 
-    return (json_number)val == _value._number;
+    return (json_number)val == as_float();
 }
 
 #ifdef JSON_REF_COUNT
-    inline void internalJSONNode::decRef(void){
+    inline bool internalJSONNode::decRef(void){
 	   JSON_ASSERT(refcount != 0, JSON_TEXT("decRef on a 0 refcount internal"));
-	   --refcount;
-    }
-
-    inline bool internalJSONNode::hasNoReferences(void){
-	   return refcount == 0;
+	   #ifdef JSON_ATOMIC_REF_COUNT
+		  //the thread that lets go of the last one has to see everything the others did before deleting it
+		  return refcount.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	   #else
+		  return --refcount == 0;
+	   #endif
     }
 #endif
 
 inline internalJSONNode * internalJSONNode::makeUnique(void){
     #ifdef JSON_REF_COUNT
 	   if (refcount > 1){
-		  decRef();
-		  return newInternal(*this);
+		  //copied before letting go, because the others might all let go of it in between
+		  internalJSONNode * copy = newInternal(*this);
+		  if (decRef()) deleteInternal(this);
+		  return copy;
 	   }
 	   JSON_ASSERT(refcount == 1, JSON_TEXT("makeUnique on a 0 refcount internal"));
+	   #ifdef JSON_ATOMIC_REF_COUNT
+		  if (isContainer()) Children.thaw();  //it's about to be changed, and nobody else can be reading it
+	   #endif
 	   return this;
     #else
 	   return newInternal(*this);
@@ -395,11 +458,13 @@ inline bool internalJSONNode::Fetched(void) const {
 }
 
 inline JSONNode ** internalJSONNode::begin(void) const {
+    if (!isContainer()) return 0;
     Fetch();
     return Children.begin();
 }
 
 inline JSONNode ** internalJSONNode::end(void) const {
+    if (!isContainer()) return 0;
     Fetch();
     return Children.end();
 }
@@ -410,6 +475,7 @@ inline JSONNode * internalJSONNode::at(json_index_t pos){
 }
 
 inline void internalJSONNode::reserve(json_index_t size){
+    JSON_ASSERT_SAFE(isContainer(), JSON_TEXT("reserving children in something that is not an array or object"), return;);
     Fetch();
     Children.reserve2(size);
 }
@@ -435,14 +501,6 @@ inline internalJSONNode * internalJSONNode::newInternal(char mytype){
     #endif
 }
 
-inline internalJSONNode * internalJSONNode::newInternal(const json_string & unparsed){
-    #ifdef JSON_MEMORY_CALLBACKS
-	   return new(json_malloc<internalJSONNode>(1)) internalJSONNode(unparsed);
-    #else
-	   return new internalJSONNode(unparsed);
-    #endif   
-}
-
 inline internalJSONNode * internalJSONNode::newInternal(const json_string & name_t, const json_string & value_t){
     #ifdef JSON_MEMORY_CALLBACKS
 	   return new(json_malloc<internalJSONNode>(1)) internalJSONNode(name_t, value_t);
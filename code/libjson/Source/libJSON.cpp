@@ -258,7 +258,7 @@
 
     long json_as_int(const JSONNODE * node){
 	   JSON_ASSERT_SAFE(node, JSON_TEXT("null node to json_as_int"), return 0;);
-	   return ((JSONNode*)node) -> as_int();
+	   return (long)((JSONNode*)node) -> as_int();
     }
 
     json_number json_as_float(const JSONNODE * node){
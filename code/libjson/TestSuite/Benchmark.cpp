@@ -0,0 +1,430 @@
+/*
+    Measures how fast libjson parses and writes json that looks like what the
+    F-Chat server sends: a big LIS, a busy channel's ICH, a CHA with lots of
+    channels, a long BBCode MSG and strings full of escapes.  The corpora are
+    generated from a fixed seed, so every run measures the same bytes.
+
+    Each result is written to stdout as one json object per line, so a run can
+    be saved and used as the baseline for the next one:
+
+	   ./benchapp > baseline.json
+	   ./benchapp --compare baseline.json
+
+    --compare still writes the new results to stdout, and writes how each one
+    changed to stderr.  --time sets roughly how many seconds each case is run
+    for, the default is 0.5.
+*/
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <map>
+#include <new>
+#include <sys/resource.h>
+#include "../libJSON.h"
+
+#if defined(JSON_LIBRARY) || defined(JSON_UNICODE) || !defined(JSON_WRITER) || !defined(JSON_MEMORY_CALLBACKS)
+    #error The benchmark needs the C++ interface, JSON_WRITER and JSON_MEMORY_CALLBACKS, and does not support JSON_UNICODE
+#endif
+
+/*
+    Memory is counted in two places.  What libjson allocates itself, the nodes,
+    their child arrays and long names, goes through the memory callbacks.  A
+    json_string is a std::string, so the text of values and everything write()
+    builds goes through operator new, which is replaced below.  Every block has
+    its size stored in front of it so that the bytes in use can be followed as
+    well as the count, and the total in use is kept as well as each side's.
+*/
+struct Counter {
+    size_t allocations;
+    size_t allocatedbytes;
+    size_t livebytes;
+    size_t peakbytes;
+};
+static Counter nodes = { 0, 0, 0, 0 };    //through libjson's memory callbacks
+static Counter strings = { 0, 0, 0, 0 };  //through operator new, which is mostly json_string
+static Counter total = { 0, 0, 0, 0 };
+
+static const size_t header = 16;  //keeps the memory that's handed back aligned
+
+static void Count(Counter & counter, size_t old, size_t size) {
+    ++counter.allocations;
+    counter.allocatedbytes += size;
+    counter.livebytes = counter.livebytes - old + size;
+    if (counter.livebytes > counter.peakbytes) counter.peakbytes = counter.livebytes;
+}
+
+static void * CountedMalloc(Counter & counter, size_t size) {
+    char * block = (char *)malloc(size + header);
+    if (!block) return 0;
+    *(size_t *)block = size;
+    Count(counter, 0, size);
+    Count(total, 0, size);
+    return block + header;
+}
+
+static void * CountedRealloc(Counter & counter, void * ptr, size_t size) {
+    if (!ptr) return CountedMalloc(counter, size);
+    char * block = (char *)ptr - header;
+    const size_t old = *(size_t *)block;
+    block = (char *)realloc(block, size + header);
+    if (!block) return 0;
+    *(size_t *)block = size;
+    Count(counter, old, size);
+    Count(total, old, size);
+    return block + header;
+}
+
+static void CountedFree(Counter & counter, void * ptr) {
+    if (!ptr) return;
+    char * block = (char *)ptr - header;
+    counter.livebytes -= *(size_t *)block;
+    total.livebytes -= *(size_t *)block;
+    free(block);
+}
+
+static void * CountingMalloc(size_t size) { return CountedMalloc(nodes, size); }
+static void * CountingRealloc(void * ptr, size_t size) { return CountedRealloc(nodes, ptr, size); }
+static void CountingFree(void * ptr) { CountedFree(nodes, ptr); }
+
+void * operator new(size_t size) {
+    if (void * result = CountedMalloc(strings, size)) return result;
+    throw std::bad_alloc();
+}
+void * operator new[](size_t size) { return operator new(size); }
+void * operator new(size_t size, const std::nothrow_t &) noexcept { return CountedMalloc(strings, size); }
+void * operator new[](size_t size, const std::nothrow_t &) noexcept { return CountedMalloc(strings, size); }
+void operator delete(void * ptr) noexcept { CountedFree(strings, ptr); }
+void operator delete[](void * ptr) noexcept { CountedFree(strings, ptr); }
+void operator delete(void * ptr, size_t) noexcept { CountedFree(strings, ptr); }
+void operator delete[](void * ptr, size_t) noexcept { CountedFree(strings, ptr); }
+void operator delete(void * ptr, const std::nothrow_t &) noexcept { CountedFree(strings, ptr); }
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept { CountedFree(strings, ptr); }
+
+//xorshift, so that the corpora are the same on every platform
+class Random {
+public:
+    Random(unsigned int seed) : state(seed) {}
+    unsigned int next(void){
+	   state ^= state << 13;
+	   state ^= state >> 17;
+	   state ^= state << 5;
+	   return state;
+    }
+    unsigned int below(unsigned int limit){ return next() % limit; }
+    const char * pick(const char * const * list, unsigned int count){ return list[below(count)]; }
+private:
+    unsigned int state;
+};
+
+static const char * const syllables[] = { "ka", "ri", "vo", "na", "el", "th", "mor", "syl", "ven", "dra", "lu", "xi", "ash", "bel", "qu", "ry" };
+static const char * const genders[] = { "Male", "Female", "Transgender", "Herm", "Shemale", "Male-Herm", "Cunt-boy", "None" };
+static const char * const statuses[] = { "online", "looking", "busy", "dnd", "idle", "away", "crown" };
+static const char * const words[] = { "the", "a", "tavern", "sword", "quietly", "smiles", "at", "you", "and", "with", "dragon", "looking", "for", "long", "term", "story", "scene", "plot", "characters", "welcome" };
+
+static json_string Name(Random & random) {
+    json_string name;
+    for (unsigned int parts = 2 + random.below(3); parts; --parts) {
+	   name += random.pick(syllables, 16);
+    }
+    name[0] = (json_char)(name[0] - 32);
+    if (random.below(4) == 0) {
+	   name += ' ';
+	   name += random.pick(syllables, 16);
+	   name += random.pick(syllables, 16);
+    }
+    return name;
+}
+
+static json_string Sentence(Random & random, unsigned int length) {
+    json_string sentence;
+    while (length--) {
+	   if (!sentence.empty()) sentence += ' ';
+	   sentence += random.pick(words, 20);
+    }
+    return sentence;
+}
+
+//they are all written with JSONStreamWriter, so the writer has to be right for the rest to mean anything
+
+static json_string MakeLIS(Random & random) {
+    JSONStreamWriter out;
+    out.start_node().key("characters").start_array();
+    for (int i = 0; i < 10000; ++i) {
+	   out.start_array();
+	   out.string(Name(random)).string(random.pick(genders, 8)).string(random.pick(statuses, 7));
+	   out.string(random.below(3) ? json_string() : Sentence(random, 3 + random.below(12)));
+	   out.end_array();
+    }
+    out.end_array().end_node();
+    return out.str();
+}
+
+static json_string MakeICH(Random & random) {
+    JSONStreamWriter out;
+    out.start_node().key("users").start_array();
+    for (int i = 0; i < 2000; ++i) {
+	   out.start_node().key("identity").string(Name(random)).end_node();
+    }
+    out.end_array();
+    out.key("channel").string("ADH-0123456789abcdef0123");
+    out.key("mode").string("both");
+    out.end_node();
+    return out.str();
+}
+
+static json_string MakeCHA(Random & random) {
+    JSONStreamWriter out;
+    out.start_node().key("channels").start_array();
+    for (int i = 0; i < 1000; ++i) {
+	   out.start_node();
+	   out.key("name").string(Sentence(random, 1 + random.below(3)));
+	   out.key("mode").string(random.below(4) ? "both" : "ads");
+	   out.key("characters").number((long)random.below(400));
+	   out.end_node();
+    }
+    out.end_array().end_node();
+    return out.str();
+}
+
+static json_string MakeMSG(Random & random) {
+    json_string message;
+    while (message.length() < 4000) {
+	   switch (random.below(8)) {
+		  case 0: message += "[b]" + Sentence(random, 3) + "[/b] "; break;
+		  case 1: message += "[i]" + Sentence(random, 5) + "[/i] "; break;
+		  case 2: message += "[color=red]" + Sentence(random, 4) + "[/color] "; break;
+		  case 3: message += "[url=https://www.f-list.net/c/" + Name(random) + "]" + Sentence(random, 2) + "[/url] "; break;
+		  case 4: message += "[icon]" + Name(random) + "[/icon] "; break;
+		  case 5: message += "\"" + Sentence(random, 6) + "\" "; break;
+		  case 6: message += "caf\xC3\xA9 \xE2\x80\xA6 "; break;
+		  default: message += Sentence(random, 8) + ".\n"; break;
+	   }
+    }
+    JSONStreamWriter out;
+    out.start_node().key("character").string(Name(random)).key("message").string(message).key("channel").string("Frontpage").end_node();
+    return out.str();
+}
+
+//written by hand rather than with the writer, so that it has \u escapes in it too
+static json_string MakeEscaped(Random & random) {
+    static const char * const escapes[] = { "\\\"", "\\\\", "\\n", "\\t", "\\/", "\\u00e9", "\\u2026", "\\r\\n" };
+    json_string json("[");
+    for (int i = 0; i < 2000; ++i) {
+	   if (i) json += ',';
+	   json += '\"';
+	   for (unsigned int pieces = 4 + random.below(12); pieces; --pieces) {
+		  json += random.pick(words, 20);
+		  json += random.pick(escapes, 8);
+	   }
+	   json += '\"';
+    }
+    json += ']';
+    return json;
+}
+
+//a handler that does nothing, so that only the parser is measured
+class NullHandler : public JSONSaxHandler {};
+
+//writes a whole tree with JSONStreamWriter, the way a caller that already has nodes would
+static void Stream(JSONStreamWriter & out, const JSONNode & node, bool named) {
+    if (named) out.key(node.name());
+    switch (node.type()) {
+	   case JSON_NODE:
+	   case JSON_ARRAY: {
+		  const bool isnode = node.type() == JSON_NODE;
+		  if (isnode) out.start_node(); else out.start_array();
+		  for (json_index_t i = 0, size = node.size(); i < size; ++i) {
+			 Stream(out, node[i], isnode);
+		  }
+		  if (isnode) out.end_node(); else out.end_array();
+		  break;
+	   }
+	   case JSON_STRING:
+		  out.string(node.as_string());
+		  break;
+	   case JSON_NUMBER:
+		  out.number(node.as_float());
+		  break;
+	   case JSON_BOOL:
+		  out.boolean(node.as_bool());
+		  break;
+	   default:
+		  out.null();
+		  break;
+    }
+}
+
+struct Result {
+    size_t iterations;
+    double seconds;
+    size_t allocations;  //per iteration, both kinds
+    size_t allocatedbytes;  //per iteration, both kinds
+    size_t nodebytes;  //per iteration, through libjson's callbacks
+    size_t stringbytes;  //per iteration, through operator new
+    //the most in use at once during one iteration, above what was in use before it
+    size_t peakbytes;
+    size_t nodepeakbytes;
+    size_t stringpeakbytes;
+};
+
+static volatile size_t sink = 0;  //so that the optimizer can't throw the work away
+
+//runs the case once to warm up, once more to measure its memory, then for about mintime seconds
+template <typename Case>
+static Result Measure(double mintime, Case run) {
+    Result result;
+    run();
+
+    const Counter nodesbefore = nodes, stringsbefore = strings, totalbefore = total;
+    nodes.peakbytes = nodes.livebytes;
+    strings.peakbytes = strings.livebytes;
+    total.peakbytes = total.livebytes;
+    run();
+    result.allocations = total.allocations - totalbefore.allocations;
+    result.allocatedbytes = total.allocatedbytes - totalbefore.allocatedbytes;
+    result.nodebytes = nodes.allocatedbytes - nodesbefore.allocatedbytes;
+    result.stringbytes = strings.allocatedbytes - stringsbefore.allocatedbytes;
+    result.peakbytes = total.peakbytes - totalbefore.livebytes;
+    result.nodepeakbytes = nodes.peakbytes - nodesbefore.livebytes;
+    result.stringpeakbytes = strings.peakbytes - stringsbefore.livebytes;
+
+    result.iterations = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    do {
+	   run();
+	   ++result.iterations;
+	   elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < mintime);
+    result.seconds = elapsed.count();
+    return result;
+}
+
+static json_string Key(const json_string & corpus, const json_string & name) {
+    return corpus + '/' + name;
+}
+
+static std::map<json_string, JSONNode> baseline;
+
+static void LoadBaseline(const char * path) {
+    std::ifstream file(path);
+    if (!file) {
+	   std::cerr << "can't open " << path << std::endl;
+	   exit(1);
+    }
+    json_string line;
+    while (std::getline(file, line)) {
+	   if (line.empty()) continue;
+	   JSONNode result = libJSON::parse(line);
+	   if (result.size() < 2) continue;  //the summary line
+	   baseline[Key(result["corpus"].as_string(), result["case"].as_string())] = result;
+    }
+}
+
+static void Percent(const char * what, double now, double then) {
+    std::cerr << "  " << what << " ";
+    if (then == 0) {
+	   std::cerr << (now == 0 ? "same" : "new");
+    } else {
+	   const double change = (now - then) * 100.0 / then;
+	   std::cerr << (change >= 0 ? "+" : "") << change << "%";
+    }
+}
+
+static void Report(const json_string & corpus, size_t bytes, const char * name, const Result & result) {
+    const double megabytes = (double)bytes * (double)result.iterations / (1024.0 * 1024.0);
+    const double rate = megabytes / result.seconds;
+    JSONStreamWriter out;
+    out.start_node();
+    out.key("corpus").string(corpus);
+    out.key("case").string(name);
+    out.key("bytes").number((long)bytes);
+    out.key("iterations").number((long)result.iterations);
+    out.key("seconds").number((json_number)result.seconds);
+    out.key("mb_per_s").number((json_number)rate);
+    out.key("allocations").number((long)result.allocations);
+    out.key("allocated_bytes").number((long)result.allocatedbytes);
+    out.key("node_bytes").number((long)result.nodebytes);
+    out.key("string_bytes").number((long)result.stringbytes);
+    out.key("peak_bytes").number((long)result.peakbytes);
+    out.key("node_peak_bytes").number((long)result.nodepeakbytes);
+    out.key("string_peak_bytes").number((long)result.stringpeakbytes);
+    out.end_node();
+    std::cout << out.str() << std::endl;
+
+    std::map<json_string, JSONNode>::const_iterator then = baseline.find(Key(corpus, name));
+    if (then != baseline.end()) {
+	   std::cerr << corpus << " " << name << ":";
+	   Percent("MB/s", rate, then -> second["mb_per_s"].as_float());
+	   Percent("allocations", (double)result.allocations, then -> second["allocations"].as_float());
+	   Percent("peak", (double)result.peakbytes, then -> second["peak_bytes"].as_float());
+	   std::cerr << std::endl;
+    }
+}
+
+int main(int argc, char ** argv) {
+    //before anything is parsed, so that every block the callbacks free is one they allocated
+    libJSON::register_memory_callbacks(CountingMalloc, CountingRealloc, CountingFree);
+    double mintime = 0.5;
+    for (int i = 1; i < argc; ++i) {
+	   if ((strcmp(argv[i], "--compare") == 0) && (i + 1 < argc)) {
+		  LoadBaseline(argv[++i]);
+	   } else if ((strcmp(argv[i], "--time") == 0) && (i + 1 < argc)) {
+		  mintime = atof(argv[++i]);
+	   } else {
+		  std::cerr << "usage: " << argv[0] << " [--compare baseline.json] [--time seconds]" << std::endl;
+		  return 1;
+	   }
+    }
+
+    Random random(20110605);
+    const json_string names[] = { "LIS", "ICH", "CHA", "MSG", "escaped" };
+    const json_string corpora[] = { MakeLIS(random), MakeICH(random), MakeCHA(random), MakeMSG(random), MakeEscaped(random) };
+
+    for (int c = 0; c < 5; ++c) {
+	   const json_string & json = corpora[c];
+	   Report(names[c], json.length(), "parse", Measure(mintime, [&]{
+		  JSONNode node = libJSON::parse(json);
+		  sink += node.size();
+	   }));
+	   #ifndef JSON_PREPARSE
+		  Report(names[c], json.length(), "preparse", Measure(mintime, [&]{
+			 JSONNode node = libJSON::parse(json);
+			 node.preparse();
+			 sink += node.size();
+		  }));
+	   #endif
+	   Report(names[c], json.length(), "trusted", Measure(mintime, [&]{
+		  JSONNode node = libJSON::parse(json, JSON_PARSE_PREPARSE | JSON_PARSE_TRUSTED);
+		  sink += node.size();
+	   }));
+	   Report(names[c], json.length(), "sax", Measure(mintime, [&]{
+		  NullHandler handler;
+		  sink += libJSON::parse_sax(json.data(), json.length(), handler);
+	   }));
+
+	   //writing starts from a tree that has already been fetched, so that only the writing is measured
+	   JSONNode tree = libJSON::parse(json);
+	   #ifndef JSON_PREPARSE
+		  tree.preparse();
+	   #endif
+	   Report(names[c], json.length(), "write", Measure(mintime, [&]{
+		  sink += tree.write().length();
+	   }));
+	   JSONStreamWriter out;  //kept between runs, so once its buffer has grown it doesn't allocate at all
+	   Report(names[c], json.length(), "stream_write", Measure(mintime, [&]{
+		  out.clear();
+		  Stream(out, tree, false);
+		  sink += out.length();
+	   }));
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    JSONStreamWriter out;
+    out.start_node().key("max_rss_kb").number((long)usage.ru_maxrss).end_node();
+    std::cout << out.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "TestSuite.h"
+
+#ifdef JSON_MEMORY_CALLBACKS
+void TestSuite::TestArena(void){
+    #ifndef JSON_LIBRARY
+	   UnitTest::SetPrefix("Arena");
+	   {
+		  //a scope takes an idle arena if there is one, and it goes back once everything in it is gone
+		  const size_t idle = JSONArena::idle();
+		  JSONNode tree;
+		  {
+			 JSONArena::Scope arena;
+			 assertEquals(arena.used(), 0);
+			 tree = libJSON::parse(JSON_TEXT("{\"channel\":\"Frontpage\",\"users\":[1,2,3,4,5,6,7,8,9,10,11,12]}"));
+			 assertNotEquals(arena.used(), 0);
+			 assertEquals(JSONArena::idle(), idle ? idle - 1 : 0);
+		  }
+		  assertEquals(JSONArena::idle(), idle ? idle - 1 : 0);  //the tree is still using it
+		  assertEquals(tree[JSON_TEXT("channel")], JSON_TEXT("Frontpage"));
+		  assertEquals(tree[JSON_TEXT("users")].size(), 12);
+		  assertEquals(tree[JSON_TEXT("users")][11], 12);
+
+		  //changing the tree after the scope has ended moves what has to grow onto the heap
+		  tree[JSON_TEXT("users")].push_back(JSONNode(JSON_TEXT(""), 13));
+		  assertEquals(tree[JSON_TEXT("users")].size(), 13);
+		  assertEquals(tree[JSON_TEXT("users")][12], 13);
+
+		  tree = JSONNode();
+		  assertEquals(JSONArena::idle(), idle ? idle : 1);
+	   }
+
+	   UnitTest::SetPrefix("Arena Reuse");
+	   {
+		  const size_t idle = JSONArena::idle();
+		  JSONNode copy;
+		  {
+			 JSONNode parsed;
+			 {
+				JSONArena::Scope arena;
+				assertEquals(arena.used(), 0);  //emptied before it was handed out again
+				parsed = libJSON::parse(JSON_TEXT("[\"hello\",{\"world\":true}]"));
+			 }
+			 copy = parsed.duplicate();  //outside of the scope, so it's on the heap
+		  }
+		  assertEquals(JSONArena::idle(), idle);
+		  assertEquals(copy.size(), 2);
+		  assertEquals(copy[0], JSON_TEXT("hello"));
+		  assertEquals(copy[1][0], true);
+		  TEST_PARSING_ITSELF(copy);
+	   }
+
+	   UnitTest::SetPrefix("Arena Nesting");
+	   {
+		  const size_t idle = JSONArena::idle();
+		  {
+			 JSONArena::Scope outer;
+			 JSONNode first = libJSON::parse(JSON_TEXT("[1,2]"));
+			 const size_t used = outer.used();
+			 {
+				JSONArena::Scope inner;
+				JSONNode second = libJSON::parse(JSON_TEXT("[3,4]"));
+				assertEquals(outer.used(), used);
+				assertNotEquals(inner.used(), 0);
+				assertEquals(second[1], 4);
+			 }
+			 JSONNode third = libJSON::parse(JSON_TEXT("[5]"));
+			 assertNotEquals(outer.used(), used);
+			 assertEquals(first[0], 1);
+			 assertEquals(third[0], 5);
+		  }
+		  assertEquals(JSONArena::idle(), (idle > 2) ? idle : 2);
+	   }
+
+	   UnitTest::SetPrefix("Arena Invalid");
+	   {
+		  const size_t idle = JSONArena::idle();
+		  {
+			 JSONArena::Scope arena;
+			 assertException(libJSON::parse(JSON_TEXT("{\"a\":[1,2,{\"b\":3}")), std::invalid_argument);
+		  }
+		  assertEquals(JSONArena::idle(), idle);  //whatever was built before it failed has been given back
+	   }
+
+	   UnitTest::SetPrefix("Arena Escape");
+	   {
+		  //a node kept after its scope only keeps the block it is in, not every block the arena had
+		  json_string big = JSON_TEXT("[0");
+		  for (int i = 1; i < 5000; ++i) {
+			 big += JSON_TEXT(",1");
+		  }
+		  big += JSON_TEXT("]");
+		  const size_t idle = JSONArena::idle();
+		  const size_t held = JSONArena::held();
+		  size_t during;
+		  JSONNode kept;
+		  {
+			 JSONArena::Scope arena;
+			 JSONNode tree = libJSON::parse(big);
+			 during = JSONArena::held();
+			 kept = tree[0];
+		  }
+		  assertTrue(during > held);
+		  assertTrue(JSONArena::held() <= held + (during - held) / 4);
+		  assertEquals(JSONArena::idle(), idle ? idle - 1 : 0);
+		  assertEquals(kept, 0);
+		  kept = JSONNode();
+		  assertTrue(JSONArena::held() <= held);
+		  assertEquals(JSONArena::idle(), idle ? idle : 1);
+	   }
+    #endif
+}
+#endif
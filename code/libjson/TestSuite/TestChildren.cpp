@@ -1,5 +1,14 @@
 #include "TestSuite.h"
 
+#ifdef JSON_INDEX_KEYS
+    static json_string KeyName(int i){
+	   json_string name(JSON_TEXT("key"));
+	   name += (json_char)(JSON_TEXT('0') + i / 10);
+	   name += (json_char)(JSON_TEXT('0') + i % 10);
+	   return name;
+    }
+#endif
+
 void TestSuite::TestChildren(void){
     UnitTest::SetPrefix("Children");
     #ifdef JSON_LIBRARY
@@ -166,17 +175,17 @@ void TestSuite::TestChildren(void){
 		  UNIT_TEST(
 				  JSONNODE * fresh = json_new(JSON_NODE);
 				  json_reserve(fresh, 3);
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mycapacity, 3);
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mysize, 0);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.capacity(), 3);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.size(), 0);
 				  json_push_back(fresh, json_new(JSON_NULL));
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mycapacity, 3);
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mysize, 1);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.capacity(), 3);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.size(), 1);
 				  json_push_back(fresh, json_new(JSON_NULL));
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mycapacity, 3);
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mysize, 2);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.capacity(), 3);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.size(), 2);
 				  json_push_back(fresh, json_new(JSON_NULL));
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mycapacity, 3);
-				  assertEquals(((JSONNode*)fresh) -> internal -> Children.mysize, 3);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.capacity(), 3);
+				  assertEquals(((JSONNode*)fresh) -> internal -> Children.size(), 3);
 				  json_delete(fresh);
 			 )
 	   
@@ -310,17 +319,193 @@ void TestSuite::TestChildren(void){
 		  UNIT_TEST(
 				  JSONNode fresh(JSON_NODE);
 				  fresh.reserve(3);
-				  assertEquals(fresh.internal -> Children.mycapacity, 3);
-				  assertEquals(fresh.internal -> Children.mysize, 0);
+				  assertEquals(fresh.internal -> Children.capacity(), 3);
+				  assertEquals(fresh.internal -> Children.size(), 0);
 				  fresh.push_back(JSONNode(JSON_NULL));
-				  assertEquals(fresh.internal -> Children.mycapacity, 3);
-				  assertEquals(fresh.internal -> Children.mysize, 1);
+				  assertEquals(fresh.internal -> Children.capacity(), 3);
+				  assertEquals(fresh.internal -> Children.size(), 1);
 				  fresh.push_back(JSONNode(JSON_NULL));
-				  assertEquals(fresh.internal -> Children.mycapacity, 3);
-				  assertEquals(fresh.internal -> Children.mysize, 2);
+				  assertEquals(fresh.internal -> Children.capacity(), 3);
+				  assertEquals(fresh.internal -> Children.size(), 2);
 				  fresh.push_back(JSONNode(JSON_NULL));
-				  assertEquals(fresh.internal -> Children.mycapacity, 3);
-				  assertEquals(fresh.internal -> Children.mysize, 3);
+				  assertEquals(fresh.internal -> Children.capacity(), 3);
+				  assertEquals(fresh.internal -> Children.size(), 3);
 		  )
+
+		  {
+			 //reserving nothing leaves the array to be made by whatever is added first
+			 JSONNode empty(JSON_ARRAY);
+			 empty.reserve(0);
+			 UNIT_TEST(assertEquals(empty.internal -> Children.capacity(), 0);)
+			 for (int i = 1; i <= 20; ++i) {
+				empty.push_back(JSONNode(JSON_TEXT(""), i));
+			 }
+			 assertEquals(empty.size(), 20);
+			 assertEquals(empty[19], 20);
+			 UNIT_TEST(
+				JSONNode inserted(JSON_ARRAY);
+				inserted.reserve(0);
+				JSONNode ** position = inserted.internal -> Children.begin();
+				inserted.internal -> Children.insert(position, JSONNode::newJSONNode(JSONNode(JSON_TEXT(""), 2)));
+				position = inserted.internal -> Children.begin();
+				inserted.internal -> Children.insert(position, JSONNode::newJSONNode(JSONNode(JSON_TEXT(""), 1)));
+				assertEquals(inserted.size(), 2);
+				assertEquals(inserted[0], 1);
+				assertEquals(inserted[1], 2);
+
+				JSONNode many(JSON_ARRAY);
+				many.reserve(0);
+				JSONNode * items[10];
+				for (int i = 0; i < 10; ++i) {
+				    items[i] = JSONNode::newJSONNode(JSONNode(JSON_TEXT(""), i));
+				}
+				position = many.internal -> Children.begin();
+				many.internal -> Children.insert(position, items, 10);
+				assertEquals(many.size(), 10);
+				assertEquals(many[9], 9);
+			 )
+		  }
+
+		  {
+			 //a value and children share their memory, so giving a container a value throws its children away
+			 JSONNode holder(JSON_NODE);
+			 for (int i = 0; i < 10; ++i) {
+				holder.push_back(JSONNode(json_string(JSON_TEXT("key")) + (json_char)(JSON_TEXT('0') + i), i));
+			 }
+			 assertEquals(holder[JSON_TEXT("key7")], 7);  //big enough to have a key index
+			 JSONNode copy = holder;
+			 holder = 5;
+			 assertEquals(holder.type(), JSON_NUMBER);
+			 assertEquals(holder, 5);
+			 assertEquals(holder.size(), 0);
+			 assertTrue(holder.empty());
+			 assertEquals(holder.as_string(), JSON_TEXT("5"));
+			 assertEquals(copy.size(), 10);
+			 assertEquals(copy[JSON_TEXT("key7")], 7);
+
+			 copy.nullify();
+			 assertEquals(copy.type(), JSON_NULL);
+			 assertEquals(copy.size(), 0);
+			 copy = JSON_TEXT("text");
+			 assertEquals(copy, JSON_TEXT("text"));
+			 assertEquals(copy.size(), 0);
+			 copy = true;
+			 assertEquals(copy, true);
+			 assertEquals(copy.size(), 0);
+			 assertEquals(copy.as_string(), JSON_TEXT("true"));
+		  }
+
+		  UnitTest::SetPrefix("Names");
+		  {
+			 //names that fit are kept in the node, longer ones aren't cut short
+			 const json_string fits(JSON_TEXT("fifteen_chars__"), 16 / sizeof(json_char) - 1);
+			 const json_string longer(JSON_TEXT("a name that is much too long to fit"));
+			 UNIT_TEST(assertEquals(sizeof(jsonName), 16);)
+			 JSONNode node(JSON_NODE);
+			 node.push_back(JSONNode(JSON_TEXT(""), 1));
+			 node.push_back(JSONNode(fits, 2));
+			 node.push_back(JSONNode(longer, 3));
+			 assertEquals(node.at(0).name(), JSON_TEXT(""));
+			 assertEquals(node.at(1).name(), fits);
+			 assertEquals(node.at(2).name(), longer);
+			 assertEquals(node[fits], 2);
+			 assertEquals(node[longer], 3);
+
+			 //renaming between the two, and copies keep their own
+			 JSONNode copy = node;
+			 node[longer].set_name(JSON_TEXT("a shorter name, still too long"));
+			 assertEquals(node.at(2).name(), JSON_TEXT("a shorter name, still too long"));
+			 node.at(2).set_name(JSON_TEXT("short"));
+			 assertEquals(node.at(2).name(), JSON_TEXT("short"));
+			 node.at(1).set_name(longer);
+			 assertEquals(node.at(1).name(), longer);
+			 assertEquals(copy.at(1).name(), fits);
+			 assertEquals(copy.at(2).name(), longer);
+			 assertNotEquals(node, copy);
+			 node.at(1).set_name(fits);
+			 node.at(2).set_name(longer);
+			 assertEquals(node, copy);
+			 TEST_PARSING_ITSELF(node);
+		  }
+
+		  #ifdef JSON_INDEX_KEYS
+			 UnitTest::SetPrefix("Key Index");
+			 {
+				//big enough to be indexed, with a duplicate and names that only differ by case
+				JSONNode big = libJSON::parse(JSON_TEXT("{\"identity\":\"Viona\",\"gender\":\"Female\",\"status\":\"online\",\"statusmsg\":\"\",\"Mode\":1,\"mode\":2,\"a\":3,\"b\":4,\"c\":5,\"identity\":\"Kira\"}"));
+				assertEquals(big.size(), 10);
+				assertEquals(big[JSON_TEXT("identity")], JSON_TEXT("Viona"));  //the first of the two
+				assertEquals(big[JSON_TEXT("mode")], 2);
+				assertEquals(big[JSON_TEXT("Mode")], 1);
+				assertEquals(big[JSON_TEXT("c")], 5);
+				assertEquals(big.at_nocase(JSON_TEXT("MODE")), 1);
+				assertEquals(big.at_nocase(JSON_TEXT("STATUS")), JSON_TEXT("online"));
+				assertException(big.at(JSON_TEXT("missing")), std::out_of_range);
+				assertException(big.at(JSON_TEXT("MODE")), std::out_of_range);
+				UNIT_TEST(assertNotEquals(big.internal -> Children.head() -> index, (void*)0);)
+
+				//renaming a child, or putting a different node in its place, is seen straight away
+				big[JSON_TEXT("c")].set_name(JSON_TEXT("d"));
+				assertException(big.at(JSON_TEXT("c")), std::out_of_range);
+				assertEquals(big[JSON_TEXT("d")], 5);
+				big[JSON_TEXT("a")] = JSONNode(JSON_TEXT("e"), 6);
+				assertException(big.at(JSON_TEXT("a")), std::out_of_range);
+				assertEquals(big[JSON_TEXT("e")], 6);
+
+				//as is anything that moves the children around
+				assertEquals(big.pop_back(JSON_TEXT("identity")), JSON_TEXT("Viona"));
+				assertEquals(big[JSON_TEXT("identity")], JSON_TEXT("Kira"));
+				assertEquals(big[JSON_TEXT("gender")], JSON_TEXT("Female"));
+				for (int i = 0; i < 100; ++i) {
+				    big.push_back(JSONNode(KeyName(i), i));
+				    assertEquals(big[KeyName(i)], i);
+				}
+				for (int i = 0; i < 100; ++i) {
+				    assertEquals(big[KeyName(i)], i);
+				}
+				assertEquals(big[JSON_TEXT("mode")], 2);
+				assertEquals(big.pop_back(JSON_TEXT("mode")), 2);
+				assertException(big.at(JSON_TEXT("mode")), std::out_of_range);
+				assertEquals(big.at_nocase(JSON_TEXT("mode")), 1);
+				big.clear();
+				assertException(big.at(JSON_TEXT("mode")), std::out_of_range);
+			 }
+			 {
+				//a copy of a child that's in an index can still be renamed on its own
+				JSONNode big = libJSON::parse(JSON_TEXT("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}"));
+				assertEquals(big[JSON_TEXT("h")], 8);
+				JSONNode copy = big[JSON_TEXT("h")];
+				copy.set_name(JSON_TEXT("z"));
+				assertEquals(big[JSON_TEXT("h")], 8);
+				assertException(big.at(JSON_TEXT("z")), std::out_of_range);
+				TEST_PARSING_ITSELF(big);
+
+				//and renaming a child that shares its data with a copy is still seen by the index
+				JSONNode shared = big[JSON_TEXT("g")];
+				big[JSON_TEXT("g")].set_name(JSON_TEXT("y"));
+				assertException(big.at(JSON_TEXT("g")), std::out_of_range);
+				assertEquals(big[JSON_TEXT("y")], 7);
+				assertEquals(shared.name(), JSON_TEXT("g"));
+
+				//a duplicate isn't in anyone's index
+				JSONNode dup = big[JSON_TEXT("y")].duplicate();
+				UNIT_TEST(assertTrue(!dup.internal -> _indexed);)
+				dup.set_name(JSON_TEXT("x"));
+				assertEquals(big[JSON_TEXT("y")], 7);
+			 }
+			 {
+				//renaming a child of some other object doesn't rebuild this index
+				JSONNode big = libJSON::parse(JSON_TEXT("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}"));
+				JSONNode other = big.duplicate();
+				assertEquals(big[JSON_TEXT("h")], 8);
+				assertEquals(other[JSON_TEXT("h")], 8);
+				UNIT_TEST(const void * slots = big.internal -> Children.head() -> index -> slots;)
+				other[JSON_TEXT("a")].set_name(JSON_TEXT("z"));
+				assertEquals(other[JSON_TEXT("z")], 1);
+				assertEquals(big[JSON_TEXT("a")], 1);
+				assertException(big.at(JSON_TEXT("z")), std::out_of_range);
+				UNIT_TEST(assertEquals((const void *)big.internal -> Children.head() -> index -> slots, slots);)
+			 }
+		  #endif
     #endif
 }
@@ -1,5 +1,7 @@
 #include "TestSuite.h"
+#include "../Source/NumberToString.h"
 #include <cstdlib>
+#include <cstdio>
 
 void TestSuite::TestInspectors(void){
     UnitTest::SetPrefix("Inspectors");
@@ -264,6 +266,26 @@ void TestSuite::TestInspectors(void){
 		  #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
 			 assertException(test.at_nocase(JSON_TEXT("meh")), std::out_of_range);
 		  #endif
+
+		  assertEquals(test.try_at(JSON_TEXT("meh")), (JSONNode*)0);
+		  assertEquals(test.try_at(JSON_TEXT("HELLO")), (JSONNode*)0);
+		  assertEquals(casted.try_at(JSON_TEXT("")), (JSONNode*)0);
+		  if (JSONNode * found = test.try_at(JSON_TEXT("hello"))){
+			 assertEquals(*found, JSON_TEXT("mars"));
+			 assertEquals(found, &test.at(JSON_TEXT("hello")));
+		  } else {
+			 FAIL("try_at didn't find hello");
+		  }
+		  {
+			 const JSONNode & constant = test;
+			 const JSONNode * found = constant.try_at(JSON_TEXT("salut"));
+			 assertTrue(found != 0);
+			 if (found) assertEquals(*found, JSON_TEXT("france"));
+		  }
+		  #ifdef JSON_CASE_INSENSITIVE_FUNCTIONS
+			 assertEquals(test.try_at_nocase(JSON_TEXT("meh")), (JSONNode*)0);
+			 assertTrue(test.try_at_nocase(JSON_TEXT("HELLO")) != 0);
+		  #endif
 		  
 		  assertEquals(test[JSON_TEXT("hi")], JSON_TEXT("world"));
 		  assertEquals(test[JSON_TEXT("hello")], JSON_TEXT("mars"));
@@ -292,5 +314,59 @@ void TestSuite::TestInspectors(void){
 				assertEquals(test.as_binary(), "");
 			 #endif
 		  #endif
+
+		  UnitTest::SetPrefix("Number Decoding");
+		  {
+			 const json_string json(JSON_TEXT("[0,-7,9007199254740993,9223372036854775807,-9223372036854775807,9223372036854775808,1.5,-0.25,1e3,2.5E-3,0.1,1.7976931348623157e308,5e-324,123456789012345678901234567890]"));
+			 JSONNode numbers = libJSON::parse(json);
+			 assertEquals(numbers.size(), 14);
+			 assertEquals(numbers[0].as_int(), 0);
+			 assertEquals(numbers[1].as_int(), -7);
+			 assertEquals(numbers[1], -7);
+			 #ifndef JSON_ISO_STRICT
+				//integers too big for a double to hold exactly come back as they were written
+				assertEquals(numbers[2].as_int(), 9007199254740993LL);
+				assertEquals(numbers[3].as_int(), 9223372036854775807LL);
+				assertEquals(numbers[4].as_int(), -9223372036854775807LL);
+			 #endif
+			 assertEquals(numbers[3].as_bool(), true);
+			 assertEquals(numbers[0].as_bool(), false);
+			 //and ones too big for json_int_t are still numbers
+			 assertEquals(numbers[5].as_float(), (json_number)9223372036854775808.0);
+			 assertEquals(numbers[6].as_float(), (json_number)1.5);
+			 assertEquals(numbers[7].as_float(), (json_number)-0.25);
+			 assertEquals(numbers[8].as_int(), 1000);
+			 for(int i = 0; i < 14; ++i){
+				const json_string & text = numbers[i].as_string();
+				std::string ascii(text.begin(), text.end());
+				assertEquals(numbers[i].as_float(), (json_number)strtod(ascii.c_str(), 0));
+			 }
+			 assertEquals(numbers.write(), json);
+			 TEST_PARSING_ITSELF(numbers);
+		  }
+		  {
+			 //the quick path has to round the same way strtod does
+			 char text[64];
+			 unsigned int seed = 20110605;
+			 for(int i = 0; i < 2000; ++i){
+				seed = seed * 1103515245 + 12345;
+				const unsigned int whole = seed >> 8;
+				seed = seed * 1103515245 + 12345;
+				const unsigned int fraction = seed >> 12;
+				seed = seed * 1103515245 + 12345;
+				const int exponent = (int)(seed >> 16) % 50 - 25;
+				snprintf(text, 64, "%s%u.%ue%d", (i & 1) ? "-" : "", whole, fraction, exponent);
+				const json_string number(text, text + strlen(text));
+				assertEquals(NumberToString::_atof(number.data(), number.data() + number.length()), (json_number)strtod(text, 0));
+			 }
+			 json_int_t value = 0;
+			 const json_string big(JSON_TEXT("99999999999999999999"));
+			 assertFalse(NumberToString::_atoi(big.data(), big.data() + big.length(), value));
+			 const json_string fraction(JSON_TEXT("12.0"));
+			 assertFalse(NumberToString::_atoi(fraction.data(), fraction.data() + fraction.length(), value));
+			 const json_string negative(JSON_TEXT("-42"));
+			 assertTrue(NumberToString::_atoi(negative.data(), negative.data() + negative.length(), value));
+			 assertEquals(value, -42);
+		  }
     #endif
 }
@@ -299,10 +299,8 @@ void TestSuite::TestNamespace(void){
 		  assertEquals(tester.type(), JSON_NODE);
 		  UNIT_TEST(
 				  IF_FETCHABLE(
-							assertFalse(tester.internal -> fetched);
-							tester.preparse();
-							assertTrue(tester.internal -> fetched);
-							assertTrue(tester[0].internal -> fetched);
+							assertTrue(tester.internal -> fetched);  //nodes are built while parsing
+							assertTrue(tester[0].internal -> fetched);  //and a string with nothing escaped in it is already its value
 							)
 				  )
 		  assertEquals(tester.size(), 1);
@@ -315,9 +313,8 @@ void TestSuite::TestNamespace(void){
 		  assertException(libJSON::parse(JSON_TEXT("\"hello\":\"world\"")), std::invalid_argument);
 		  tester = libJSON::parse(JSON_TEXT(" [true, false]\r\n"));
 		  assertEquals(tester.type(), JSON_ARRAY);
-		  UNIT_TEST(IF_FETCHABLE(assertFalse(tester.internal -> fetched);))
-		  assertEquals(tester.size(), 2);
 		  UNIT_TEST(IF_FETCHABLE(assertTrue(tester.internal -> fetched);))
+		  assertEquals(tester.size(), 2);
 		  assertException(libJSON::parse(JSON_TEXT("true,false]")), std::invalid_argument);
 		  #ifdef JSON_SAFE
 			 assertException(libJSON::parse(JSON_TEXT("[true,false")), std::invalid_argument);
@@ -343,10 +340,167 @@ void TestSuite::TestNamespace(void){
 		  assertEquals(tester[1], 2);
 		  assertEquals(tester, libJSON::parse(JSON_TEXT("{\"\":{},\"\":2}")));
 		  TEST_PARSING_ITSELF(tester);
+
+		  UnitTest::SetPrefix("Parse Range");
+		  {
+			 //only the bytes inside of the range should be looked at, even if what follows isn't null terminated
+			 const json_char frame[] = JSON_TEXT("MSG {\"channel\":\"Frontpage\",\"message\":\"hi \\\"there\\\"\"}garbage");
+			 tester = libJSON::parse(frame + 4, 48);
+			 assertEquals(tester.type(), JSON_NODE);
+			 assertEquals(tester.size(), 2);
+			 assertEquals(tester[0], JSON_TEXT("Frontpage"));
+			 assertEquals(tester[1], JSON_TEXT("hi \"there\""));
+			 assertEquals(tester, libJSON::parse(json_string(frame + 4, 48)));
+			 #ifdef JSON_SAFE
+				assertException(libJSON::parse(frame + 4, 47), std::invalid_argument);
+				assertException(libJSON::parse(frame + 4, 20), std::invalid_argument);
+			 #endif
+			 assertException(libJSON::parse(frame, 0), std::invalid_argument);
+
+			 //a backslash at the end of the range escapes nothing, and an escaped quote doesn't close the string
+			 const json_char escape[] = JSON_TEXT("{\"a\":\"b\\\"}");
+			 assertException(libJSON::parse(escape, 8), std::invalid_argument);
+			 assertException(libJSON::parse(escape, 9), std::invalid_argument);
+			 assertException(libJSON::parse(escape, 10), std::invalid_argument);
+
+			 //the whole range has to be json, even a null terminator is one character too many
+			 const json_char terminated[] = JSON_TEXT("{\"a\":1}");
+			 assertEquals(libJSON::parse(terminated, 7).size(), 1);
+			 assertException(libJSON::parse(terminated, 8), std::invalid_argument);
+		  }
+
+		  UnitTest::SetPrefix("Parse Depth");
+		  {
+			 //as deep as JSON_MAX_DEPTH is fine, any deeper is refused instead of running out of stack
+			 json_string deepest = json_string(JSON_MAX_DEPTH, JSON_TEXT('[')) + json_string(JSON_MAX_DEPTH, JSON_TEXT(']'));
+			 tester = libJSON::parse(deepest);
+			 assertEquals(tester.type(), JSON_ARRAY);
+			 assertEquals(tester.size(), 1);
+			 json_string deeper = JSON_TEXT("{\"a\":") + json_string(JSON_MAX_DEPTH, JSON_TEXT('[')) + json_string(JSON_MAX_DEPTH, JSON_TEXT(']')) + JSON_TEXT("}");
+			 assertException(libJSON::parse(deeper), std::invalid_argument);
+			 json_string flood(100000, JSON_TEXT('['));
+			 assertException(libJSON::parse(flood), std::invalid_argument);
+			 assertException(libJSON::parse(flood.c_str(), flood.length(), JSON_PARSE_TRUSTED), std::invalid_argument);
+		  }
+
+		  UnitTest::SetPrefix("Parse Lazy Strings");
+		  {
+			 tester = libJSON::parse(JSON_TEXT("{\"plain\":\"it's/plain\",\"escaped\":\"a\\tb\\/c\\u0041\",\"n\\u0061me\":\"\"}"));
+			 UNIT_TEST(
+				IF_FETCHABLE(
+				    assertTrue(tester[0].internal -> fetched);
+				    assertFalse(tester[1].internal -> fetched);  //escapes are left until something reads it
+				    assertTrue(tester[2].internal -> fetched);
+				)
+			 )
+			 //until then it's written back out exactly as it came in
+			 assertEquals(tester.write(), JSON_TEXT("{\"plain\":\"it's/plain\",\"escaped\":\"a\\tb\\/c\\u0041\",\"name\":\"\"}"));
+			 UNIT_TEST(IF_FETCHABLE(assertFalse(tester[1].internal -> fetched);))
+			 assertEquals(tester[0], JSON_TEXT("it's/plain"));
+			 assertEquals(tester[1], JSON_TEXT("a\tb/cA"));
+			 assertEquals(tester[2].name(), JSON_TEXT("name"));
+			 assertEquals(tester[2], JSON_TEXT(""));
+			 UNIT_TEST(IF_FETCHABLE(assertTrue(tester[1].internal -> fetched);))
+			 TEST_PARSING_ITSELF(tester);
+
+			 //as_string hands back the node's own string rather than a copy of it
+			 const json_string & plain = tester[0].as_string();
+			 assertEquals(&plain, &tester[0].as_string());
+			 assertEquals(plain, JSON_TEXT("it's/plain"));
+		  }
+
+		  UnitTest::SetPrefix("Parse Policy");
+		  {
+			 const json_string json(JSON_TEXT("{\"s\":\"a\\nb\",\"n\":12.5,\"b\":[true,false,null],\"e\":{}}"));
+			 const JSONNode lazy = libJSON::parse(json);
+			 tester = libJSON::parse(json, JSON_PARSE_PREPARSE);
+			 UNIT_TEST(
+				IF_FETCHABLE(
+				    assertFalse(lazy[0].internal -> fetched);
+				    assertFalse(lazy[1].internal -> fetched);
+				    assertTrue(tester[0].internal -> fetched);
+				    assertTrue(tester[1].internal -> fetched);
+				)
+			 )
+			 assertEquals(tester, lazy);
+
+			 tester = libJSON::parse(json.data(), json.length(), JSON_PARSE_TRUSTED);
+			 assertEquals(tester, lazy);
+			 assertEquals(tester[1], 12.5);
+			 assertEquals(tester[2][0], true);
+			 assertEquals(tester[2][1], false);
+			 assertEquals(tester[2][2].type(), JSON_NULL);
+			 assertEquals(tester.write(), json);
+			 tester = libJSON::parse(json, JSON_PARSE_PREPARSE | JSON_PARSE_TRUSTED);
+			 assertEquals(tester, lazy);
+			 TEST_PARSING_ITSELF(tester);
+
+			 //trusted json only has its literals looked at as far as the first character
+			 tester = libJSON::parse(JSON_TEXT("[tru,nul,]"), JSON_PARSE_TRUSTED);
+			 assertEquals(tester.size(), 3);
+			 assertEquals(tester[0], true);
+			 assertEquals(tester[1].type(), JSON_NULL);
+			 assertEquals(tester[2].type(), JSON_NULL);
+			 #ifdef JSON_SAFE
+				assertEquals(libJSON::parse(JSON_TEXT("[tru]"))[0].type(), JSON_NULL);  //nullified by the check instead
+			 #endif
+			 //but its structure still is
+			 assertException(libJSON::parse(JSON_TEXT("{\"a\":1"), JSON_PARSE_TRUSTED), std::invalid_argument);
+			 assertException(libJSON::parse(JSON_TEXT("[\"a\"] x"), JSON_PARSE_TRUSTED), std::invalid_argument);
+		  }
+
+		  UnitTest::SetPrefix("Parse Single Pass");
+		  {
+			 //deep nesting is walked once, not once per level
+			 json_string deep;
+			 for (int i = 0; i < 200; ++i) deep += JSON_TEXT("[{\"a\":");
+			 deep += JSON_TEXT("1");
+			 for (int i = 0; i < 200; ++i) deep += JSON_TEXT("}]");
+			 tester = libJSON::parse(deep);
+			 const JSONNode * runner = &tester;
+			 for (int i = 0; i < 200; ++i) {
+				assertEquals(runner -> type(), JSON_ARRAY);
+				assertEquals(runner -> size(), 1);
+				assertEquals((*runner)[0][0].name(), JSON_TEXT("a"));
+				runner = &(*runner)[0][0];
+			 }
+			 assertEquals(*runner, 1);
+			 TEST_PARSING_ITSELF(tester);
+		  }
+		  tester = libJSON::parse(JSON_TEXT("{\"say \\\"hi\\\"\":\"a \\\"quote\\\" and a \\\\\", \"list\" : [ \"]\" , \"}\" ]}"));
+		  assertEquals(tester.size(), 2);
+		  assertEquals(tester[0].name(), JSON_TEXT("say \"hi\""));
+		  assertEquals(tester[0], JSON_TEXT("a \"quote\" and a \\"));
+		  assertEquals(tester[1].name(), JSON_TEXT("list"));
+		  assertEquals(tester[1].size(), 2);
+		  assertEquals(tester[1][0], JSON_TEXT("]"));
+		  assertEquals(tester[1][1], JSON_TEXT("}"));
+		  TEST_PARSING_ITSELF(tester);
+		  tester = libJSON::parse(JSON_TEXT("{ \"a\" : [ 1 , /*two*/ 2.5e1 ] , #bool\n \"b\" : true, //nothing\n \"c\" : null }"));
+		  assertEquals(tester.size(), 3);
+		  assertEquals(tester[0].size(), 2);
+		  assertEquals(tester[0][0], 1);
+		  assertEquals(tester[0][1], 25);
+		  assertEquals(tester[1], true);
+		  assertEquals(tester[2].type(), JSON_NULL);
+		  TEST_PARSING_ITSELF(tester);
+		  tester = libJSON::parse(JSON_TEXT("[[],{},[{}],\"\"]"));
+		  assertEquals(tester.size(), 4);
+		  assertTrue(tester[0].empty());
+		  assertTrue(tester[1].empty());
+		  assertEquals(tester[2].size(), 1);
+		  assertEquals(tester[3], JSON_TEXT(""));
+		  TEST_PARSING_ITSELF(tester);
+		  assertException(libJSON::parse(JSON_TEXT("{\"a\":1 \"b\":2}")), std::invalid_argument);
+		  assertException(libJSON::parse(JSON_TEXT("[\"a\":1]")), std::invalid_argument);
+		  assertException(libJSON::parse(JSON_TEXT("{\"a\":\"unterminated}")), std::invalid_argument);
+		  assertException(libJSON::parse(JSON_TEXT("{\"a\":[1,2}")), std::invalid_argument);
+		  assertException(libJSON::parse(JSON_TEXT("{a:1}")), std::invalid_argument);
+		  assertException(libJSON::parse(JSON_TEXT("[1] x")), std::invalid_argument);
 		  
 		  tester = libJSON::parse(JSON_TEXT("\r\n{\"hello\":\"world\", \"hi\":\"mars\"}"));
 		  assertEquals(tester.type(), JSON_NODE);
-		  UNIT_TEST(IF_FETCHABLE(assertFalse(tester.internal -> fetched);))
+		  UNIT_TEST(IF_FETCHABLE(assertTrue(tester.internal -> fetched);))
 		  assertEquals(tester.size(), 2);
 		  assertEquals(tester[0].name(), JSON_TEXT("hello"));
 		  assertEquals(tester[0], JSON_TEXT("world"));
@@ -356,7 +510,7 @@ void TestSuite::TestNamespace(void){
 		  
 		  tester = libJSON::parse(JSON_TEXT("\r\n{\"hello\":\"world\", \"hi\":\"mars\", \"and\":\"pluto\"}"));
 		  assertEquals(tester.type(), JSON_NODE);
-		  UNIT_TEST(IF_FETCHABLE(assertFalse(tester.internal -> fetched);))
+		  UNIT_TEST(IF_FETCHABLE(assertTrue(tester.internal -> fetched);))
 		  assertEquals(tester.size(), 3);
 		  assertEquals(tester[0].name(), JSON_TEXT("hello"));
 		  assertEquals(tester[0], JSON_TEXT("world"));
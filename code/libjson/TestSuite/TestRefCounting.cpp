@@ -1,4 +1,9 @@
 #include "TestSuite.h"
+#ifdef JSON_ATOMIC_REF_COUNT
+    #include <atomic>
+    #include <thread>
+    #include <vector>
+#endif
 
 void TestSuite::TestReferenceCounting(void){
     UnitTest::SetPrefix("Reference Counting");
@@ -117,5 +122,68 @@ void TestSuite::TestReferenceCounting(void){
 		  assertEquals(test2[0].size(), 0);
 		  TEST_PARSING_ITSELF(test1);
 		  TEST_PARSING_ITSELF(test2);
+
+		  #ifdef JSON_ATOMIC_REF_COUNT
+			 UnitTest::SetPrefix("Atomic Reference Counting");
+			 {
+				//objects with enough keys to be indexed
+				json_string text = JSON_TEXT("[");
+				for (int i = 0; i < 100; ++i) {
+				    if (i) text += JSON_TEXT(",");
+				    text += JSON_TEXT("{\"identity\":\"Character\\tOne\",\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"index\":");
+				    text += NumberToString::_itoa<int>(i);
+				    text += JSON_TEXT("}");
+				}
+				text += JSON_TEXT("]");
+				JSONNode tree = libJSON::parse(text);
+				tree.freeze();
+				#ifndef JSON_PREPARSE
+				    UNIT_TEST(const JSONNode & fetchedtree = tree; assertTrue(fetchedtree.internal -> fetched); assertTrue(fetchedtree[0][0].internal -> fetched);)
+				#endif
+
+				//a rename somewhere else doesn't make a frozen index get built again
+				#ifdef JSON_INDEX_KEYS
+				    const JSONNode & frozen = tree;
+				    UNIT_TEST(void * index = frozen[5].internal -> Children.head() -> index; assertNotEquals(index, (void*)0);)
+				    JSONNode other = libJSON::parse(JSON_TEXT("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}"));
+				    assertEquals(other[JSON_TEXT("h")], 8);
+				    other[JSON_TEXT("a")].set_name(JSON_TEXT("z"));
+				    assertEquals(frozen[5][JSON_TEXT("index")], 5);
+				    UNIT_TEST(assertEquals(frozen[5].internal -> Children.head() -> index, index);)
+				#endif
+
+				//copies are read, changed and let go of on several threads at once
+				std::atomic<int> wrong(0);
+				std::vector<std::thread> threads;
+				for (int t = 0; t < 4; ++t) {
+				    threads.push_back(std::thread([&tree, &wrong, t]{
+					   for (int repeat = 0; repeat < 20; ++repeat) {
+						  JSONNode copy = tree;
+						  const JSONNode & view = copy;
+						  for (json_index_t i = 0; i < view.size(); ++i) {
+							 JSONNode entry = view[i];
+							 const JSONNode & fields = entry;
+							 if (fields[JSON_TEXT("index")].as_int() != (json_int_t)i) ++wrong;
+							 if (fields[JSON_TEXT("identity")].as_string() != JSON_TEXT("Character\tOne")) ++wrong;
+						  }
+						  copy[t].push_back(JSONNode(JSON_TEXT("thread"), t));
+						  if (view[t].size() != 10) ++wrong;
+					   }
+				    }));
+				}
+				for (size_t t = 0; t < threads.size(); ++t) {
+				    threads[t].join();
+				}
+				assertEquals(wrong.load(), 0);
+				assertEquals(tree.size(), 100);
+				assertEquals(tree[0].size(), 9);
+				UNIT_TEST(assertEquals(tree.internal -> refcount, 1);)
+
+				//once nobody else has it, changing it in place lets the index go out of date again
+				tree[0][JSON_TEXT("a")].set_name(JSON_TEXT("renamed"));
+				assertEquals(tree[0][JSON_TEXT("renamed")], 1);
+				assertException(tree[0].at(JSON_TEXT("a")), std::out_of_range);
+			 }
+		  #endif
     #endif
 }
@@ -0,0 +1,124 @@
+#include "TestSuite.h"
+
+#ifndef JSON_LIBRARY
+    //writes every event down, so that the order they came in can be checked
+    class RecordingHandler : public JSONSaxHandler {
+    public:
+	   RecordingHandler(int stopafter = -1) : events(), stopafter(stopafter), lastbuffer(0) {}
+	   virtual bool start_node(void){ return add(JSON_TEXT("{")); }
+	   virtual bool end_node(void){ return add(JSON_TEXT("}")); }
+	   virtual bool start_array(void){ return add(JSON_TEXT("[")); }
+	   virtual bool end_array(void){ return add(JSON_TEXT("]")); }
+	   virtual bool key(const json_char * name, size_t length){ lastbuffer = name; return add(JSON_TEXT("k:") + json_string(name, length)); }
+	   virtual bool string(const json_char * value, size_t length){ lastbuffer = value; return add(JSON_TEXT("s:") + json_string(value, length)); }
+	   virtual bool number(const json_char * value, size_t length){ return add(JSON_TEXT("n:") + json_string(value, length)); }
+	   virtual bool boolean(bool value){ return add(value ? JSON_TEXT("true") : JSON_TEXT("false")); }
+	   virtual bool null(void){ return add(JSON_TEXT("null")); }
+
+	   json_string events;
+	   int stopafter;  //how many events to take before asking the parser to stop, or -1 to never stop
+	   const json_char * lastbuffer;  //where the last string or name was passed from
+    private:
+	   bool add(const json_string & event){
+		  if (!events.empty()) events += JSON_TEXT(' ');
+		  events += event;
+		  return (stopafter < 0) || (--stopafter > 0);
+	   }
+    };
+
+    static json_string SaxEvents(const json_string & json){
+	   RecordingHandler handler;
+	   libJSON::parse_sax(json.data(), json.length(), handler);
+	   return handler.events;
+    }
+#endif
+
+void TestSuite::TestSax(void){
+    #ifndef JSON_LIBRARY
+	   UnitTest::SetPrefix("Sax Events");
+	   assertEquals(SaxEvents(JSON_TEXT("{}")), JSON_TEXT("{ }"));
+	   assertEquals(SaxEvents(JSON_TEXT("[]")), JSON_TEXT("[ ]"));
+	   assertEquals(SaxEvents(JSON_TEXT("{\"hello\":\"world\"}")), JSON_TEXT("{ k:hello s:world }"));
+	   assertEquals(SaxEvents(JSON_TEXT("[1,-2.5e+3,true,false,null,\"\"]")), JSON_TEXT("[ n:1 n:-2.5e+3 true false null s: ]"));
+	   assertEquals(SaxEvents(JSON_TEXT("{\"a\":{\"b\":[[],{}]},\"c\":[1,[2]]}")), JSON_TEXT("{ k:a { k:b [ [ ] { } ] } k:c [ n:1 [ n:2 ] ] }"));
+	   assertEquals(SaxEvents(JSON_TEXT("{\"characters\":[[\"Viona\",\"Female\",\"online\",\"\"],[\"Kira\",\"Male\",\"busy\",\"Away\"]]}")),
+			  JSON_TEXT("{ k:characters [ [ s:Viona s:Female s:online s: ] [ s:Kira s:Male s:busy s:Away ] ] }"));
+
+	   UnitTest::SetPrefix("Sax White Space");
+	   assertEquals(SaxEvents(JSON_TEXT(" {\n\t\"hello\" : \"big world\" ,\r\n \"x\" : [ 1 , 2 ] }  ")), JSON_TEXT("{ k:hello s:big world k:x [ n:1 n:2 ] }"));
+	   assertEquals(SaxEvents(JSON_TEXT("/*comment*/{#comment\n\n\t\"hello\" ://comment\n \"world\"\r\n}  ")), JSON_TEXT("{ k:hello s:world }"));
+
+	   UnitTest::SetPrefix("Sax Escapes");
+	   assertEquals(SaxEvents(JSON_TEXT("[\"say \\\"hi\\\"\"]")), JSON_TEXT("[ s:say \"hi\" ]"));
+	   assertEquals(SaxEvents(JSON_TEXT("[\"a\\\\b\\/c\\td\\ne\"]")), JSON_TEXT("[ s:a\\b/c\td\ne ]"));
+	   assertEquals(SaxEvents(JSON_TEXT("[\"\\u0041\\x42\"]")), JSON_TEXT("[ s:AB ]"));
+	   assertEquals(SaxEvents(JSON_TEXT("{\"a\\\"b\":1}")), JSON_TEXT("{ k:a\"b n:1 }"));
+	   {
+		  //strings without escapes are passed straight out of the json
+		  json_string json(JSON_TEXT("[\"plain\"]"));
+		  RecordingHandler handler;
+		  libJSON::parse_sax(json.data(), json.length(), handler);
+		  assertEquals(handler.lastbuffer, json.data() + 2);
+	   }
+
+	   UnitTest::SetPrefix("Sax Length");
+	   {
+		  //only [json, json + length) is read, the rest might not even be json
+		  json_string json(JSON_TEXT("[1,2]garbage"));
+		  RecordingHandler handler;
+		  assertTrue(libJSON::parse_sax(json.data(), 5, handler));
+		  assertEquals(handler.events, JSON_TEXT("[ n:1 n:2 ]"));
+	   }
+
+	   UnitTest::SetPrefix("Sax Stopping");
+	   {
+		  json_string json(JSON_TEXT("[1,2,3,4]"));
+		  RecordingHandler handler(3);
+		  assertFalse(libJSON::parse_sax(json.data(), json.length(), handler));
+		  assertEquals(handler.events, JSON_TEXT("[ n:1 n:2"));
+	   }
+	   {
+		  json_string json(JSON_TEXT("[1,2,3,4]"));
+		  RecordingHandler handler;
+		  assertTrue(libJSON::parse_sax(json.data(), json.length(), handler));
+	   }
+
+	   UnitTest::SetPrefix("Sax Invalid");
+	   assertException(SaxEvents(JSON_TEXT("")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("hello")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("\"hello\"")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1,2")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1 2]")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1,2}")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1]]")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("{\"a\":}")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("{\"a\" 1}")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("{a:1}")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[\"unterminated]")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[\"\\u00\"]")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[tru]")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1] x")), std::invalid_argument);
+	   assertException(SaxEvents(JSON_TEXT("[1]/*")), std::invalid_argument);
+
+	   UnitTest::SetPrefix("Sax Matches Parse");
+	   {
+		  //the events should walk the same tree that parse builds
+		  JSONNode node = libJSON::parse(JSON_TEXT("{\"channel\":\"Frontpage\",\"users\":[{\"identity\":\"Viona\"},{\"identity\":\"Kira\"}],\"mode\":\"both\"}"));
+		  json_string events(JSON_TEXT("{"));
+		  for (json_index_t i = 0; i < node.size(); ++i) {
+			 events += JSON_TEXT(" k:") + node[i].name();
+			 if (node[i].type() == JSON_ARRAY) {
+				events += JSON_TEXT(" [");
+				for (json_index_t j = 0; j < node[i].size(); ++j) {
+				    events += JSON_TEXT(" { k:identity s:") + node[i][j][0].as_string() + JSON_TEXT(" }");
+				}
+				events += JSON_TEXT(" ]");
+			 } else {
+				events += JSON_TEXT(" s:") + node[i].as_string();
+			 }
+		  }
+		  events += JSON_TEXT(" }");
+		  assertEquals(SaxEvents(JSON_TEXT("{\"channel\":\"Frontpage\",\"users\":[{\"identity\":\"Viona\"},{\"identity\":\"Kira\"}],\"mode\":\"both\"}")), events);
+	   }
+    #endif
+}
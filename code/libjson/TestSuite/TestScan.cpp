@@ -0,0 +1,65 @@
+#include "TestSuite.h"
+#include "../Source/JSONScan.h"
+
+//checks what each scanner finds at every offset of every length up to a few vectors long
+static void TestKernel(void){
+    for (int length = 0; length < 100; ++length) {
+	   for (int at = 0; at <= length; ++at) {
+		  json_string text(length, JSON_TEXT('a'));
+		  if (at < length) text[at] = JSON_TEXT('\"');
+		  const json_char * begin = text.data();
+		  const json_char * end = begin + length;
+		  assertEquals(JSONScan::FindQuoteOrBackslash(begin, end) - begin, at);
+		  assertEquals(JSONScan::FindBackslash(begin, end) - begin, length);
+		  if (at < length) text[at] = JSON_TEXT('\\');
+		  assertEquals(JSONScan::FindQuoteOrBackslash(begin, end) - begin, at);
+		  assertEquals(JSONScan::FindBackslash(begin, end) - begin, at);
+
+		  json_string spaces(length, JSON_TEXT(' '));
+		  for (int i = 0; i < length; ++i) spaces[i] = JSON_TEXT(" \t\r\n")[i % 4];
+		  if (at < length) spaces[at] = JSON_TEXT('{');
+		  assertEquals(JSONScan::SkipSpaces(spaces.data(), spaces.data() + length) - spaces.data(), at);
+	   }
+    }
+    {
+	   //nothing past the end is looked at, even when it's in the same vector
+	   json_string text(JSON_TEXT("abcdefghijklmnopqrstuvwxyz0123456789\"\\ "));
+	   const json_char * begin = text.data();
+	   assertEquals(JSONScan::FindQuoteOrBackslash(begin, begin + 36) - begin, 36);
+	   assertEquals(JSONScan::FindBackslash(begin, begin + 37) - begin, 37);
+    }
+    {
+	   //characters with the top bit set aren't mistaken for anything
+	   json_string text(40, (json_char)0xA2);
+	   text += JSON_TEXT('\"');
+	   assertEquals(JSONScan::FindQuoteOrBackslash(text.data(), text.data() + text.length()) - text.data(), 40);
+	   assertEquals(JSONScan::SkipSpaces(text.data(), text.data() + text.length()) - text.data(), 0);
+    }
+    #ifndef JSON_LIBRARY
+	   json_string description(JSON_TEXT("[\""));
+	   for (int i = 0; i < 50; ++i) description += JSON_TEXT("A rather long profile description \\\"quoted\\\" \\\\ ");
+	   description += JSON_TEXT("\",\n\n                                          true]");
+	   JSONNode node = libJSON::parse(description);
+	   assertEquals(node.size(), 2);
+	   json_string expected;
+	   for (int i = 0; i < 50; ++i) expected += JSON_TEXT("A rather long profile description \"quoted\" \\ ");
+	   assertEquals(node[0], expected);
+	   assertEquals(node[1], true);
+    #endif
+}
+
+void TestSuite::TestScan(void){
+    const JSONScan::Kernel original = JSONScan::kernel();
+
+    UnitTest::SetPrefix("Scan Scalar");
+    assertTrue(JSONScan::setKernel(JSONScan::Scalar));
+    TestKernel();
+
+    UnitTest::SetPrefix("Scan SSE2");
+    if (JSONScan::setKernel(JSONScan::SSE2)) TestKernel();
+
+    UnitTest::SetPrefix("Scan AVX2");
+    if (JSONScan::setKernel(JSONScan::AVX2)) TestKernel();
+
+    assertTrue(JSONScan::setKernel(original));
+}
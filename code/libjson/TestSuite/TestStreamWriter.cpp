@@ -0,0 +1,82 @@
+#include "TestSuite.h"
+
+#ifdef JSON_WRITER
+void TestSuite::TestStreamWriter(void){
+    #ifndef JSON_LIBRARY
+	   UnitTest::SetPrefix("Stream Writer");
+	   {
+		  JSONStreamWriter out;
+		  assertEquals(out.str(), JSON_TEXT(""));
+		  out.start_node().end_node();
+		  assertEquals(out.str(), JSON_TEXT("{}"));
+		  out.clear();
+		  out.start_array().end_array();
+		  assertEquals(out.str(), JSON_TEXT("[]"));
+
+		  out.clear();
+		  out.raw(JSON_TEXT("MSG "), 4).start_node();
+		  out.key(JSON_TEXT("channel")).string(JSON_TEXT("Frontpage"));
+		  out.key(JSON_TEXT("message")).string(json_string(JSON_TEXT("hello")));
+		  out.end_node();
+		  assertEquals(out.str(), JSON_TEXT("MSG {\"channel\":\"Frontpage\",\"message\":\"hello\"}"));
+
+		  out.clear();
+		  out.start_node();
+		  out.key(JSON_TEXT("a")).start_array().number(1).number(-25L).number(0).end_array();
+		  out.key(JSON_TEXT("b")).start_node().key(JSON_TEXT("c")).boolean(true).key(JSON_TEXT("d")).boolean(false).end_node();
+		  out.key(JSON_TEXT("e")).null();
+		  out.key(JSON_TEXT("f")).number((json_number)1.5);
+		  out.end_node();
+		  assertEquals(out.str(), JSON_TEXT("{\"a\":[1,-25,0],\"b\":{\"c\":true,\"d\":false},\"e\":null,\"f\":1.5}"));
+		  JSONNode parsed = libJSON::parse(out.str());
+		  assertEquals(parsed[JSON_TEXT("a")][1], -25);
+		  assertEquals(parsed[JSON_TEXT("b")][JSON_TEXT("c")], true);
+		  assertEquals(parsed[JSON_TEXT("f")], 1.5);
+	   }
+
+	   UnitTest::SetPrefix("Stream Writer Escapes");
+	   {
+		  JSONStreamWriter out;
+		  out.start_array().string(JSON_TEXT("say \"hi\"\\ 'there'/\t\n\r\b\f\x01")).end_array();
+		  assertEquals(out.str(), JSON_TEXT("[\"say \\\"hi\\\"\\\\ 'there'/\\t\\n\\r\\b\\f\\u0001\"]"));
+		  JSONNode parsed = libJSON::parse(out.str());
+		  assertEquals(parsed[0], JSON_TEXT("say \"hi\"\\ 'there'/\t\n\r\b\f\x01"));
+
+		  out.clear();
+		  out.start_node().key(JSON_TEXT("a\"b")).string(JSON_TEXT("")).end_node();
+		  assertEquals(out.str(), JSON_TEXT("{\"a\\\"b\":\"\"}"));
+	   }
+
+	   #ifndef JSON_UNICODE
+		  UnitTest::SetPrefix("Stream Writer UTF-16");
+		  {
+			 //a, e acute, euro sign, a smiley that takes a surrogate pair, a lone surrogate, a quote
+			 const unsigned short text[] = { 0x61, 0xE9, 0x20AC, 0xD83D, 0xDE00, 0xDC00, 0x22 };
+			 JSONStreamWriter out;
+			 out.start_array().string(text, 7).string(text, 0).end_array();
+			 assertEquals(out.str(), JSON_TEXT("[\"a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xEF\xBF\xBD\\\"\",\"\"]"));
+		  }
+	   #endif
+
+	   UnitTest::SetPrefix("Stream Writer Reuse");
+	   {
+		  //once the buffer is big enough, writing the same thing again doesn't need more memory
+		  JSONStreamWriter out;
+		  out.start_node().key(JSON_TEXT("recipient")).string(JSON_TEXT("Viona")).key(JSON_TEXT("message")).string(JSON_TEXT("a fairly long private message")).end_node();
+		  const json_string first = out.str();
+		  const json_char * buffer = out.data();
+		  out.clear();
+		  assertEquals(out.length(), 0);
+		  out.start_node().key(JSON_TEXT("recipient")).string(JSON_TEXT("Viona")).key(JSON_TEXT("message")).string(JSON_TEXT("a fairly long private message")).end_node();
+		  assertEquals(out.str(), first);
+		  assertEquals(out.data(), buffer);
+
+		  //and it writes the same json as building the nodes does
+		  JSONNode node(JSON_NODE);
+		  node.push_back(JSONNode(JSON_TEXT("recipient"), JSON_TEXT("Viona")));
+		  node.push_back(JSONNode(JSON_TEXT("message"), JSON_TEXT("a fairly long private message")));
+		  assertEquals(out.str(), node.write());
+	   }
+    #endif
+}
+#endif
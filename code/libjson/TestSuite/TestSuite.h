@@ -60,8 +60,14 @@ public:
     static void TestIterators(void);
     static void TestInspectors(void);
     static void TestNamespace(void);
+    static void TestSax(void);
+    static void TestScan(void);
+#ifdef JSON_MEMORY_CALLBACKS
+    static void TestArena(void);
+#endif
 #ifdef JSON_WRITER
     static void TestWriter(void);
+    static void TestStreamWriter(void);
 #endif
 #ifdef JSON_COMMENTS
     static void TestComments(void);
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstdlib> //for malloc, realloc, and free
+#include <atomic>
 #include "TestSuite.h"
 #include "../libJSON.h"
 
@@ -18,8 +19,14 @@ void DoTests(void){
     TestSuite::TestIterators();
     TestSuite::TestInspectors();
     TestSuite::TestNamespace();
+    TestSuite::TestSax();
+    TestSuite::TestScan();
+    #ifdef JSON_MEMORY_CALLBACKS
+	   TestSuite::TestArena();
+    #endif
     #ifdef JSON_WRITER
 	   TestSuite::TestWriter();
+	   TestSuite::TestStreamWriter();
     #endif
     #ifdef JSON_COMMENTS
 	   TestSuite::TestComments();
@@ -32,8 +39,13 @@ void DoTests(void){
 }
 
 #ifdef JSON_MEMORY_CALLBACKS
-    int mallocs = 0;
-    int frees = 0;
+    #ifdef JSON_ATOMIC_REF_COUNT
+	   std::atomic<int> mallocs(0);
+	   std::atomic<int> frees(0);
+    #else
+	   int mallocs = 0;
+	   int frees = 0;
+    #endif
     #ifdef JSON_LIBRARY
 	   void * testmal(unsigned long siz){ ++mallocs; return malloc(siz); }
 	   void * testreal(void * ptr, unsigned long siz){ return realloc(ptr, siz); }
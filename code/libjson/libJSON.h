@@ -148,12 +148,36 @@
     #endif
     #include "Source/JSONNode.h"  //not used in this file, but libJSON.h should be the only file required to use it embedded
     #include "Source/JSONWorker.h"
+    #include "Source/JSONSax.h"
+    #include "Source/JSONStreamWriter.h"
+    #include "Source/NumberToString.h"
     #include <stdexcept>  //some methods throw exceptions
 
     namespace libJSON {
-	   //if json is invalid, it throws a std::invalid_argument exception
-	   inline static JSONNode parse(const json_string & json){
-		  return JSONWorker::parse(json);
+	   //if json is invalid, it throws a std::invalid_argument exception, policy is some of the JSON_PARSE_ flags
+	   inline static JSONNode parse(const json_string & json, json_parse_policy policy = JSON_PARSE_LAZY){
+		  return JSONWorker::parse(json, policy);
+	   }
+
+	   //same as above, but parses [json, json + length) in place, so a frame that is already in memory doesn't need copying into a json_string first
+	   inline static JSONNode parse(const json_char * json, size_t length, json_parse_policy policy = JSON_PARSE_LAZY){
+		  return JSONWorker::parse(json, length, policy);
+	   }
+
+	   //so that parse(JSON_TEXT("..."), policy) doesn't take the policy for a length
+	   inline static JSONNode parse(const json_char * json, json_parse_policy policy){
+		  return JSONWorker::parse(json, json_strlen(json), policy);
+	   }
+	   
+	   //reads [text, text + length) as a json integer without making a string of it, returns false if it isn't one or doesn't fit
+	   inline static bool parse_int(const json_char * text, size_t length, json_int_t & value){
+		  return NumberToString::_atoi(text, text + length, value);
+	   }
+	   
+	   //reads [json, json + length) once and hands each piece to the handler instead of building nodes
+	   //if json is invalid, it throws a std::invalid_argument exception, returns false if the handler stopped it early
+	   inline static bool parse_sax(const json_char * json, size_t length, JSONSaxHandler & handler){
+		  return JSONSax::parse(json, length, handler);
 	   }
 	   
 	   //useful if you have json that you don't want to parse, just want to strip to cut down on space
@@ -0,0 +1,335 @@
+#include "flist_mockserver.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <QHostAddress>
+
+#include <QtWebSockets/QWebSocket>
+#include <QtWebSockets/QWebSocketServer>
+
+#include "../libjson/libJSON.h"
+
+namespace {
+	const char *genders[] = {"Male", "Female", "Transgender", "Herm", "Shemale", "Male-Herm", "Cunt-boy", "None"};
+	const char *statuses[] = {"online", "looking", "busy", "idle", "away", "dnd"};
+	const int floodinterval = 10; //< Milliseconds between flood ticks.
+
+	JSONNode makeArray(const char *name) {
+		JSONNode array(JSON_ARRAY);
+		array.set_name(name);
+		return array;
+	}
+}
+
+FMockServer::FMockServer(const FMockServerConfig &config, QObject *parent) :
+	QObject(parent),
+	config(config),
+	server(new QWebSocketServer("F-Chat mock server", QWebSocketServer::NonSecureMode, this)),
+	clients(),
+	floodtimer(),
+	floodbacklog(0.0),
+	floodcounter(0)
+{
+	connect(server, &QWebSocketServer::newConnection, this, &FMockServer::newConnection);
+	connect(&floodtimer, &QTimer::timeout, this, &FMockServer::flood);
+	if(config.floodrate > 0 && !config.floodcommands.isEmpty()) {
+		floodtimer.start(floodinterval);
+	}
+}
+
+FMockServer::~FMockServer()
+{
+	server->close();
+	qDeleteAll(clients.keys());
+}
+
+bool FMockServer::listen()
+{
+	if(!server->listen(QHostAddress::Any, config.port)) {
+		std::cerr << "Could not listen on port " << config.port << ": " << server->errorString().toStdString() << std::endl;
+		return false;
+	}
+	std::cout << "Listening on ws://localhost:" << config.port << "/ with " << config.characters << " characters online." << std::endl;
+	return true;
+}
+
+QString FMockServer::characterName(int index)
+{
+	return QString("Mock Character %1").arg(index);
+}
+
+QString FMockServer::channelName(int index)
+{
+	return QString("Mock Channel %1").arg(index);
+}
+
+void FMockServer::send(QWebSocket *socket, const char *command, JSONNode &nodes)
+{
+	socket->sendTextMessage(QString::fromStdString(command + (" " + nodes.write())));
+}
+
+void FMockServer::newConnection()
+{
+	while(server->hasPendingConnections()) {
+		QWebSocket *socket = server->nextPendingConnection();
+		connect(socket, &QWebSocket::textMessageReceived, this, &FMockServer::clientMessage);
+		connect(socket, &QWebSocket::disconnected, this, &FMockServer::clientDisconnected);
+		clients.insert(socket, FMockClient());
+	}
+}
+
+void FMockServer::clientDisconnected()
+{
+	QWebSocket *socket = qobject_cast<QWebSocket *>(sender());
+	if(!socket) {
+		return;
+	}
+	if(clients.contains(socket)) {
+		std::cout << "Disconnected: " << clients[socket].character.toStdString() << std::endl;
+	}
+	clients.remove(socket);
+	socket->deleteLater();
+}
+
+void FMockServer::clientMessage(const QString &message)
+{
+	QWebSocket *socket = qobject_cast<QWebSocket *>(sender());
+	if(!socket || !clients.contains(socket)) {
+		return;
+	}
+	FMockClient &client = clients[socket];
+	QByteArray packet = message.toUtf8();
+	QByteArray command = packet.left(3);
+	JSONNode nodes;
+	if(packet.length() > 4) {
+		try {
+			nodes = libJSON::parse(packet.constData() + 4, packet.length() - 4);
+		} catch(std::invalid_argument) {
+			std::cerr << "Client sent invalid JSON: " << packet.constData() << std::endl;
+			return;
+		}
+	}
+	try {
+		if(command == "IDN") {
+			login(socket, client, nodes);
+		} else if(!client.identified) {
+			std::cerr << "Client sent " << command.constData() << " before identifying." << std::endl;
+		} else if(command == "JCH") {
+			joinChannel(socket, client, nodes);
+		} else if(command == "LCH") {
+			QString channelname = QString::fromStdString(nodes.at("channel").as_string());
+			JSONNode reply;
+			reply.push_back(JSONNode("channel", channelname.toStdString()));
+			reply.push_back(JSONNode("character", client.character.toStdString()));
+			send(socket, "LCH", reply);
+			client.channels.remove(channelname);
+		} else if(command == "CHA") {
+			sendChannelList(socket);
+		} else if(command == "ORS") {
+			JSONNode reply;
+			reply.push_back(makeArray("channels"));
+			send(socket, "ORS", reply);
+		}
+		//Anything else, including PIN and the client's own messages, needs no reply.
+	} catch(std::out_of_range) {
+		std::cerr << "Client sent a command without a field we expected: " << packet.constData() << std::endl;
+	}
+}
+
+/**
+Log the client in, then send everything the real server sends on login. That includes the whole
+online character list, split into LIS blocks.
+ */
+void FMockServer::login(QWebSocket *socket, FMockClient &client, JSONNode &nodes)
+{
+	client.character = QString::fromStdString(nodes.at("character").as_string());
+	client.identified = true;
+	std::cout << "Logged in: " << client.character.toStdString() << std::endl;
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("character", client.character.toStdString()));
+		send(socket, "IDN", reply);
+	}
+	const char *variables[][2] = {{"chat_max", "4096"}, {"priv_max", "50000"}, {"lfrp_max", "50000"}, {"lfrp_flood", "600"}, {"msg_flood", "0.5"}, {"permissions", "0"}};
+	for(unsigned int i = 0; i < sizeof(variables) / sizeof(variables[0]); i++) {
+		JSONNode reply;
+		reply.push_back(JSONNode("variable", variables[i][0]));
+		reply.push_back(JSONNode("value", variables[i][1]));
+		send(socket, "VAR", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("message", "Welcome to the F-Chat mock server."));
+		send(socket, "HLO", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("count", config.characters + clients.count()));
+		send(socket, "CON", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(makeArray("characters"));
+		send(socket, "FRL", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("action", "init"));
+		reply.push_back(makeArray("characters"));
+		send(socket, "IGN", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(makeArray("ops"));
+		send(socket, "ADL", reply);
+	}
+	int blocksize = qMax(1, config.lisblocksize);
+	for(int start = 0; start < config.characters; start += blocksize) {
+		JSONNode characters = makeArray("characters");
+		int end = qMin(start + blocksize, config.characters);
+		characters.reserve(end - start);
+		for(int i = start; i < end; i++) {
+			JSONNode character(JSON_ARRAY);
+			character.push_back(JSONNode("", characterName(i).toStdString()));
+			character.push_back(JSONNode("", genders[i % (sizeof(genders) / sizeof(genders[0]))]));
+			character.push_back(JSONNode("", statuses[i % (sizeof(statuses) / sizeof(statuses[0]))]));
+			character.push_back(JSONNode("", i % 3 ? "" : "Status message."));
+			characters.push_back(character);
+		}
+		JSONNode reply;
+		reply.push_back(characters);
+		send(socket, "LIS", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("identity", client.character.toStdString()));
+		reply.push_back(JSONNode("gender", "None"));
+		reply.push_back(JSONNode("status", "online"));
+		send(socket, "NLN", reply);
+	}
+}
+
+/**
+Put the client in a channel with the configured number of members. The members are always the
+first characters in the online list.
+ */
+void FMockServer::joinChannel(QWebSocket *socket, FMockClient &client, JSONNode &nodes)
+{
+	std::string channelname = nodes.at("channel").as_string();
+	client.channels.insert(QString::fromStdString(channelname));
+	int members = qMin(config.channelmembers, config.characters);
+	{
+		JSONNode users = makeArray("users");
+		users.reserve(members + 1);
+		for(int i = 0; i < members; i++) {
+			JSONNode user;
+			user.push_back(JSONNode("identity", characterName(i).toStdString()));
+			users.push_back(user);
+		}
+		JSONNode self;
+		self.push_back(JSONNode("identity", client.character.toStdString()));
+		users.push_back(self);
+		JSONNode reply;
+		reply.push_back(users);
+		reply.push_back(JSONNode("channel", channelname));
+		reply.push_back(JSONNode("mode", "both"));
+		send(socket, "ICH", reply);
+	}
+	{
+		JSONNode oplist = makeArray("oplist");
+		if(members > 0) {
+			oplist.push_back(JSONNode("", characterName(0).toStdString()));
+		}
+		JSONNode reply;
+		reply.push_back(JSONNode("channel", channelname));
+		reply.push_back(oplist);
+		send(socket, "COL", reply);
+	}
+	{
+		JSONNode character;
+		character.set_name("character");
+		character.push_back(JSONNode("identity", client.character.toStdString()));
+		JSONNode reply;
+		reply.push_back(character);
+		reply.push_back(JSONNode("channel", channelname));
+		reply.push_back(JSONNode("title", channelname));
+		send(socket, "JCH", reply);
+	}
+	{
+		JSONNode reply;
+		reply.push_back(JSONNode("channel", channelname));
+		reply.push_back(JSONNode("description", "A channel on the mock server."));
+		send(socket, "CDS", reply);
+	}
+}
+
+void FMockServer::sendChannelList(QWebSocket *socket)
+{
+	JSONNode channels = makeArray("channels");
+	channels.reserve(config.channels);
+	for(int i = 0; i < config.channels; i++) {
+		JSONNode channel;
+		channel.push_back(JSONNode("name", channelName(i).toStdString()));
+		channel.push_back(JSONNode("mode", "both"));
+		channel.push_back(JSONNode("characters", qMin(config.channelmembers, config.characters)));
+		channels.push_back(channel);
+	}
+	JSONNode reply;
+	reply.push_back(channels);
+	send(socket, "CHA", reply);
+}
+
+void FMockServer::flood()
+{
+	floodbacklog += config.floodrate * floodinterval / 1000.0;
+	int count = (int)floodbacklog;
+	floodbacklog -= count;
+	for(int i = 0; i < count; i++) {
+		for(QHash<QWebSocket *, FMockClient>::iterator iter = clients.begin(); iter != clients.end(); ++iter) {
+			if(iter->identified) {
+				floodClient(iter.key(), *iter);
+			}
+		}
+		floodcounter++;
+	}
+}
+
+/**
+Send the client the next frame of the flood. Messages come from channel members, in channels the
+client has joined. Status changes toggle characters outside the channels offline and back, so that
+channel membership never changes under the messages.
+ */
+void FMockServer::floodClient(QWebSocket *socket, FMockClient &client)
+{
+	const QString &command = config.floodcommands.at(floodcounter % config.floodcommands.count());
+	int members = qMin(config.channelmembers, config.characters);
+	if(command == "MSG" || command == "LRP") {
+		if(client.channels.isEmpty() || members == 0) {
+			return;
+		}
+		QList<QString> channels = client.channels.values();
+		JSONNode reply;
+		reply.push_back(JSONNode("channel", channels.at(floodcounter % channels.count()).toStdString()));
+		reply.push_back(JSONNode("character", characterName(floodcounter % members).toStdString()));
+		reply.push_back(JSONNode("message", QString("Mock message %1, with a little [b]BBCode[/b] in it.").arg(floodcounter).toStdString()));
+		send(socket, command == "MSG" ? "MSG" : "LRP", reply);
+	} else if(command == "NLN" || command == "FLN") {
+		if(config.characters == 0) {
+			return;
+		}
+		int index = config.characters > members ? members + floodcounter % (config.characters - members) : floodcounter % config.characters;
+		JSONNode reply;
+		if(client.offlinecharacters.contains(index)) {
+			reply.push_back(JSONNode("identity", characterName(index).toStdString()));
+			reply.push_back(JSONNode("gender", genders[index % (sizeof(genders) / sizeof(genders[0]))]));
+			reply.push_back(JSONNode("status", "online"));
+			send(socket, "NLN", reply);
+			client.offlinecharacters.remove(index);
+		} else {
+			reply.push_back(JSONNode("character", characterName(index).toStdString()));
+			send(socket, "FLN", reply);
+			client.offlinecharacters.insert(index);
+		}
+	}
+}
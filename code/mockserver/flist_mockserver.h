@@ -0,0 +1,93 @@
+#ifndef FLIST_MOCKSERVER_H
+#define FLIST_MOCKSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QHash>
+#include <QTimer>
+
+class QWebSocket;
+class QWebSocketServer;
+class JSONNode;
+
+/**
+Settings for the fake population and traffic of an FMockServer.
+ */
+class FMockServerConfig
+{
+public:
+	FMockServerConfig() :
+		port(9799),
+		characters(50000),
+		lisblocksize(100),
+		channelmembers(2000),
+		channels(20),
+		floodrate(0),
+		floodcommands()
+	{}
+
+	quint16 port;
+	int characters; //< How many characters are online, not counting the clients.
+	int lisblocksize; //< How many characters to send in each LIS frame.
+	int channelmembers; //< How many characters are in each channel a client joins.
+	int channels; //< How many public channels are listed in CHA.
+	int floodrate; //< Frames per second sent to each client once it's logged in, 0 for none.
+	QStringList floodcommands; //< Which of MSG, LRP, NLN and FLN make up the flood.
+};
+
+/**
+A client connected to the mock server.
+ */
+class FMockClient
+{
+public:
+	FMockClient() : character(), channels(), offlinecharacters(), identified(false) {}
+
+	QString character;
+	QSet<QString> channels; //< Channels the client has joined.
+	QSet<int> offlinecharacters; //< Characters that the flood has taken offline and not yet brought back.
+	bool identified;
+};
+
+/**
+Speaks enough of the F-Chat protocol to log a client in, fill it with a configurable number of
+characters and channel members, then flood it with messages and status changes at a fixed rate.
+Everything it sends is deterministic, so runs can be compared with each other.
+ */
+class FMockServer : public QObject
+{
+Q_OBJECT
+public:
+	explicit FMockServer(const FMockServerConfig &config, QObject *parent = 0);
+	~FMockServer();
+
+	bool listen();
+
+private slots:
+	void newConnection();
+	void clientDisconnected();
+	void clientMessage(const QString &message);
+	void flood();
+
+private:
+	void send(QWebSocket *socket, const char *command, JSONNode &nodes);
+	QString characterName(int index);
+	QString channelName(int index);
+
+	void login(QWebSocket *socket, FMockClient &client, JSONNode &nodes);
+	void joinChannel(QWebSocket *socket, FMockClient &client, JSONNode &nodes);
+	void sendChannelList(QWebSocket *socket);
+	void floodClient(QWebSocket *socket, FMockClient &client);
+
+	FMockServerConfig config;
+	QWebSocketServer *server;
+	QHash<QWebSocket *, FMockClient> clients;
+	QTimer floodtimer;
+	double floodbacklog; //< Frames per client that are due but haven't been sent yet.
+	quint64 floodcounter; //< Number of flood ticks so far, used to pick the next command, character and channel.
+};
+
+#endif // FLIST_MOCKSERVER_H
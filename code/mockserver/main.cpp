@@ -0,0 +1,50 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+
+#include "flist_mockserver.h"
+
+/*
+Point the client at the mock server by setting chat_server in the [Global] section of settings.ini to
+ws://localhost:9799/ (or whichever port is used). The client still fetches a login ticket from F-List
+before connecting, the mock server accepts any ticket.
+ */
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("flist-mockserver");
+
+	FMockServerConfig config;
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Stand-in F-Chat server for load and latency testing.");
+	parser.addHelpOption();
+	QCommandLineOption portoption("port", "Port to listen on.", "port", QString::number(config.port));
+	QCommandLineOption charactersoption("characters", "Number of characters online.", "count", QString::number(config.characters));
+	QCommandLineOption lisoption("lis-block", "Characters per LIS frame.", "count", QString::number(config.lisblocksize));
+	QCommandLineOption membersoption("members", "Members in each channel the client joins.", "count", QString::number(config.channelmembers));
+	QCommandLineOption channelsoption("channels", "Public channels listed in CHA.", "count", QString::number(config.channels));
+	QCommandLineOption rateoption("rate", "Flood frames per second, per client.", "rate", QString::number(config.floodrate));
+	QCommandLineOption floodoption("flood", "Comma separated commands that make up the flood, from MSG, LRP, NLN and FLN.", "commands", "MSG,LRP,NLN,FLN");
+	parser.addOption(portoption);
+	parser.addOption(charactersoption);
+	parser.addOption(lisoption);
+	parser.addOption(membersoption);
+	parser.addOption(channelsoption);
+	parser.addOption(rateoption);
+	parser.addOption(floodoption);
+	parser.process(app);
+
+	config.port = parser.value(portoption).toUShort();
+	config.characters = parser.value(charactersoption).toInt();
+	config.lisblocksize = parser.value(lisoption).toInt();
+	config.channelmembers = parser.value(membersoption).toInt();
+	config.channels = parser.value(channelsoption).toInt();
+	config.floodrate = parser.value(rateoption).toInt();
+	config.floodcommands = parser.value(floodoption).toUpper().split(',', QString::SkipEmptyParts);
+
+	FMockServer server(config);
+	if(!server.listen()) {
+		return 1;
+	}
+	return app.exec();
+}
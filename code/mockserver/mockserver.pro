@@ -0,0 +1,38 @@
+######################################################################
+# Stand-in F-Chat server for load and latency testing of the client.
+######################################################################
+
+CONFIG += qt warn_on console c++11
+CONFIG -= app_bundle
+
+QT += core websockets
+QT -= gui
+
+TEMPLATE = app
+TARGET = flist-mockserver
+
+DEPENDPATH += . \
+              ../libjson/Source
+INCLUDEPATH += \
+    . \
+    ../libjson/ \
+    ../libjson/Source
+
+HEADERS += \
+           flist_mockserver.h \
+           ../libjson/libJSON.h
+
+SOURCES += \
+           main.cpp \
+           flist_mockserver.cpp \
+           ../libjson/Source/JSONNode.cpp \
+           ../libjson/Source/internalJSONNode.cpp \
+           ../libjson/Source/JSONDebug.cpp \
+           ../libjson/Source/JSONChildren.cpp \
+           ../libjson/Source/JSONMemory.cpp \
+           ../libjson/Source/JSON_Base64.cpp \
+           ../libjson/Source/JSONWorker.cpp \
+           ../libjson/Source/JSONSax.cpp \
+           ../libjson/Source/JSONScan.cpp \
+           ../libjson/Source/JSONStreamWriter.cpp \
+           ../libjson/Source/JSONWriter.cpp